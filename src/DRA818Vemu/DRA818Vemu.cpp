@@ -0,0 +1,466 @@
+/*
+ * DRA818Vemu
+ * Emulator of the Dorji DRA818V serial protocol on a pseudo-terminal
+ *---------------------------------------------------------------------
+ * Opens a pty and answers the AT+DMOCONNECT, AT+DMOSETGROUP,
+ * AT+DMOSETVOLUME, AT+SETFILTER, AT+SETTAIL, AT+VERSION and RSSI?
+ * commands the way the chip does, with configurable reply latency,
+ * jitter and dropped replies. RSSI (and therefore squelch) follows a
+ * script of signals so the whole control path of picoFM can be
+ * exercised on a plain Linux box without the SV1AFN board.
+ *
+ * The slave pty name is printed on stdout, use it as picoFM -d <port>
+ *---------------------------------------------------------------------
+ * Created by Pedro E. Colla (lu7did@gmail.com)
+ * ---------------------------------------------------------------------
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <signal.h>
+#include <termios.h>
+#include "../picoFM/picoFM.h"
+
+#define  EMUPENDING    32            // replies waiting for their latency to expire
+#define  EMUSIGNALS    64            // signals that can be active in the script
+
+//-------------------- GLOBAL VARIABLES ----------------------------
+const char   *PROGRAMID="DRA818Vemu";
+const char   *PROG_VERSION="1.0";
+const char   *PROG_BUILD="00";
+const char   *COPYRIGHT="(c) LU7DID 2019,2020";
+
+byte  TRACE=0x00;
+bool  running=true;
+
+int   mfd=-1;                        // pty master, the emulated chip side
+int   sfd=-1;                        // pty slave kept open so the link survives client restarts
+char  ptylink[128];
+
+//*--- Emulation parameters
+
+int   latency=50;                    // ms from end of command to reply
+int   jitter=0;                      // +/- ms added at random to the latency
+int   drop=0;                        // percent of replies never sent
+int   noise=45;                      // RSSI reported when no signal is present
+char  version[32]="DRA818V_V4.2";
+char  sqlfile[128];
+
+//*--- Chip state
+
+bool  connected=false;
+int   gbw=0;
+long  rfw=0;                         // Hz
+long  tfw=0;
+int   rxctcss=0;
+int   txctcss=0;
+int   sql=1;
+int   vol=5;
+bool  sqlopen=false;
+
+//*--- Pending replies
+
+struct reply
+{
+        long long at;                // usec when the reply is due
+        char      text[64];
+};
+struct reply pending[EMUPENDING];
+int   pHead=0;
+int   pTail=0;
+
+//*--- Script of signals, from time t (ms) a carrier of RSSI r is present at f (Hz, 0 means any)
+
+struct signal_t
+{
+        long      t;
+        long      f;
+        int       rssi;
+};
+struct signal_t script[1024];
+int   nscript=0;
+int   pscript=0;
+bool  loopscript=false;
+struct signal_t active[EMUSIGNALS];
+int   nactive=0;
+
+//*--- Statistics
+
+unsigned long commands=0;
+unsigned long replies=0;
+unsigned long dropped=0;
+unsigned long errors=0;
+
+long long t0=0;
+
+//*--------------------------------------------------------------------------------------------------
+//* usec  monotonic clock in microseconds
+//*--------------------------------------------------------------------------------------------------
+long long usec() {
+struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (long long)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
+//*--------------------------------------------------------------------------------------------------
+//* sighandler
+//*--------------------------------------------------------------------------------------------------
+static void sighandler(int signum) {
+    running=false;
+}
+//*--------------------------------------------------------------------------------------------------
+//* toHz  parse a frequency in MHz (i.e. 147.1200) into Hz without going thru floating point
+//*--------------------------------------------------------------------------------------------------
+long toHz(const char* s) {
+
+long  v=0;
+long  m=1000000;
+bool  frac=false;
+    for (const char* p=s;*p!=0x00 && *p!=',';p++) {
+        if (*p=='.') {frac=true; continue;}
+        if (*p<'0' || *p>'9') return -1;
+        if (frac==false) {
+           v=v*10+(*p-'0');
+        } else {
+           m=m/10;
+           v=v*10+(*p-'0');
+        }
+    }
+    return (frac==true ? v*m : v*1000000);
+}
+//*--------------------------------------------------------------------------------------------------
+//* loadScript  read the signal script, each line is "time_ms freq_MHz rssi"
+//*--------------------------------------------------------------------------------------------------
+int loadScript(char* name) {
+
+FILE* f=fopen(name,"r");
+char  line[128];
+char  freq[32];
+    if (f==NULL) {
+       fprintf(stderr,"%s:loadScript() unable to open script(%s)\n",PROGRAMID,name);
+       return -1;
+    }
+    while (fgets(line,sizeof(line),f)!=NULL && nscript<(int)sizearray(script)) {
+        if (line[0]=='#' || line[0]=='\n') continue;
+        if (sscanf(line,"%ld %31s %d",&script[nscript].t,freq,&script[nscript].rssi)!=3) continue;
+        script[nscript].f=(strcmp(freq,"*")==0 ? 0 : toHz(freq));
+        nscript++;
+    }
+    fclose(f);
+    (TRACE>=0x01 ? fprintf(stderr,"%s:loadScript() %d signal changes loaded from %s\n",PROGRAMID,nscript,name) : _NOP);
+    return nscript;
+}
+//*--------------------------------------------------------------------------------------------------
+//* runScript  apply the script entries whose time has come
+//*--------------------------------------------------------------------------------------------------
+void runScript(long ms) {
+
+    if (nscript==0) return;
+    if (pscript>=nscript && loopscript==true && ms>=script[nscript-1].t) {
+       pscript=0;
+       t0=usec();
+       ms=0;
+    }
+    while (pscript<nscript && script[pscript].t<=ms) {
+       struct signal_t* s=&script[pscript++];
+       int k=0;
+       while (k<nactive && active[k].f!=s->f) {k++;}
+       if (k==nactive && nactive<EMUSIGNALS) {nactive++;}
+       if (k<EMUSIGNALS) {active[k]=*s;}
+       (TRACE>=0x02 ? fprintf(stderr,"%s:runScript() t(%ld) f(%ld) RSSI(%d)\n",PROGRAMID,s->t,s->f,s->rssi) : _NOP);
+    }
+}
+//*--------------------------------------------------------------------------------------------------
+//* rssi  signal strength at the current receive frequency
+//*--------------------------------------------------------------------------------------------------
+int rssi() {
+
+int r=noise+(std::rand()%5)-2;
+    for (int i=0;i<nactive;i++) {
+        if ((active[i].f==0 || active[i].f==rfw) && active[i].rssi>r) {
+           r=active[i].rssi;
+        }
+    }
+    return r;
+}
+//*--------------------------------------------------------------------------------------------------
+//* updateSquelch  the squelch opens when the RSSI is above the threshold of the SQL level
+//*--------------------------------------------------------------------------------------------------
+void updateSquelch() {
+
+bool open=(sql==0 || rssi() >= noise+5+sql*8);
+    if (open==sqlopen) return;
+    sqlopen=open;
+    (TRACE>=0x01 ? fprintf(stderr,"%s:updateSquelch() squelch(%s) f(%ld)\n",PROGRAMID,(sqlopen ? "open" : "closed"),rfw) : _NOP);
+    if (strlen(sqlfile)==0) return;
+FILE* f=fopen(sqlfile,"w");
+    if (f==NULL) return;
+    fprintf(f,"%d\n",(sqlopen ? 1 : 0));
+    fclose(f);
+}
+//*--------------------------------------------------------------------------------------------------
+//* reply  schedule an answer after the configured latency (and jitter), or drop it
+//*--------------------------------------------------------------------------------------------------
+void reply(const char* text) {
+
+    if (drop>0 && (std::rand()%100)<drop) {
+       dropped++;
+       (TRACE>=0x02 ? fprintf(stderr,"%s:reply() Reply[%s] dropped\n",PROGRAMID,text) : _NOP);
+       return;
+    }
+    if ((pHead+1)%EMUPENDING==pTail) {
+       dropped++;
+       return;
+    }
+
+long long at=usec()+(long long)latency*1000;
+    if (jitter>0) {
+       at+=(long long)((std::rand()%(2*jitter+1))-jitter)*1000;
+    }
+
+//*--- Replies leave in the order of the commands, a late one holds the next
+
+int  prev=(pHead+EMUPENDING-1)%EMUPENDING;
+    if (pHead!=pTail && pending[prev].at>at) {at=pending[prev].at;}
+
+    pending[pHead].at=at;
+    snprintf(pending[pHead].text,sizeof(pending[pHead].text),"%s\r\n",text);
+    pHead=(pHead+1)%EMUPENDING;
+}
+//*--------------------------------------------------------------------------------------------------
+//* execute  interpret a command line received from the controller
+//*--------------------------------------------------------------------------------------------------
+void execute(char* c) {
+
+char r[64];
+    commands++;
+    (TRACE>=0x02 ? fprintf(stderr,"%s:execute() Command[%s]\n",PROGRAMID,c) : _NOP);
+
+    if (strcmp(c,"AT+DMOCONNECT")==0) {
+       connected=true;
+       reply("+DMOCONNECT:0");
+       return;
+    }
+
+    if (strncmp(c,"AT+DMOSETGROUP=",15)==0) {
+       char t[16],rx[16];
+       int  g,rc,sq,tc;
+       if (sscanf(c+15,"%d,%15[0-9.],%15[0-9.],%d,%d,%d",&g,t,rx,&rc,&sq,&tc)!=6 || g<0 || g>1 || toHz(t)<134000000 || toHz(t)>174000000 || toHz(rx)<134000000 || toHz(rx)>174000000 || sq<0 || sq>8) {
+          errors++;
+          reply("+DMOSETGROUP:1");
+          return;
+       }
+       gbw=g;
+       tfw=toHz(t);
+       rfw=toHz(rx);
+       rxctcss=rc;
+       sql=sq;
+       txctcss=tc;
+       (TRACE>=0x01 ? fprintf(stderr,"%s:execute() GBW(%d) TFW(%ld) RFW(%ld) SQL(%d)\n",PROGRAMID,gbw,tfw,rfw,sql) : _NOP);
+       reply("+DMOSETGROUP:0");
+       return;
+    }
+
+    if (strncmp(c,"AT+DMOSETVOLUME=",16)==0) {
+       int v=atoi(c+16);
+       if (v<1 || v>8) {
+          errors++;
+          reply("+DMOSETVOLUME:1");
+          return;
+       }
+       vol=v;
+       reply("+DMOSETVOLUME:0");
+       return;
+    }
+
+    if (strncmp(c,"AT+SETFILTER=",13)==0) {
+       reply("+DMOSETFILTER:0");
+       return;
+    }
+
+    if (strncmp(c,"AT+SETTAIL=",11)==0) {
+       reply("+DMOSETTAIL:0");
+       return;
+    }
+
+    if (strcmp(c,"AT+VERSION")==0) {
+       snprintf(r,sizeof(r),"+VERSION:%s",version);
+       reply(r);
+       return;
+    }
+
+    if (strcmp(c,"RSSI?")==0) {
+       snprintf(r,sizeof(r),"RSSI=%03d",rssi());
+       reply(r);
+       return;
+    }
+
+    if (strncmp(c,"S+",2)==0) {
+       long f=toHz(c+2);
+       int  s=noise;
+       for (int i=0;i<nactive;i++) {
+           if ((active[i].f==0 || active[i].f==f) && active[i].rssi>s) {s=active[i].rssi;}
+       }
+       reply((s>=noise+5+sql*8 ? "S=0" : "S=1"));
+       return;
+    }
+
+    errors++;
+    (TRACE>=0x00 ? fprintf(stderr,"%s:execute() unknown Command[%s] ignored\n",PROGRAMID,c) : _NOP);
+}
+//*-------------------------------------------------------------------------------------------------
+//* print_usage
+//*-------------------------------------------------------------------------------------------------
+void print_usage(void)
+{
+
+fprintf(stderr,"\n%s version %s build (%s)\n"
+"Usage:\nDRA818Vemu [-l latency ms (default=50)]\n"
+"           [-j jitter +/- ms (default=0)]\n"
+"           [-d dropped replies percent (default=0)]\n"
+"           [-n RSSI noise floor (default=45)]\n"
+"           [-r script of signals, lines of \"time_ms freq_MHz|* rssi\"]\n"
+"           [-o loop the script]\n"
+"           [-q file updated with the squelch status (0/1)]\n"
+"           [-p symbolic link to the pty (i.e. /tmp/ttyDRA)]\n"
+"           [-v version string (default=DRA818V_V4.2)]\n"
+"           [-x Verbose {0..2} default=0}]\n",PROGRAMID,PROG_VERSION,PROG_BUILD);
+
+}
+//*--------------------------------------------------------------------------------------------------
+//* main execution of the program
+//*--------------------------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+int  a;
+char line[128];
+int  n=0;
+
+     fprintf(stderr,"%s Version %s Build(%s) %s\n",PROGRAMID,PROG_VERSION,PROG_BUILD,COPYRIGHT);
+     ptylink[0]=0x00;
+     sqlfile[0]=0x00;
+
+     while((a=getopt(argc, argv, "l:j:d:n:r:q:p:v:x:oh?"))!=-1) {
+        switch(a) {
+          case 'l': latency=atoi(optarg); break;
+          case 'j': jitter=atoi(optarg);  break;
+          case 'd': drop=atoi(optarg);    break;
+          case 'n': noise=atoi(optarg);   break;
+          case 'r': if (loadScript(optarg)<0) {exit(1);} break;
+          case 'o': loopscript=true;      break;
+          case 'q': snprintf(sqlfile,sizeof(sqlfile),"%s",optarg); break;
+          case 'p': snprintf(ptylink,sizeof(ptylink),"%s",optarg); break;
+          case 'v': snprintf(version,sizeof(version),"%s",optarg); break;
+          case 'x': TRACE=atoi(optarg);   break;
+          default:
+               print_usage();
+               exit(1);
+        }
+     }
+     fprintf(stderr,"%s:main() latency(%d ms) jitter(%d ms) dropped(%d%%) noise(%d)\n",PROGRAMID,latency,jitter,drop,noise);
+
+     signal(SIGINT,sighandler);
+     signal(SIGTERM,sighandler);
+     signal(SIGPIPE,SIG_IGN);
+     std::srand(getpid());
+
+//*--- Create the pseudo-terminal, the slave is left raw and open
+
+     mfd=posix_openpt(O_RDWR|O_NOCTTY);
+     if (mfd<0 || grantpt(mfd)<0 || unlockpt(mfd)<0) {
+        fprintf(stderr,"%s:main() unable to create pty: %s\n",PROGRAMID,strerror(errno));
+        exit(16);
+     }
+char* slave=ptsname(mfd);
+     sfd=open(slave,O_RDWR|O_NOCTTY);
+struct termios tty;
+     if (sfd>=0 && tcgetattr(sfd,&tty)==0) {
+        cfmakeraw(&tty);
+        tcsetattr(sfd,TCSANOW,&tty);
+     }
+     fcntl(mfd,F_SETFL,fcntl(mfd,F_GETFL)|O_NONBLOCK);
+
+     if (strlen(ptylink)>0) {
+        unlink(ptylink);
+        if (symlink(slave,ptylink)<0) {
+           fprintf(stderr,"%s:main() unable to link %s to %s: %s\n",PROGRAMID,ptylink,slave,strerror(errno));
+        }
+     }
+     fprintf(stdout,"%s\n",slave);
+     fflush(stdout);
+     fprintf(stderr,"%s:main() emulating DRA818V at %s\n",PROGRAMID,slave);
+
+//*--- Main loop, wait for commands or for the next reply (or script change) to be due
+
+     t0=usec();
+     while (running==true) {
+
+        long long now=usec();
+        int       w=100;
+        if (pHead!=pTail) {
+           long long k=(pending[pTail].at-now)/1000;
+           w=(k<0 ? 0 : (k<w ? (int)k : w));
+        }
+        if (pscript<nscript) {
+           long long k=script[pscript].t-(now-t0)/1000;
+           w=(k<0 ? 0 : (k<w ? (int)k : w));
+        }
+
+        struct pollfd p;
+        p.fd=mfd;
+        p.events=POLLIN;
+        p.revents=0;
+        poll(&p,1,w);
+
+        if ((p.revents & POLLIN) != 0) {
+           char b[128];
+           int  k=read(mfd,b,sizeof(b));
+           for (int i=0;i<k;i++) {
+               if (b[i]=='\r' || b[i]=='\n') {
+                  if (n>0) {
+                     line[n]=0x00;
+                     execute(line);
+                     n=0;
+                  }
+                  continue;
+               }
+               if (n<(int)sizeof(line)-1) {line[n++]=b[i];}
+           }
+        }
+
+        now=usec();
+        runScript((long)((now-t0)/1000));
+        updateSquelch();
+
+        while (pHead!=pTail && pending[pTail].at<=now) {
+           if (write(mfd,pending[pTail].text,strlen(pending[pTail].text))>0) {
+              replies++;
+              (TRACE>=0x02 ? fprintf(stderr,"%s:main() Reply[%.*s]\n",PROGRAMID,(int)strlen(pending[pTail].text)-2,pending[pTail].text) : _NOP);
+           }
+           pTail=(pTail+1)%EMUPENDING;
+        }
+     }
+
+     fprintf(stderr,"%s:main() commands(%lu) replies(%lu) dropped(%lu) errors(%lu)\n",PROGRAMID,commands,replies,dropped,errors);
+     if (strlen(ptylink)>0) {unlink(ptylink);}
+     close(sfd);
+     close(mfd);
+     exit(0);
+}
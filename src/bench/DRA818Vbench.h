@@ -0,0 +1,121 @@
+/*
+ * DRA818Vbench
+ * harness shared by the benchmarks driving DRA818V against the pty emulator
+ *---------------------------------------------------------------------
+ * The system word handlers DRA818V needs from its host program, a
+ * monotonic clock, and the start and release of DRA818Vemu instances
+ * with a DRA818V serviced by an I/O thread on each of them.
+ *---------------------------------------------------------------------
+ * Created by Pedro E. Colla (lu7did@gmail.com)
+ * ---------------------------------------------------------------------
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+#ifndef DRA818Vbench_h
+#define DRA818Vbench_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include "../lib/DRA818V.h"
+
+//*--------------------------------------------------------------------------------------------------
+//* getWord/setWord  system word handlers required by DRA818V
+//*--------------------------------------------------------------------------------------------------
+bool getWord (unsigned char SysWord, unsigned char v) {
+  return SysWord & v;
+}
+void setWord(unsigned char* SysWord,unsigned char v, bool val) {
+  *SysWord = ~v & *SysWord;
+  if (val == true) {
+    *SysWord = *SysWord | v;
+  }
+}
+//*--------------------------------------------------------------------------------------------------
+//* usec  monotonic clock in microseconds
+//*--------------------------------------------------------------------------------------------------
+double usec() {
+struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec*1e6+ts.tv_nsec/1e3;
+}
+//*--------------------------------------------------------------------------------------------------
+//* spawn  start the emulator at a latency (ms, with a signal script if given) and read the name of
+//* its pty into pty, returns its pid or -1
+//*--------------------------------------------------------------------------------------------------
+pid_t spawn(const char* emu,const char* latency,const char* script,char* pty,int len) {
+
+int p[2];
+    if (pipe(p)<0) return -1;
+pid_t pid=fork();
+    if (pid==0) {
+       dup2(p[1],1);
+       int n=open("/dev/null",O_WRONLY);
+       dup2(n,2);
+       close(p[0]);
+       if (script!=NULL) {
+          execl(emu,emu,"-l",latency,"-r",script,(char*)NULL);
+       } else {
+          execl(emu,emu,"-l",latency,(char*)NULL);
+       }
+       _exit(1);
+    }
+    close(p[1]);
+FILE* f=fdopen(p[0],"r");
+    if (f==NULL || fgets(pty,len,f)==NULL) {
+       fprintf(stderr,"%s: unable to start %s\n",program_invocation_short_name,emu);
+       return -1;
+    }
+    pty[strcspn(pty,"\r\n")]=0x00;
+    fclose(f);
+    return pid;
+}
+//*--------------------------------------------------------------------------------------------------
+//* radio  start an emulator and a DRA818V serviced by the I/O thread io, the handshake is under way
+//* when it returns (see ready()); the pid of the emulator goes to pid
+//*--------------------------------------------------------------------------------------------------
+DRA818V* radio(EventLoop* io,const char* emu,const char* latency,const char* script,pid_t* pid) {
+
+char pty[64];
+    *pid=spawn(emu,latency,script,pty,sizeof(pty));
+    if (*pid<0) return NULL;
+DRA818V* r=new DRA818V(NULL,NULL,NULL,NULL);
+    r->TRACE=0x00;
+    r->start(pty);
+    r->attach(io);
+    return r;
+}
+//*--------------------------------------------------------------------------------------------------
+//* ready  wait up to 5 s for the handshake of n radios, false if any did not complete it
+//*--------------------------------------------------------------------------------------------------
+bool ready(DRA818V** r,int n) {
+
+double t0=usec();
+bool   ok=false;
+    while (ok==false && usec()-t0<5e6) {
+       usleep(10000);
+       ok=true;
+       for (int i=0;i<n;i++) {
+           r[i]->processCommand();
+           if (r[i]->hs!=DRA_HS_READY) {ok=false;}
+       }
+    }
+    return ok;
+}
+//*--------------------------------------------------------------------------------------------------
+//* release  stop the radio and its emulator
+//*--------------------------------------------------------------------------------------------------
+void release(DRA818V* r,pid_t pid) {
+    r->stop();
+    delete(r);
+    kill(pid,SIGTERM);
+    waitpid(pid,NULL,0);
+}
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * DRA818Vfreq
+ * benchmark of the work done on every encoder detent to retune the DRA818V
+ *---------------------------------------------------------------------
+ * Compares the float path (MHz as float, %6.2f for the LCD and %3.4f
+ * for the AT+DMOSETGROUP frame) with the integer Hz path (toHz, putMHz
+ * and DRA818V::encode). Both walk the band with the VFO step the way
+ * genVFO does, accumulating the frequency as a float, and also count
+ * the frames that came out off the step raster.
+ *
+ *    ../bin/DRA818Vfreq -n 1000000 -s 5000
+ *---------------------------------------------------------------------
+ * Created by Pedro E. Colla (lu7did@gmail.com)
+ * ---------------------------------------------------------------------
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+#include "DRA818Vbench.h"
+
+#define FLOW    144000000.0
+#define FHIGH   147995000.0
+
+byte  TRACE=0x00;
+
+//*--------------------------------------------------------------------------------------------------
+//* step  next frequency of the walk, as a float the way the VFO keeps it
+//*--------------------------------------------------------------------------------------------------
+float step(float f,float s) {
+    f+=s;
+    if (f>FHIGH) {f=FLOW;}
+    return f;
+}
+//*--------------------------------------------------------------------------------------------------
+//* offRaster  true when the receive frequency of a frame is not a multiple of s Hz
+//*--------------------------------------------------------------------------------------------------
+bool offRaster(const char* frame,long s) {
+
+const char* p=strchr(frame,',');
+    if (p==NULL) return true;
+    p=strchr(p+1,',');
+    if (p==NULL) return true;
+long mhz=atol(p+1);
+const char* q=strchr(p+1,'.');
+    if (q==NULL) return true;
+long hz=mhz*1000000+atol(q+1)*100;
+    return (hz%s)!=0;
+}
+//*--------------------------------------------------------------------------------------------------
+//* main
+//*--------------------------------------------------------------------------------------------------
+int main(int argc,char* argv[]) {
+
+long n=1000000;
+long s=5000;
+int  a;
+
+    while ((a=getopt(argc,argv,"n:s:"))!=-1) {
+       switch(a) {
+         case 'n': n=atol(optarg); break;
+         case 's': s=atol(optarg); break;
+         default:
+              fprintf(stderr,"usage: DRA818Vfreq [-n detents] [-s step Hz]\n");
+              exit(1);
+       }
+    }
+
+char  lcd[2][16];
+char  frame[64];
+long  off=0;
+float f=FLOW;
+
+double tf=0.0;
+double ti=0.0;
+long  offf=0;
+DRA818V* r=new DRA818V(NULL,NULL,NULL,NULL);
+    r->TRACE=0x00;
+    r->setSQL(1);
+
+//*--- pass 0 is timed, pass 1 repeats the walk checking every frame against the raster
+
+    for (int pass=0;pass<2;pass++) {
+
+//*--- float path, as picoFM did it before the frequencies were carried as integer Hz
+
+float rfw,tfw;
+float ofs=600000.0;
+       f=FLOW;
+double t0=usec();
+       for (long i=0;i<n;i++) {
+           f=step(f,(float)s);
+           sprintf(lcd[0],"%6.2f",f/1000000.0);
+           sprintf(lcd[1],"%6.2f",f/1000000.0);
+           rfw=f/1000000.0;
+           tfw=rfw+(ofs/1000000);
+           sprintf(frame,"AT+DMOSETGROUP=%d,%3.4f,%3.4f,%04d,%d,%04d",0,tfw,rfw,0,1,0);
+           if (pass==1 && offRaster(frame,s)) {offf++;}
+       }
+       if (pass==0) {tf=(usec()-t0)/n;}
+
+//*--- integer path, toHz at the genVFO boundary (reseeding the float as tuneVFO() does), then
+//*--- putMHz and encode
+
+       f=FLOW;
+       t0=usec();
+       for (long i=0;i<n;i++) {
+           f=step(f,(float)s);
+           long rx=DRA818V::toHz(f);
+           if (f!=(float)rx) {f=(float)rx;}
+           *DRA818V::putMHz(lcd[0],rx,2)=0x00;
+           *DRA818V::putMHz(lcd[1],rx,2)=0x00;
+           r->setRFW(rx);
+           r->setTFW(rx+600000);
+           r->encode(r->m);
+           if (pass==1 && offRaster(r->dra[r->m].group,s)) {off++;}
+       }
+       if (pass==0) {ti=(usec()-t0)/n;}
+    }
+
+    printf("DRA818Vfreq: %ld detents of %ld Hz, LCD text and AT+DMOSETGROUP frame per detent\n",n,s);
+    printf("%-8s %12s %12s\n","path","ns/detent","off raster");
+    printf("%-8s %12.1f %12ld\n","float",tf*1000.0,offf);
+    printf("%-8s %12.1f %12ld\n","integer",ti*1000.0,off);
+    printf("last frame [%s] [%s]\n",frame,r->dra[r->m].group);
+    delete(r);
+    exit(0);
+}
@@ -0,0 +1,121 @@
+/*
+ * DRA818Vmulti
+ * benchmark of several DRA818V modules multiplexed on one EventLoop
+ *---------------------------------------------------------------------
+ * Starts N instances of DRA818Vemu, drives one DRA818V object against
+ * each pty from a single I/O thread with aggressive RSSI polling and
+ * reports the CPU time spent per reply and per radio, which should stay
+ * flat as N grows.
+ *
+ *    ../bin/DRA818Vmulti -e ../bin/DRA818Vemu -n 8 -t 5 2>/dev/null
+ *---------------------------------------------------------------------
+ * Created by Pedro E. Colla (lu7did@gmail.com)
+ * ---------------------------------------------------------------------
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+#include <sys/resource.h>
+#include "DRA818Vbench.h"
+
+#define MAXEMU  16
+
+byte  TRACE=0x00;
+
+pid_t pid[MAXEMU];
+
+//*--------------------------------------------------------------------------------------------------
+//* cpu  user+system CPU time of the process in microseconds
+//*--------------------------------------------------------------------------------------------------
+double cpu() {
+struct rusage r;
+    getrusage(RUSAGE_SELF,&r);
+    return (r.ru_utime.tv_sec+r.ru_stime.tv_sec)*1e6+r.ru_utime.tv_usec+r.ru_stime.tv_usec;
+}
+//*--------------------------------------------------------------------------------------------------
+//* run  drive n radios polling every poll ms during t seconds
+//*--------------------------------------------------------------------------------------------------
+int run(const char* emu,int n,int t,int poll) {
+
+DRA818V*   r[MAXEMU];
+EventLoop* io=new EventLoop();
+    io->start();
+
+    for (int i=0;i<n;i++) {
+        r[i]=radio(io,emu,"2",NULL,&pid[i]);
+        if (r[i]==NULL) return -1;
+    }
+
+//*--- Wait for every handshake to complete
+
+    if (ready(r,n)==false) {
+       fprintf(stderr,"DRA818Vmulti: not every emulator answered the handshake\n");
+    }
+
+unsigned long rep0=0;
+unsigned long wak0=io->wakeups;
+    for (int i=0;i<n;i++) {
+        rep0+=r[i]->lat[DRA_CMD_RSSI].count;
+        r[i]->setPoll(poll);
+    }
+
+double c0=cpu();
+double t0=usec();
+    while (usec()-t0<t*1e6) {
+       for (int i=0;i<n;i++) {
+           r[i]->processCommand();
+       }
+       usleep(100000);
+    }
+double w=usec()-t0;
+double c=cpu()-c0;
+
+unsigned long rep=0;
+    for (int i=0;i<n;i++) {
+        rep+=r[i]->lat[DRA_CMD_RSSI].count;
+    }
+    rep-=rep0;
+unsigned long wak=io->wakeups-wak0;
+
+    printf("%6d %10.0f %12.2f %12.3f %10.2f\n",n,rep/(w/1e6),(rep>0 ? c/rep : 0.0),100.0*c/w/n,(rep>0 ? (double)wak/rep : 0.0));
+
+    io->stop();
+    for (int i=0;i<n;i++) {
+        release(r[i],pid[i]);
+    }
+    delete(io);
+    return 0;
+}
+//*--------------------------------------------------------------------------------------------------
+//* main
+//*--------------------------------------------------------------------------------------------------
+int main(int argc,char* argv[]) {
+
+const char* emu="../bin/DRA818Vemu";
+int  n=8;
+int  t=5;
+int  poll=20;
+int  a;
+
+    while ((a=getopt(argc,argv,"e:n:t:p:"))!=-1) {
+       switch(a) {
+         case 'e': emu=optarg; break;
+         case 'n': n=atoi(optarg); break;
+         case 't': t=atoi(optarg); break;
+         case 'p': poll=atoi(optarg); break;
+         default:
+              fprintf(stderr,"usage: DRA818Vmulti [-e emulator] [-n max radios] [-t seconds per run] [-p poll ms]\n");
+              exit(1);
+       }
+    }
+    if (n>MAXEMU) {n=MAXEMU;}
+    signal(SIGPIPE,SIG_IGN);
+
+    printf("DRA818Vmulti: RSSI polled every %d ms, %d s per run\n",poll,t);
+    printf("%6s %10s %12s %12s %10s\n","radios","replies/s","cpu us/reply","cpu%/radio","wake/reply");
+    for (int k=1;k<=n;k*=2) {
+        if (run(emu,k,t,poll)<0) exit(1);
+    }
+    exit(0);
+}
@@ -0,0 +1,112 @@
+/*
+ * DRA818Vparse
+ * micro-benchmark of the DRA818V reply framer and parser
+ *---------------------------------------------------------------------
+ * Feeds a stream of typical DRA818V replies through DRA818Vframer and
+ * reports the cost per line, compared with the former strtok/malloc
+ * based parsing of a line.
+ *---------------------------------------------------------------------
+ * Created by Pedro E. Colla (lu7did@gmail.com)
+ * ---------------------------------------------------------------------
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../lib/DRA818Vframer.h"
+
+#define NLINES  2000000
+
+const char* sample[]={"+DMOCONNECT:0\r\n","+DMOSETGROUP:0\r\n","RSSI=104\r\n","+DMOSETVOLUME:0\r\n","+DMOSETFILTER:0\r\n","RSSI=57\r\n","+VERSION:DRA818V_V4.2\r\n","+DMOSETTAIL:0\r\n"};
+
+//*--------------------------------------------------------------------------------------------------
+//* nsec  monotonic clock in nanoseconds
+//*--------------------------------------------------------------------------------------------------
+double nsec() {
+struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec*1e9+ts.tv_nsec;
+}
+//*--------------------------------------------------------------------------------------------------
+//* legacy  parsing of a line as done by DRA818V::parseCommand() before the framer
+//*--------------------------------------------------------------------------------------------------
+int legacy(const char* line) {
+
+char  cmd[128];
+char* token;
+char* p=(char*)malloc(128);
+char* val=(char*)malloc(128);
+int   rc=-1;
+
+    sprintf(cmd,"%s",line);
+    cmd[strcspn(cmd,"\r\n")]=0x00;
+    if (strstr(cmd,"+DMOCONNECT:") != NULL || strstr(cmd,"DMOSETGROUP:") != NULL || strstr(cmd,"DMOSETFILTER:")!=NULL || strstr(cmd,"DMOSETVOLUME:") != NULL || strstr(cmd,"+VERSION")!=NULL || strstr(cmd,"DMOSETTAIL:") != NULL ) {
+       token=strtok(cmd,":");
+       strcpy(p,token);
+       while (token!=NULL) {
+         token=strtok(NULL,":");
+         if (token!=NULL) {strcpy(val,token); rc=atoi(val);}
+       }
+    } else {
+       if (strstr(cmd,"RSSI=")!=NULL) {
+          token=strtok(cmd,"=");
+          strcpy(p,token);
+          while (token!=NULL) {
+            token=strtok(NULL,"=");
+            if (token!=NULL) {strcpy(val,token); rc=(int)atof(val);}
+          }
+       }
+    }
+    free(p);
+    free(val);
+    return rc;
+}
+//*--------------------------------------------------------------------------------------------------
+//* main
+//*--------------------------------------------------------------------------------------------------
+int main(int argc, char* argv[]) {
+
+int  n=sizeof(sample)/sizeof(sample[0]);
+long sum=0;
+
+//*--- Framer, bytes are fed in 16 byte chunks as a serial read would deliver them
+
+char stream[4096];
+int  len=0;
+     while (len<(int)sizeof(stream)-32) {
+         const char* s=sample[(len/7)%n];
+         memcpy(stream+len,s,strlen(s));
+         len+=strlen(s);
+     }
+
+DRA818Vframer framer;
+DRA818V_msg   r;
+long lines=0;
+double t0=nsec();
+     while (lines<NLINES) {
+         for (int i=0;i<len;i+=16) {
+             framer.feed(stream+i,(len-i<16 ? len-i : 16));
+             while (framer.next(&r)==true) {
+                 sum+=r.rc+r.kind;
+                 lines++;
+             }
+         }
+     }
+double t1=nsec();
+     fprintf(stderr,"framer   lines(%ld) malformed(%lu) cost(%6.1f ns/line)\n",lines,framer.malformed,(t1-t0)/lines);
+
+//*--- Legacy parsing
+
+     t0=nsec();
+     for (long i=0;i<NLINES;i++) {
+         sum+=legacy(sample[i%n]);
+     }
+     t1=nsec();
+     fprintf(stderr,"legacy   lines(%d) cost(%6.1f ns/line)\n",NLINES,(t1-t0)/NLINES);
+
+     return (sum==0 ? 1 : 0);
+}
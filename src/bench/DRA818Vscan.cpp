@@ -0,0 +1,155 @@
+/*
+ * DRA818Vscan
+ * benchmark of the DRA818V scanner against the pty emulator
+ *---------------------------------------------------------------------
+ * Sweeps a range of channels with DRA818Vemu answering at a given
+ * latency and reports the scan rate obtained for several dwell times
+ * next to the bound set by the link (one GROUP round trip plus the
+ * longest of the dwell and the RSSI round trip per channel). A last
+ * run places a carrier on one channel and measures how long the scan
+ * takes to stop on it, and to resume once it is gone.
+ *
+ *    ../bin/DRA818Vscan -e ../bin/DRA818Vemu -l 10 -t 3 2>/dev/null
+ *---------------------------------------------------------------------
+ * Created by Pedro E. Colla (lu7did@gmail.com)
+ * ---------------------------------------------------------------------
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+#include "DRA818Vbench.h"
+
+#define BENCHLO  144000000
+#define BENCHHI  147990000
+#define SCANSTEP     10000
+#define CARRIER  146520000
+#define SCRIPT   "/tmp/DRA818Vscan.script"
+
+byte  TRACE=0x00;
+
+pid_t pid=0;
+
+//*--------------------------------------------------------------------------------------------------
+//* setup  start an emulator and a DRA818V on the first channel of the band, wait for the handshake
+//*--------------------------------------------------------------------------------------------------
+DRA818V* setup(EventLoop* io,const char* emu,const char* latency,const char* script) {
+
+DRA818V* r=radio(io,emu,latency,script,&pid);
+    if (r==NULL) return NULL;
+    r->setRFW((long)BENCHLO);
+    r->setTFW((long)BENCHLO);
+    r->setSQL(1);
+    r->sendSetGroup();
+    if (ready(&r,1)==false) {
+       fprintf(stderr,"DRA818Vscan: emulator did not answer the handshake\n");
+       return NULL;
+    }
+    return r;
+}
+//*--------------------------------------------------------------------------------------------------
+//* sweep  scan rate over t seconds with the given dwell on an empty band
+//*--------------------------------------------------------------------------------------------------
+int sweep(EventLoop* io,const char* emu,int latency,int dwell,int t) {
+
+char l[16];
+    snprintf(l,sizeof(l),"%d",latency);
+DRA818V* r=setup(io,emu,l,NULL);
+    if (r==NULL) return -1;
+
+    r->dwell=dwell;
+    r->scanRange(BENCHLO,BENCHHI,SCANSTEP);
+    usleep(500000);                          // let the RSSI round trip estimate settle
+unsigned long n0=r->scanned;
+double t0=usec();
+    while (usec()-t0<t*1e6) {
+       r->processCommand();
+       usleep(100000);
+    }
+double w=(usec()-t0)/1e6;
+unsigned long n=r->scanned-n0;
+    r->stopScan();
+
+double bound=1000.0/(latency+(dwell>latency ? dwell : latency));
+    printf("%8d %8d %10.1f %10.1f %12lu\n",latency,dwell,n/w,bound,r->scanlat.percentile(50.0));
+    release(r,pid);
+    return 0;
+}
+//*--------------------------------------------------------------------------------------------------
+//* stop  carrier on one channel of a 21 channel window from 0.5 s to 3 s, time to stop on it (at
+//* most a sweep of the window) and to resume after the hang
+//*--------------------------------------------------------------------------------------------------
+int stop(EventLoop* io,const char* emu,int latency,int dwell,int hang) {
+
+FILE* f=fopen(SCRIPT,"w");
+    if (f==NULL) return -1;
+    fprintf(f,"500 %ld.%06ld 90\n3000 %ld.%06ld 0\n",(long)CARRIER/1000000,(long)CARRIER%1000000,(long)CARRIER/1000000,(long)CARRIER%1000000);
+    fclose(f);
+
+char l[16];
+    snprintf(l,sizeof(l),"%d",latency);
+DRA818V* r=setup(io,emu,l,SCRIPT);
+    if (r==NULL) return -1;
+
+    r->dwell=dwell;
+    r->hang=hang;
+    r->scanRange(CARRIER-10*SCANSTEP,CARRIER+10*SCANSTEP,SCANSTEP);
+
+double t0=usec();
+double thold=0.0;
+double thang=0.0;
+double tresume=0.0;
+long   fhold=0;
+    while (usec()-t0<6e6 && tresume==0.0) {
+       r->processCommand();
+       if (thold==0.0 && r->scan==DRA_SCAN_HOLD) {thold=usec()-t0; fhold=r->scanFreq();}
+       if (thold!=0.0 && thang==0.0 && r->scan==DRA_SCAN_HANG) {thang=usec()-t0;}
+       if (thang!=0.0 && (r->scan==DRA_SCAN_TUNE || r->scan==DRA_SCAN_DWELL)) {tresume=usec()-t0;}
+       usleep(1000);
+    }
+    r->stopScan();
+
+    printf("carrier at %ld Hz from 500 to 3000 ms, dwell %d ms, hang %d ms\n",(long)CARRIER,dwell,hang);
+    printf("stopped at %ld Hz after %.0f ms, signal gone seen at %.0f ms, resumed at %.0f ms, stops=%lu\n",
+           fhold,thold/1000.0,thang/1000.0,tresume/1000.0,r->scanstops);
+    release(r,pid);
+    unlink(SCRIPT);
+    return 0;
+}
+//*--------------------------------------------------------------------------------------------------
+//* main
+//*--------------------------------------------------------------------------------------------------
+int main(int argc,char* argv[]) {
+
+const char* emu="../bin/DRA818Vemu";
+int  latency=10;
+int  t=3;
+int  a;
+
+    while ((a=getopt(argc,argv,"e:l:t:"))!=-1) {
+       switch(a) {
+         case 'e': emu=optarg; break;
+         case 'l': latency=atoi(optarg); break;
+         case 't': t=atoi(optarg); break;
+         default:
+              fprintf(stderr,"usage: DRA818Vscan [-e emulator] [-l emulator latency ms] [-t seconds per run]\n");
+              exit(1);
+       }
+    }
+    signal(SIGPIPE,SIG_IGN);
+
+EventLoop* io=new EventLoop();
+    io->start();
+
+    printf("DRA818Vscan: %d..%d Hz step %d Hz, %d s per run\n",BENCHLO,BENCHHI,SCANSTEP,t);
+    printf("%8s %8s %10s %10s %12s\n","lat ms","dwell ms","ch/s","bound","us/ch p50");
+const int DWELL[]={0,latency,25,50,100};
+    for (int i=0;i<(int)sizearray(DWELL);i++) {
+        if (sweep(io,emu,latency,DWELL[i],t)<0) exit(1);
+    }
+    if (stop(io,emu,latency,DRADWELL,1000)<0) exit(1);
+
+    io->stop();
+    delete(io);
+    exit(0);
+}
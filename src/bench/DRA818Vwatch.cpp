@@ -0,0 +1,156 @@
+/*
+ * DRA818Vwatch
+ * benchmark of the DRA818V priority watch against the pty emulator
+ *---------------------------------------------------------------------
+ * Watches a priority channel at a fixed interval with DRA818Vemu
+ * answering at several latencies while the channel in use is retuned
+ * every 100 ms and the meter is polled, and reports the revisit time
+ * of the priority channel (the interval it is held to) and the audio
+ * gap on the channel in use per look (ideally a GROUP round trip there,
+ * the dwell or the RSSI round trip, and a GROUP round trip back). A
+ * last run places a carrier on the priority channel and measures how
+ * long the watch takes to hold on it and to come back once it is gone.
+ *
+ *    ../bin/DRA818Vwatch -e ../bin/DRA818Vemu -i 500 -t 5 2>/dev/null
+ *---------------------------------------------------------------------
+ * Created by Pedro E. Colla (lu7did@gmail.com)
+ * ---------------------------------------------------------------------
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+#include "DRA818Vbench.h"
+
+#define MAIN     146520000
+#define PRIO     146940000
+#define SCRIPT   "/tmp/DRA818Vwatch.script"
+
+byte  TRACE=0x00;
+
+pid_t pid=0;
+
+//*--------------------------------------------------------------------------------------------------
+//* setup  start an emulator and a DRA818V with the priority channel in slot 1, wait for the handshake
+//*--------------------------------------------------------------------------------------------------
+DRA818V* setup(EventLoop* io,const char* emu,const char* latency,const char* script) {
+
+DRA818V* r=radio(io,emu,latency,script,&pid);
+    if (r==NULL) return NULL;
+    r->setRFW((long)MAIN);
+    r->setTFW((long)MAIN);
+    r->setSQL(1);
+    r->store(1);
+    r->setRFW(1,(long)PRIO);
+    r->setTFW(1,(long)PRIO);
+    r->sendSetGroup();
+    if (ready(&r,1)==false) {
+       fprintf(stderr,"DRA818Vwatch: emulator did not answer the handshake\n");
+       return NULL;
+    }
+    return r;
+}
+//*--------------------------------------------------------------------------------------------------
+//* watch  revisit time and gap over t seconds looking every interval ms, retuning the channel in
+//* use every 100 ms and polling the meter meanwhile
+//*--------------------------------------------------------------------------------------------------
+int watch(EventLoop* io,const char* emu,int latency,int interval,int t) {
+
+char l[16];
+    snprintf(l,sizeof(l),"%d",latency);
+DRA818V* r=setup(io,emu,l,NULL);
+    if (r==NULL) return -1;
+
+    r->setPoll(DRAPOLLFAST);
+    r->watchStart(1,interval);
+
+double t0=usec();
+int    k=0;
+    while (usec()-t0<t*1e6) {
+       r->processCommand();
+       r->setRFW((long)MAIN+(k++%2)*12500);
+       r->setTFW(r->getRFW());
+       r->sendSetGroup();
+       usleep(100000);
+    }
+    r->watchStop();
+
+int    ideal=2*latency+(latency>DRAPRIODWELL ? latency : DRAPRIODWELL);
+    printf("%6d %6lu %10.1f %10.1f %10.1f %10.1f %10.1f %8d\n",latency,r->looks,
+           r->revisit.percentile(50.0)/1000.0,r->revisit.max/1000.0,
+           r->gap.percentile(50.0)/1000.0,r->gap.percentile(99.0)/1000.0,r->gap.max/1000.0,ideal);
+    release(r,pid);
+    return 0;
+}
+//*--------------------------------------------------------------------------------------------------
+//* hold  carrier on the priority channel from 1 s to 3 s, time to hold on it and to come back
+//*--------------------------------------------------------------------------------------------------
+int hold(EventLoop* io,const char* emu,int latency,int interval,int hang) {
+
+FILE* f=fopen(SCRIPT,"w");
+    if (f==NULL) return -1;
+    fprintf(f,"1000 %ld.%06ld 90\n3000 %ld.%06ld 0\n",(long)PRIO/1000000,(long)PRIO%1000000,(long)PRIO/1000000,(long)PRIO%1000000);
+    fclose(f);
+
+char l[16];
+    snprintf(l,sizeof(l),"%d",latency);
+DRA818V* r=setup(io,emu,l,SCRIPT);
+    if (r==NULL) return -1;
+
+    r->hang=hang;
+    r->watchStart(1,interval);
+
+double t0=usec();
+double thold=0.0;
+double tback=0.0;
+    while (usec()-t0<6e6 && tback==0.0) {
+       r->processCommand();
+       if (thold==0.0 && r->watch==DRA_WATCH_HOLD) {thold=usec()-t0;}
+       if (thold!=0.0 && r->watch==DRA_WATCH_MAIN) {tback=usec()-t0;}
+       usleep(1000);
+    }
+    r->watchStop();
+
+    printf("carrier on the priority channel from 1000 to 3000 ms, looks every %d ms, hang %d ms\n",interval,hang);
+    printf("held after %.0f ms, back on the channel in use at %.0f ms, stops=%lu\n",thold/1000.0,tback/1000.0,r->priostops);
+    release(r,pid);
+    unlink(SCRIPT);
+    return 0;
+}
+//*--------------------------------------------------------------------------------------------------
+//* main
+//*--------------------------------------------------------------------------------------------------
+int main(int argc,char* argv[]) {
+
+const char* emu="../bin/DRA818Vemu";
+int  interval=500;
+int  t=5;
+int  a;
+
+    while ((a=getopt(argc,argv,"e:i:t:"))!=-1) {
+       switch(a) {
+         case 'e': emu=optarg; break;
+         case 'i': interval=atoi(optarg); break;
+         case 't': t=atoi(optarg); break;
+         default:
+              fprintf(stderr,"usage: DRA818Vwatch [-e emulator] [-i look interval ms] [-t seconds per run]\n");
+              exit(1);
+       }
+    }
+    signal(SIGPIPE,SIG_IGN);
+
+EventLoop* io=new EventLoop();
+    io->start();
+
+    printf("DRA818Vwatch: priority %d Hz every %d ms, channel in use retuned every 100 ms, %d s per run\n",PRIO,interval,t);
+    printf("%6s %6s %10s %10s %10s %10s %10s %8s\n","lat ms","looks","revisit50","revisitmax","gap50 ms","gap99 ms","gapmax ms","ideal");
+const int LATENCY[]={5,10,20,50};
+    for (int i=0;i<(int)sizearray(LATENCY);i++) {
+        if (watch(io,emu,LATENCY[i],interval,t)<0) exit(1);
+    }
+    if (hold(io,emu,10,interval,500)<0) exit(1);
+
+    io->stop();
+    delete(io);
+    exit(0);
+}
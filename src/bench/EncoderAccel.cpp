@@ -0,0 +1,109 @@
+/*
+ * EncoderAccel
+ * benchmark of the knob acceleration tuning across the band
+ *---------------------------------------------------------------------
+ * Simulates an operator tuning from one band edge to a channel at the
+ * other one (144.000 to 147.990 MHz at 10 kHz, 399 steps) feeding the
+ * detents with their tick into EncoderAccel. The knob is spun at a
+ * given rate (with some jitter) while the channel is farther than
+ * 300 kHz away, then after a pause to look at the display it is
+ * turned at 4 detents/s to the channel, backing up if it went past.
+ * Reports the detents and the time it takes with the acceleration
+ * off and with the curve given, for several spin rates, and the time
+ * spent crossing the band before the approach; the approach is slow
+ * enough to stay at 1x either way.
+ *
+ *    ../bin/EncoderAccel -c 10,30
+ *---------------------------------------------------------------------
+ * Created by Pedro E. Colla (lu7did@gmail.com)
+ * ---------------------------------------------------------------------
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "../lib/EncoderAccel.h"
+
+#define STEP        10000
+#define FROM    144000000
+#define TO      147990000
+#define NEAR       300000             // Hz from the channel where the operator slows down
+#define SLOW            4             // detents/s of the final approach
+#define PAUSE      400000             // us to look at the display before the approach
+
+unsigned long detents=0;
+unsigned long long t=0;               // us, the tick is its low 32 bits
+unsigned long long tnear=0;           // us when the channel was within NEAR
+
+//*--------------------------------------------------------------------------------------------------
+//* turn  one detent dir at rate detents/s with +/-15% jitter, returns the Hz moved
+//*--------------------------------------------------------------------------------------------------
+long turn(EncoderAccel* a,int dir,float rate) {
+
+    t+=(unsigned long long)(1000000.0/rate*(0.85+0.3*rand()/(float)RAND_MAX));
+    detents++;
+    return (long)dir*STEP*a->step((uint32_t)t,dir);
+}
+//*--------------------------------------------------------------------------------------------------
+//* tune  from FROM to TO spinning at rate, returns the seconds it took
+//*--------------------------------------------------------------------------------------------------
+double tune(EncoderAccel* a,float rate) {
+
+long f=FROM;
+    detents=0;
+    t=0;
+    a->reset();
+    while (TO-f>NEAR) {
+       f+=turn(a,+1,rate);
+    }
+    tnear=t;
+    t+=PAUSE;
+    while (f!=TO) {
+       f+=turn(a,(f<TO ? +1 : -1),SLOW);
+    }
+    return t/1e6;
+}
+//*--------------------------------------------------------------------------------------------------
+//* main
+//*--------------------------------------------------------------------------------------------------
+int main(int argc,char* argv[]) {
+
+int  v10=ACCEL10;
+int  v100=ACCEL100;
+int  a;
+
+    while ((a=getopt(argc,argv,"c:"))!=-1) {
+       switch(a) {
+         case 'c': if (sscanf(optarg,"%d,%d",&v10,&v100)!=2) {v10=v100=-1;} break;
+         default : v10=v100=-1; break;
+       }
+       if (v10<0) {
+          fprintf(stderr,"usage: EncoderAccel [-c 10x,100x detents/s]\n");
+          exit(1);
+       }
+    }
+    srand(1);
+
+EncoderAccel off;
+EncoderAccel on;
+    off.setCurve(0,0);
+    on.setCurve(v10,v100);
+
+    printf("EncoderAccel: %d to %d Hz at %d Hz per detent, curve 10x=%d 100x=%d detents/s\n",FROM,TO,STEP,v10,v100);
+    printf("%8s %8s %8s %8s %8s %8s %8s %8s\n","spin/s","off det","off s","cross s","on det","on s","cross s","speedup");
+const float RATE[]={5.0,10.0,20.0,40.0};
+    for (int i=0;i<(int)(sizeof(RATE)/sizeof(RATE[0]));i++) {
+        double s0=tune(&off,RATE[i]);
+        double c0=tnear/1e6;
+        unsigned long d0=detents;
+        double s1=tune(&on,RATE[i]);
+        double c1=tnear/1e6;
+        unsigned long d1=detents;
+        printf("%8.0f %8lu %8.1f %8.1f %8lu %8.1f %8.1f %7.1fx\n",RATE[i],d0,s0,c0,d1,s1,c1,s0/s1);
+    }
+    on.stats(stdout);
+    exit(0);
+}
@@ -0,0 +1,214 @@
+/*
+ * GPIObench
+ * idle CPU and edge timestamp accuracy of the GPIO backends
+ *---------------------------------------------------------------------
+ * Watches the front panel inputs (encoder CLK, DT and push, mic PTT
+ * and squelch by default) with pigpio, sampling the lines every 5 us,
+ * and with libgpiod, sleeping on the edge interrupts, and reports for
+ * each one:
+ *
+ *   idle     CPU taken by the process (all its threads) over -t s with
+ *            the lines quiet, per cent of one core
+ *   stamp    us from the stimulus to the tick the edge was stamped with,
+ *            the time the stimulus takes to reach the line included
+ *   deliver  us from that tick to the callback running
+ *   lost     stimulus edges never reported within 100 ms
+ *
+ * The stimulus toggles the first input -n times, 2 ms apart, through an
+ * output line wired back to it (-o) or, with the gpio-sim module, through
+ * the pull of the simulated line (-s, its sysfs pull attribute).
+ *
+ *    ../bin/GPIObench -o 26                     GPIO 26 wired to GPIO 17
+ *    ../bin/GPIObench -b gpiod -c /dev/gpiochip1 -s /sys/devices/platform/gpio-sim.0/gpiochip1/sim_gpio17/pull
+ *
+ * Built with -DNOPIGPIO it only has the libgpiod backend, for a PC.
+ *---------------------------------------------------------------------
+ * Created by Pedro E. Colla (lu7did@gmail.com)
+ * ---------------------------------------------------------------------
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <atomic>
+#include <sys/resource.h>
+#include "../lib/Histogram.h"
+#include "../lib/HALgpiod.h"
+#ifndef NOPIGPIO
+#include <pigpio.h>
+#include "../lib/HALpigpio.h"
+#endif
+
+#define MAXIN          8
+#define GAP         2000              // us between stimulus edges
+#define TIMEOUT   100000              // us to wait for an edge
+
+HALgpio* hal=NULL;
+int      in[MAXIN]={17,18,27,13,20};  // GPIO_CLK, GPIO_DT, GPIO_SW, GPIO_MICPTT, GPIO_SQL
+int      nin=5;
+int      out=-1;
+char     simpull[256]="";
+std::atomic<int>      seen(0);
+std::atomic<uint32_t> stamped(0);
+std::atomic<uint32_t> delivered(0);
+std::atomic<unsigned long> idleedges(0);
+
+//*--------------------------------------------------------------------------------------------------
+//* edge  callback of every input, the first one is the line stimulated
+//*--------------------------------------------------------------------------------------------------
+void edge(int gpio,int level,uint32_t tick) {
+
+uint32_t now=hal->tick();
+    idleedges++;
+    if (gpio!=in[0]) {return;}
+    stamped=tick;
+    delivered=now;
+    seen++;
+}
+//*--------------------------------------------------------------------------------------------------
+//* stimulate  drive the first input to level
+//*--------------------------------------------------------------------------------------------------
+int stimulate(int level) {
+
+    if (out>=0) {return hal->write(out,level);}
+int fd=open(simpull,O_WRONLY);
+    if (fd<0) {return -1;}
+const char* v=(level!=0 ? "pull-up" : "pull-down");
+int r=(int)write(fd,v,strlen(v));
+    close(fd);
+    return (r<0 ? -1 : 0);
+}
+//*--------------------------------------------------------------------------------------------------
+//* cpu  seconds of CPU taken by the process so far
+//*--------------------------------------------------------------------------------------------------
+double cpu() {
+struct rusage u;
+    getrusage(RUSAGE_SELF,&u);
+    return u.ru_utime.tv_sec+u.ru_stime.tv_sec+(u.ru_utime.tv_usec+u.ru_stime.tv_usec)/1e6;
+}
+//*--------------------------------------------------------------------------------------------------
+//* run  measure one backend
+//*--------------------------------------------------------------------------------------------------
+int run(HALgpio* h,int idle,int n) {
+
+    hal=h;
+    if (h->init()<0) {
+       fprintf(stderr,"GPIObench: backend %s could not be started\n",h->name);
+       return -1;
+    }
+    for (int i=0;i<nin;i++) {
+        h->setMode(in[i],HAL_INPUT);
+        h->setPull(in[i],HAL_PUD_UP);
+        h->setAlert(in[i],edge);
+    }
+    if (out>=0) {
+       h->setMode(out,HAL_OUTPUT);
+       h->write(out,1);
+    }
+    usleep(200000);
+
+//*--- Idle, nothing moves
+
+    idleedges=0;
+double c0=cpu();
+    sleep(idle);
+double c1=cpu();
+unsigned long spurious=idleedges;
+
+//*--- Stimulus edges, one at a time
+
+Histogram stamp;
+Histogram deliver;
+int lost=0;
+int level=h->read(in[0]);
+    for (int i=0;i<n && (out>=0 || simpull[0]!=0x00);i++) {
+        level=1-level;
+        int before=seen;
+        uint32_t t0=h->tick();
+        if (stimulate(level)<0) {
+           fprintf(stderr,"GPIObench: unable to drive the stimulus\n");
+           break;
+        }
+        while (seen==before && (uint32_t)(h->tick()-t0)<TIMEOUT) {usleep(10);}
+        if (seen==before) {
+           lost++;
+           continue;
+        }
+        uint32_t s=stamped;
+        uint32_t d=delivered;
+        stamp.record((int32_t)(s-t0)<0 ? 0 : s-t0);
+        deliver.record(d-s);
+        usleep(GAP);
+    }
+
+    printf("%-8s idle %6.2f%% of a core over %d s, %lu spurious edges\n",h->name,100.0*(c1-c0)/idle,idle,spurious);
+    if (stamp.count!=0) {
+       stamp.print(stdout,"         stamp");
+       deliver.print(stdout,"         deliver");
+    }
+    if (out>=0 || simpull[0]!=0x00) {printf("         lost %d of %d\n",lost,n);}
+    h->terminate();
+    return 0;
+}
+//*--------------------------------------------------------------------------------------------------
+//* main
+//*--------------------------------------------------------------------------------------------------
+int main(int argc,char* argv[]) {
+
+char backend[16]="both";
+char chip[64]=GPIODCHIP;
+int  idle=10;
+int  n=1000;
+int  a;
+
+    while ((a=getopt(argc,argv,"b:c:i:o:s:t:n:"))!=-1) {
+       switch(a) {
+         case 'b': strncpy(backend,optarg,sizeof(backend)-1); break;
+         case 'c': strncpy(chip,optarg,sizeof(chip)-1); break;
+         case 'i': {
+                   nin=0;
+                   char* p=strtok(optarg,",");
+                   while (p!=NULL && nin<MAXIN) {in[nin++]=atoi(p); p=strtok(NULL,",");}
+                   break;
+                   }
+         case 'o': out=atoi(optarg); break;
+         case 's': strncpy(simpull,optarg,sizeof(simpull)-1); break;
+         case 't': idle=atoi(optarg); break;
+         case 'n': n=atoi(optarg); break;
+         default:
+              fprintf(stderr,"usage: GPIObench [-b pigpio|gpiod|both] [-c gpiod chip] [-i inputs] [-o stimulus output | -s gpio-sim pull file] [-t idle s] [-n edges]\n");
+              exit(1);
+       }
+    }
+    if (nin==0 || idle<=0) {
+       fprintf(stderr,"GPIObench: no inputs or no idle time\n");
+       exit(1);
+    }
+
+    printf("GPIObench: inputs");
+    for (int i=0;i<nin;i++) {printf(" %d",in[i]);}
+    if (out>=0) {
+       printf(", stimulus output %d\n",out);
+    } else {
+       printf(", stimulus %s\n",(simpull[0]!=0x00 ? simpull : "none"));
+    }
+
+#ifndef NOPIGPIO
+    if (strcmp(backend,"pigpio")==0 || strcmp(backend,"both")==0) {
+       PiGPIO p;
+       run(&p,idle,n);
+    }
+#endif
+    if (strcmp(backend,"gpiod")==0 || strcmp(backend,"both")==0) {
+       GpiodGPIO g(chip);
+       run(&g,idle,n);
+       g.stats(stdout);
+    }
+    exit(0);
+}
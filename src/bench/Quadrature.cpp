@@ -0,0 +1,209 @@
+/*
+ * Quadrature
+ * synthetic edge generator for the tuning encoder decoders
+ *---------------------------------------------------------------------
+ * Generates the CLK and DT edges of an encoder turned clockwise at a
+ * given rate, with jitter on every quarter step and contact bounce
+ * after most edges (bursts of short pulses within BOUNCE us), and
+ * feeds them to:
+ *
+ *   isr     the former decoder, an interrupt on the CLK falling edge
+ *           reading both lines once the callback runs (30..150 us
+ *           later) and a 2 ms lockout after every detent taken
+ *   table   the Quadrature table decoder with every edge as pigpio
+ *           samples them (5 us), no filter
+ *   filter  the same with the pigpio glitch filter of QUADGLITCH us
+ *
+ * Reports the detents detected (clockwise), reversed (counted the
+ * other way) and extra, per cent of the detents turned, at 10, 100
+ * and 1000 detents per second.
+ *
+ *    ../bin/Quadrature -n 20000
+ *---------------------------------------------------------------------
+ * Created by Pedro E. Colla (lu7did@gmail.com)
+ * ---------------------------------------------------------------------
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+#include <algorithm>
+#include "../lib/Quadrature.h"
+
+#define SAMPLE        5               // us, pigpio sampling period
+#define BOUNCE      200               // us, longest bounce burst after an edge
+#define PBOUNCE     0.7               // edges followed by a bounce burst
+#define JITTER      0.3               // +/- fraction of the quarter step
+#define LOCKOUT    2000               // us, former MINENCLAP
+
+struct Edge {
+       unsigned long long t;
+       int line;
+       int level;
+};
+
+std::vector<Edge> raw[2];             // transitions per line, in time order
+
+double rnd() {
+       return rand()/(double)RAND_MAX;
+}
+//*--------------------------------------------------------------------------------------------------
+//* levelAt  level of a line at t from its transitions, both lines rest high
+//*--------------------------------------------------------------------------------------------------
+int levelAt(int line,unsigned long long t) {
+
+std::vector<Edge>& v=raw[line];
+int lo=0;
+int hi=(int)v.size();
+    while (lo<hi) {
+       int m=(lo+hi)/2;
+       if (v[m].t<=t) {lo=m+1;} else {hi=m;}
+    }
+    return (lo==0 ? 1 : v[lo-1].level);
+}
+//*--------------------------------------------------------------------------------------------------
+//* generate  n clockwise detents at rate detents/s; DT leads: DT 0, CLK 0, DT 1, CLK 1
+//*--------------------------------------------------------------------------------------------------
+void generate(int n,double rate) {
+
+double q=1e6/(rate*QUADSTEPS);
+unsigned long long t=1000;
+const int LINE[4]={QUAD_DT,QUAD_CLK,QUAD_DT,QUAD_CLK};
+const int LEVEL[4]={0,0,1,1};
+
+    raw[0].clear();
+    raw[1].clear();
+    for (int i=0;i<n;i++) {
+        for (int k=0;k<4;k++) {
+            t+=(unsigned long long)(q*(1.0-JITTER+2.0*JITTER*rnd()))+1;
+            Edge e={t,LINE[k],LEVEL[k]};
+            std::vector<Edge>& v=raw[e.line];
+            while (!v.empty() && v.back().t>=t) {v.pop_back();}    // a burst running into this edge
+            if (!v.empty() && v.back().level==e.level) {v.pop_back();}
+            v.push_back(e);
+
+//*--- Bounce, pulses back to the former level, kept within the window and short of the next edge
+//*--- of the same line (two quarter steps later)
+
+            if (rnd()<PBOUNCE) {
+               double w=(BOUNCE<1.5*q ? BOUNCE : 1.5*q);
+               unsigned long long b=t;
+               int nb=1+rand()%4;
+               for (int j=0;j<nb;j++) {
+                   b+=2+(unsigned long long)(rnd()*w/(2*nb));
+                   v.push_back({b,e.line,1-e.level});
+                   b+=2+(unsigned long long)(rnd()*w/(2*nb));
+                   v.push_back({b,e.line,e.level});
+               }
+            }
+        }
+        t+=(unsigned long long)(q*0.1);
+    }
+}
+//*--------------------------------------------------------------------------------------------------
+//* sampled  transitions of a line as pigpio reports them, sampled every SAMPLE us and, if steady is
+//* not 0, only once the level held steady us (reported with the tick it changed at)
+//*--------------------------------------------------------------------------------------------------
+std::vector<Edge> sampled(int line,int steady) {
+
+std::vector<Edge> s;
+int level=1;
+    for (size_t i=0;i<raw[line].size();i++) {
+        unsigned long long t=(raw[line][i].t+SAMPLE-1)/SAMPLE*SAMPLE;
+        int l=levelAt(line,t);
+        if (l!=level) {
+           s.push_back({t,line,l});
+           level=l;
+        }
+    }
+    if (steady==0) {return s;}
+
+std::vector<Edge> f;
+    level=1;
+    for (size_t i=0;i<s.size();i++) {
+        if (i+1<s.size() && s[i+1].t-s[i].t<(unsigned long long)steady) {continue;}
+        if (s[i].level==level) {continue;}
+        f.push_back(s[i]);
+        level=s[i].level;
+    }
+    return f;
+}
+//*--------------------------------------------------------------------------------------------------
+//* table  detents seen by the Quadrature decoder fed with both lines merged in tick order
+//*--------------------------------------------------------------------------------------------------
+void table(int steady,long* cw,long* ccw) {
+
+std::vector<Edge> e=sampled(QUAD_CLK,steady);
+std::vector<Edge> d=sampled(QUAD_DT,steady);
+    e.insert(e.end(),d.begin(),d.end());
+    std::stable_sort(e.begin(),e.end(),[](const Edge& a,const Edge& b) {return a.t<b.t;});
+
+Quadrature qd;
+    *cw=*ccw=0;
+    for (size_t i=0;i<e.size();i++) {
+        int r=qd.edge(e[i].line,e[i].level,(uint32_t)e[i].t);
+        if (r>0) {(*cw)++;}
+        if (r<0) {(*ccw)++;}
+    }
+}
+//*--------------------------------------------------------------------------------------------------
+//* isr  detents seen by the former decoder
+//*--------------------------------------------------------------------------------------------------
+void isr(long* cw,long* ccw) {
+
+unsigned long long last=0;
+int level=1;
+    *cw=*ccw=0;
+    for (size_t i=0;i<raw[QUAD_CLK].size();i++) {
+        Edge& e=raw[QUAD_CLK][i];
+        if (e.level==level) {continue;}
+        level=e.level;
+        if (e.level!=0) {continue;}
+        unsigned long long t=e.t+30+(unsigned long long)(rnd()*120);
+        if (last!=0 && t-last<LOCKOUT) {continue;}
+        int clk=levelAt(QUAD_CLK,t);
+        int dt=levelAt(QUAD_DT,t);
+        (dt!=clk ? (*ccw)++ : (*cw)++);
+        last=t;
+    }
+}
+//*--------------------------------------------------------------------------------------------------
+//* main
+//*--------------------------------------------------------------------------------------------------
+int main(int argc,char* argv[]) {
+
+int  n=20000;
+int  a;
+
+    while ((a=getopt(argc,argv,"n:"))!=-1) {
+       switch(a) {
+         case 'n': n=atoi(optarg); break;
+         default:
+              fprintf(stderr,"usage: Quadrature [-n detents per rate]\n");
+              exit(1);
+       }
+    }
+    srand(1);
+
+    printf("Quadrature: %d clockwise detents per rate, bounce after %.0f%% of the edges within %d us, glitch filter %d us\n",
+           n,PBOUNCE*100.0,BOUNCE,QUADGLITCH);
+    printf("%8s | %8s %8s %8s | %8s %8s %8s | %8s %8s %8s\n","det/s","isr ok%","rev%","extra%",
+           "table ok%","rev%","extra%","filter ok%","rev%","extra%");
+const double RATE[]={10.0,100.0,1000.0};
+    for (int i=0;i<3;i++) {
+        generate(n,RATE[i]);
+        long c0,r0,c1,r1,c2,r2;
+        isr(&c0,&r0);
+        table(0,&c1,&r1);
+        table(QUADGLITCH,&c2,&r2);
+        printf("%8.0f | %8.2f %8.2f %8.2f | %8.2f %8.2f %8.2f | %8.2f %8.2f %8.2f\n",RATE[i],
+               100.0*(c0<n ? c0 : n)/n,100.0*r0/n,100.0*(c0>n ? c0-n : 0)/n,
+               100.0*(c1<n ? c1 : n)/n,100.0*r1/n,100.0*(c1>n ? c1-n : 0)/n,
+               100.0*(c2<n ? c2 : n)/n,100.0*r2/n,100.0*(c2>n ? c2-n : 0)/n);
+    }
+    exit(0);
+}
@@ -22,12 +22,21 @@
 #include <termios.h>
 #include "/home/pi/OrangeThunder/src/lib/CallBackTimer.h"
 #include "../picoFM/picoFM.h"
+#include "./DRA818Vframer.h"
+#include "./SPSCQueue.h"
+#include "./EventLoop.h"
+#include "./Wakeup.h"
+#include "./Histogram.h"
 #include <iostream>
 #include <fstream>
 using namespace std;
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/timerfd.h>
 
 
 
@@ -36,6 +45,7 @@ typedef unsigned char byte;
 typedef bool boolean;
 typedef void (*CALLBACK)();
 typedef void (*CALLRSSI)(float s);
+typedef void (*CALLRSSIID)(int id,float s);
 
 bool getWord (unsigned char SysWord, unsigned char v);
 void setWord(unsigned char* SysWord,unsigned char v, bool val);
@@ -50,33 +60,150 @@ void setWord(unsigned char* SysWord,unsigned char v, bool val);
 #define  SQ      0B01000000
 #define  PT      0B10000000
 
+//*---- Command engine, commands are queued in a ring and only one is in flight at any time
+
+#define  DRAQUEUE       16           // size of the command ring
+#define  DRATIMEOUT    500           // ms to wait for a reply before giving up the command
+
+#define  DRA_LANE_PTT    0           // PTT critical and system commands (connect, version, tail)
+#define  DRA_LANE_WATCH  1           // priority watch looks (group, RSSI), held back until READY
+#define  DRA_LANE_TUNE   2           // tuning and configuration (group, volume, filter)
+#define  DRA_LANE_POLL   3           // RSSI polling
+#define  DRA_LANES       4
+
+#define  DRA_CMD_CONNECT 0           // command types, index into REPLY[] and value of the DRA818V_reply answering it
+#define  DRA_CMD_GROUP   1
+#define  DRA_CMD_VOLUME  2
+#define  DRA_CMD_FILTER  3
+#define  DRA_CMD_TAIL    4
+#define  DRA_CMD_VERSION 5
+#define  DRA_CMD_RSSI    6
+#define  DRA_CMD_OTHER   7
+#define  DRA_CMDS        8
+
+//*---- Startup handshake, only the PTT lane is served until the chip is READY
+
+#define  DRA_HS_IDLE     0           // not started
+#define  DRA_HS_CONNECT  1           // waiting for +DMOCONNECT:0
+#define  DRA_HS_VERSION  2           // waiting for +VERSION:
+#define  DRA_HS_TAIL     3           // waiting for +DMOSETTAIL:
+#define  DRA_HS_READY    4           // handshake complete, all lanes served
+#define  DRA_HS_BACKOFF  5           // link down, handshake attempted again when the backoff expires
+#define  DRARETRY        3           // attempts per handshake step
+#define  DRA_EVT_HANDSHAKE DRA_CMDS  // event type signaling the end of the handshake, rc=0 READY or -1 link down
+
+//*---- Link health, a READY link is resynchronized on too many missing replies or too much garbage
+
+#define  DRAMISS         3           // consecutive commands without reply
+#define  DRANOISE        4           // malformed or unsolicited lines since the last good reply
+#define  DRABACKOFF    250           // ms before the first new handshake attempt, doubled on each failure
+#define  DRABACKOFFMAX 8000          // ms, longest wait between handshake attempts
+
+//*---- RSSI polling intervals (ms), the application picks one with setPoll()
+
+#define  DRAPOLLFAST   150           // squelch open
+#define  DRAPOLLMETER  500           // meter on screen, squelch closed
+#define  DRAPOLLSLOW  2000           // nobody looking
+
+//*---- Scanner, runs on the I/O thread so the next channel is written as soon as the current one is
+//*---- found empty; the frame of the next channel is encoded while the current one is listened and
+//*---- its RSSI? is sent ahead so the reply lands as the dwell ends
+
+#define  DRASCANMAX   1024           // channels of a range scan, size of the lockout bitmap
+#define  DRADWELL       50           // ms listening to a channel once the chip acknowledged the tune
+#define  DRAHANG      2000           // ms a stopped scan waits after the signal is gone before resuming
+#define  DRASCANRSSI    60           // RSSI at or above which a channel is busy (an open squelch is too)
+
+#define  DRA_SCAN_OFF    0
+#define  DRA_SCAN_TUNE   1           // GROUP of the channel written, waiting for the acknowledge
+#define  DRA_SCAN_DWELL  2           // listening to the channel
+#define  DRA_SCAN_HOLD   3           // channel busy, scan stopped
+#define  DRA_SCAN_HANG   4           // signal gone, the scan resumes when the hang time expires
+#define  DRA_EVT_SCAN  (DRA_CMDS+1)  // event type, rc=scan state us=channel; on stop, resume and once a second
+
+//*---- Band scope, a scan that never stops over DRASCOPEBINS channels centered on the one in use;
+//*---- the oldest bin is measured next and the readings are cached by frequency so the scope
+//*---- shows what is known at once when entered again
+
+#define  DRASCOPEBINS   16           // channels of the scope, one per LCD column
+#define  DRASCOPECACHE  64           // readings kept by frequency
+#define  DRASCOPEFRAME 250           // ms between scope events, the bins measured per event follow the link
+#define  DRASCOPEDWELL  20           // ms listening to a bin, enough for the RSSI to settle after the tune
+
+//*---- Priority watch, every DRAPRIO ms the chip leaves the channel in use for a look at the priority
+//*---- slot and comes back unless it is busy; the looks ride their own lane ahead of tuning and polling,
+//*---- which bounds the revisit time to the interval plus one command in flight, and never go out
+//*---- ahead of a handshake
+
+#define  DRAPRIO      2000           // ms between looks at the priority channel
+#define  DRAPRIODWELL   20           // ms on the priority channel before its RSSI is read
+
+#define  DRA_WATCH_OFF   0
+#define  DRA_WATCH_MAIN  1           // on the channel in use until the next look
+#define  DRA_WATCH_LOOK  2           // GROUP of the priority channel written, sampling it
+#define  DRA_WATCH_BACK  3           // priority found empty, GROUP of the channel in use written
+#define  DRA_WATCH_HOLD  4           // priority busy, staying there until quiet for the hang time
+#define  DRA_EVT_WATCH (DRA_CMDS+2)  // event type, rc=watch state us=channel; on start, stop, hold and release
 
 struct DRA818V_response
 {
         char     command[128];
-        char     response[128];
-        bool     active;
-        bool     serviced;
-        char     rc[32];
-        int      timeout;
+        bool     active;             // slot holds a command (queued or in flight)
+        bool     serviced;           // reply received (or timeout) for the command
+        bool     sent;               // command written to the serial port
+        byte     lane;               // priority lane, lower is served first
+        byte     type;               // DRA_CMD_xxx
+        unsigned long seq;           // order of arrival within the lane
+unsigned long long tqueue;           // time (us) the command content was last written by the caller
+unsigned long long tsent;            // time (us) the command was written
+        int      rc;                 // rc (or RSSI) of the reply, -1 on timeout
+        int      timeout;            // ms
 
 };
 
-//*---- Structure for future expansion currently only index=0 is used (memory is implemented in the genVFO object not here, the DRA818 has no memory
+//*---- Completed commands handed from the I/O thread to the application
+
+struct DRA818V_event
+{
+        byte     type;               // DRA_CMD_xxx of the command completed
+        int      rc;                 // rc (or RSSI) of the reply, -1 on timeout
+        long     us;                 // round trip latency in microseconds
+};
+
+//*---- Channel bank, the slot m is the one in use (the VFO the application tunes, it stays put and a
+//*---- channel recalled is copied into it); each slot keeps its AT frames already encoded so recalling
+//*---- a channel costs a single write (the DRA818 has no memory of its own); the HL, PD, SQ and PT
+//*---- bits describe the module rather than a channel and live in RSW, not in a slot
+
+#define  DRABANK        16           // channel slots
+#define  DRARASTER     100           // Hz, resolution of the frequencies in the AT+DMOSETGROUP frame
+#define  DRASCAN   DRABANK           // extra slot where a range scan encodes its next channel
 
 struct DRA 
 {
-        float    TFW;
-        float    OFS;
-        float    RFW;
+        long     TFW;                // Hz
+        long     OFS;                // Hz
+        long     RFW;                // Hz
         int      SQL;
         byte     STATUS;
         int      Tx_CTCSS;
         int      Rx_CTCSS;
         byte     Vol;
+        bool     dirty;              // a setting changed since the frames were encoded
+        bool     skip;               // locked out of a bank scan
+        char     group[64];          // AT+DMOSETGROUP frame
+        char     volume[24];         // AT+DMOSETVOLUME frame
+        char     filter[24];         // AT+SETFILTER frame
 
 };
 
+struct DRA818V_bin
+{
+        long     f;                  // Hz, 0 when the entry is free
+        int      rssi;
+unsigned long long t;                // time (us) of the reading
+};
+
 
 //---------------------------------------------------------------------------------------------------
 // DRA818V Encapsulate the configuration and operation of the DORJI DA818 chipset
@@ -93,30 +220,96 @@ CALLBACK changePTT=NULL;
 CALLBACK changePD=NULL;
 CALLBACK changeHL=NULL;
 CALLRSSI changeRSSI=NULL;
+CALLBACK changeRUN=NULL;             // handshake completed (or failed), check RUN in MSW
+CALLBACK changeSCAN=NULL;            // scanner stopped, resumed or measured its rate, check scan
+CALLBACK changeWATCH=NULL;           // priority watch started, stopped, held or released, check watch
+CALLRSSIID changeRSSIid=NULL;        // RSSI reading with the id of the module, for a callback shared by several
+     int id=0;                       // number the application knows the module by
 
 // --- Public methods
 
      int start();
+     int start(const char* port);
     void stop();
+  static void onSerial(void* p,uint32_t e);
+  static void onTimer(void* p,uint32_t e);
      int set_interface_attribs (int fd, int speed, int parity);
     void set_blocking (int fd, int should_block);
      int read_data(char* buffer,int len);
-    void send_data(char* s);
+    void send_data(char* s,byte lane=DRA_LANE_TUNE);
 
     void processCommand();
-    void parseCommand();
-
-   float getRFW();
-   float getRFW(byte m);
-
-   void  setRFW(float f);
-   void  setRFW(byte m, float f);
-
-   float getTFW();
-   float getTFW(byte m);
-
-   void  setTFW(float f);
-   void  setTFW(byte m,float f);
+    void parseCommand(DRA818V_msg* r);
+
+     int queueCommand(char* s,byte lane);
+    void dispatchCommand();
+    void completeCommand(DRA818V_msg* r);
+    void checkTimeout();
+    void handshake(byte type,bool ok);
+    void resync(const char* why);
+     int reopen();
+    void checkLink();
+    void replay();
+    void encode(byte c);
+    char* frame(byte c,byte type);
+    void recall(byte c);
+    void store(byte c);
+    void pollRSSI();
+     int scanRange(long lo,long hi,long step);
+     int scanMemory();
+     int scopeStart(long step);
+    void stopScan();
+    void skipScan(bool lock);
+    void setLockout(int ch,bool v);
+    bool getLockout(int ch);
+    void setSkip(byte c,bool v);
+    bool getSkip(byte c);
+    long scanFreq();
+    long scanFreq(int ch);
+    long rxFreq();
+     int scanNext(int ch);
+    void scanPrepare(int ch);
+    void scanTune(int ch);
+    void scanDecide(bool busy);
+    void scanReply(byte type,int rc);
+    void scanService();
+    void scanAdopt();
+    void scanEvent();
+    void scopeLoad();
+    void scopeRecord(int rc);
+     int scopeFrame();
+     int watchStart(byte c,int ms);
+    void watchStop();
+    void skipWatch();
+    void watchLeave();
+    void watchReply(byte type,int rc);
+    void watchService();
+    void watchEvent();
+     int stats(FILE* f);
+    void setPoll(int ms);
+const char* settled(byte type);
+    void service();
+    void post(DRA818V_event e);
+     int attach(EventLoop* l);
+    void armTimer();
+unsigned long long usec();
+
+   long  getRFW();
+   long  getRFW(byte m);
+
+   void  setRFW(long f);
+   void  setRFW(byte m, long f);
+
+   long  getTFW();
+   long  getTFW(byte m);
+
+   void  setTFW(long f);
+   void  setTFW(byte m,long f);
+
+  static long  toHz(float f);
+  static char* putNum(char* p,unsigned long v,int w);
+  static char* putMHz(char* p,long f,int dec);
+  static long  rxHz(const char* s);
 
    int   getTxCTCSS();
    int   getTxCTCSS(byte m);
@@ -167,6 +360,12 @@ CALLRSSI changeRSSI=NULL;
    void  setLPF(bool g);
 
    bool  getPTT();
+   bool  canKey();
+   void  unKey();
+   bool  keyed();
+   void  setSQ(bool v);
+   void  postSQ(bool v);
+   bool  getSQ();
    void  setPTT(bool p);
 
    void  sendSetGroup();
@@ -180,20 +379,97 @@ CALLRSSI changeRSSI=NULL;
 // -- public attributes
 
     byte TRACE=0x02;
-struct   DRA818V_response   d[16];
-struct   DRA      dra[16];
-     int pR=0;
-     int pW=0;
+struct   DRA818V_response   d[DRAQUEUE];
+struct   DRA      dra[DRABANK+1];   // channel bank plus the DRASCAN slot
+     int pR=-1;                      // slot currently in flight (-1 when the link is idle)
+     int pW=0;                       // next slot to try when queueing
+unsigned long seq=0;
+unsigned long coalesced=0;           // commands replaced by a newer one of the same type before being sent
+    long  maxTuneLatency=0;          // worst time (ms) from the last tuning request to its acknowledge
+unsigned long cmdSent=0;             // commands written to the serial port
+unsigned long cmdSuppressed=0;       // commands not sent because the chip already holds that setting
+    char  shadow[DRA_CMDS][128];     // last command acknowledged per type, empty when the chip state is unknown
+    byte  hs=DRA_HS_IDLE;            // startup handshake state
+    byte  retries=0;                 // attempts of the current handshake step
+unsigned long long tstart=0;         // time (us) start() was called
+    long  bootms=-1;                 // ms from start() to READY, -1 until then
+    char  version[32];               // firmware version reported by the chip
+     int  pollms=0;                  // RSSI polling interval (ms), 0 when not polling
+unsigned long long tpoll=0;          // time (us) of the next RSSI poll
+unsigned long polls=0;               // RSSI? commands issued by the poller
+Histogram lat[DRA_CMDS];             // round trip latency (us) of the replies per command type
+std::atomic<byte> scan{DRA_SCAN_OFF};   // scanner state, read without the lock by canKey()
+std::atomic<bool> keying{false};     // canKey() let the mic key the transmitter, setPTT() has not caught up yet
+    bool  scanmem=false;             // scanning the bank slots rather than a frequency range
+    bool  scanscope=false;           // the scan feeds the band scope, it never stops on a signal
+    long  scanlo=0;                  // Hz, first channel of a range scan
+    long  scanstep=0;                // Hz, channel spacing of a range scan
+    long  scanofs=0;                 // Hz, transmit offset kept while scanning a range
+     int  scann=0;                   // channels in the range (or bank slots)
+     int  scanch=-1;                 // channel being listened
+     int  scannext=-1;               // channel of a range scan already encoded in the DRASCAN slot
+     int  dwell=DRADWELL;            // ms
+     int  hang=DRAHANG;              // ms
+     int  scanrssi=DRASCANRSSI;
+    bool  scanasked=false;           // the RSSI? deciding the current dwell is out
+unsigned long long tscan=0;          // time (us) the channel was written, or the hang expires
+unsigned long long tsample=0;        // time (us) of the next RSSI? of the scanner
+unsigned long long trate=0;          // start (us) of the scan rate measurement
+unsigned long nrate=0;               // channels visited since trate
+   float  scanrate=0.0;              // channels per second while sweeping
+unsigned long scanned=0;             // channels visited
+unsigned long scanstops=0;           // busy channels found
+unsigned char lockout[DRASCANMAX/8]; // channels skipped by a range scan, one bit each
+    long  locklo=0;                  // Hz, range the lockout bitmap belongs to
+    long  lockstep=0;
+     int  lockn=0;
+     int  scope[DRASCOPEBINS];       // RSSI of each bin of the band scope, -1 while unknown
+unsigned long long tbin[DRASCOPEBINS]; // time (us) each bin was measured, 0 while unknown
+     int  scopen=1;                  // bins measured per scope event
+     int  scopek=0;                  // bins measured since the last scope event
+struct   DRA818V_bin cache[DRASCOPECACHE]; // scope readings by frequency
+std::atomic<byte> watch{DRA_WATCH_OFF};  // priority watch state, read without the lock by canKey()
+    byte  prio=0;                    // bank slot of the priority channel
+     int  prioms=DRAPRIO;            // ms between looks
+    bool  prioon=false;              // the chip acknowledged the priority channel
+    bool  prioasked=false;           // the RSSI? of the current look is out
+unsigned long long tprio=0;          // time (us) of the next look
+unsigned long long tlook=0;          // time (us) the current look started
+unsigned long long tpsample=0;       // time (us) of the next RSSI? on the priority channel
+unsigned long long tsampled=0;       // time (us) the priority channel was last sampled, 0 for none yet
+unsigned long long tgone=0;          // time (us) a held priority channel went quiet, 0 while busy
+unsigned long looks=0;               // samples of the priority channel taken by looks
+unsigned long priostops=0;           // looks that found the priority channel busy
+Histogram revisit;                   // us between samples of the priority channel
+Histogram gap;                       // us away from the channel in use per look
+Histogram scanlat;                   // us from writing a channel to finding it empty (or busy)
+unsigned long timeouts[DRA_CMDS];    // commands given up without reply per command type
+unsigned long cmdRetries=0;          // handshake commands sent again
+unsigned long unsolicited=0;         // well formed replies not matching the command in flight
+unsigned long resyncs=0;             // times the link was declared down and the handshake run again
+unsigned long resets=0;              // chip found with a different firmware version after a resync
+    byte  misses=0;                  // consecutive commands given up without reply
+unsigned  noise=0;                   // malformed or unsolicited lines since the last good reply
+     int  backoff=DRABACKOFF;        // ms to wait before the next handshake attempt
+unsigned long long tretry=0;         // time (us) of the next handshake attempt while in BACKOFF
+    bool  hup=false;                 // the port hung up (USB UART unplugged, pty closed), reopen it
+
+EventLoop* loop=nullptr;             // I/O thread servicing the serial port, polled from processCommand() if none
+     int tfd=-1;                     // timerfd armed at the deadline of the command in flight
+SPSCQueue<DRA818V_event,64> events;
+  Wakeup* notify=nullptr;            // rung after every event queued for processCommand(), none if polled
+std::atomic<long> rxf{0};            // Hz received by the last GROUP written to the chip, read lock free by rxFreq()
+std::atomic<int> sqin{-1};           // squelch level posted from the GPIO ISR (-1 none), applied by processCommand()
+pthread_mutex_t mtx=PTHREAD_MUTEX_INITIALIZER;
 
     byte  m=0;
-     int pRead=0;
-     int pWrite=0;
      int fd=0;
     byte MSW = 0;
+    byte RSW = 0;                    // HL, PD, SQ and PT of the module, whatever slot is in use
     char portname[64];
     char command[128];
     char buffer[128];
-    char commandQueue[128];
+DRA818Vframer framer;
 
 //-------------------- GLOBAL VARIABLES ----------------------------
 const char   *PROGRAMID="DRA818V";
@@ -202,6 +478,10 @@ const char   *PROG_BUILD="00";
 const char   *COPYRIGHT="(c) LU7DID 2019,2020";
 
 
+//*--- Command prefixes, in the order of DRA_CMD_xxx
+
+const char* REPLY[7]={"AT+DMOCONNECT","AT+DMOSETGROUP","AT+DMOSETVOLUME","AT+SETFILTER","AT+SETTAIL","AT+VERSION","RSSI?"};
+
 //*--- Define CTCSS tones (DRA818 requires the index to this table as a configuration item)
 
 float CTCSS[38+1]={0.0,67.0,71.9,74.4,77.0,79.7,82.5,85.4,88.5,91.5,94.8,97.4,100.0,103.5,107.2,110.9,114.8,118.8,123.0,127.3,131.8,136.5,141.3,146.2,151.4,156.7,162.2,167.9,173.8,179.9,186.2,192.8,203.5,210.7,218.1,225.7,233.6,241.8,250.3};
@@ -225,6 +505,14 @@ DRA818V::DRA818V(CALLBACK ptt,CALLBACK pdt,CALLBACK hlt,CALLRSSI s) {
 
 // --- initial definitions
 
+   memset(d,0,sizeof(d));
+   memset(dra,0,sizeof(dra));
+   memset(lockout,0,sizeof(lockout));
+   memset(cache,0,sizeof(cache));
+   memset(shadow,0,sizeof(shadow));
+   memset(timeouts,0,sizeof(timeouts));
+   version[0]=0x00;
+
    setWord(&MSW,RUN,false);
 }
 //---------------------------------------------------------------------------------------------------
@@ -261,133 +549,1263 @@ int DRA818V::TonetoCTCSS(float t) {
 }
 //---------------------------------------------------------------------------------------------------
 // parseCommand Implementation
+// act on a typed reply framed from the serial port
 //--------------------------------------------------------------------------------------------------
-void DRA818V::parseCommand() {
-
-char  cmd[128];
-char* token; 
-char* p;
-char* val;
-    val=(char*)malloc(128);
-    p=(char*)malloc(128);
-    sprintf(cmd,"%s",commandQueue);
-    strcpy(d[pR].response,cmd);
-    (TRACE>=0x03 ? fprintf(stderr,"%s:parseCommand(): Response(%s)\n",PROGRAMID,cmd) : _NOP);
-    if (strstr(cmd,"+DMOCONNECT:") != NULL || strstr(cmd,"DMOSETGROUP:") != NULL || strstr(cmd,"DMOSETFILTER:")!=NULL || strstr(cmd,"DMOSETVOLUME:") != NULL || strstr(cmd,"+VERSION")!=NULL || strstr(cmd,"DMOSETTAIL:") != NULL ) {
-       token = strtok(cmd, ":");
-       strcpy(p,token);
-       while (token!=NULL) {
-         token=strtok(NULL,":");
-         if (token!=NULL) {
-            strcpy(val,token);
-            strcpy(d[pR].rc,val);
-         }
-       } 
+void DRA818V::parseCommand(DRA818V_msg* r) {
+
+    (TRACE>=0x03 ? fprintf(stderr,"%s:parseCommand(): Response kind(%d) rc(%d)\n",PROGRAMID,r->kind,r->rc) : _NOP);
+
+    if (r->kind==DRA_RPL_UNKNOWN) {
+       (TRACE>=0x02 ? fprintf(stderr,"%s:parseCommand(): malformed Response ignored\n",PROGRAMID) : _NOP);
        return;
     }
 
-float r=0.0;
+    completeCommand(r);
+}
+//---------------------------------------------------------------------------------------------------
+// service  drain the serial port, complete the command in flight, expire it on timeout and send
+// the next one; runs on the I/O thread when attached to an EventLoop
+//--------------------------------------------------------------------------------------------------
+void DRA818V::service() {
+
+char b[128];
+DRA818V_msg r;
+int  n;
+
+     do {
+        n=read(fd,b,sizeof(b));
+        pthread_mutex_lock(&mtx);
+        if (n>0) {
+           (TRACE>=0x03 ? fprintf(stderr,"%s:service() read (%d) characters from serial in\n",PROGRAMID,n) : _NOP);
+           framer.feed(b,n);
+        }
+unsigned long k=framer.malformed;
+        while (framer.next(&r)==true) {
+           parseCommand(&r);
+        }
+        noise+=(unsigned)(framer.malformed-k);
+        pthread_mutex_unlock(&mtx);
+     } while (n==(int)sizeof(b));
+
+     pthread_mutex_lock(&mtx);
+     checkTimeout();
+     checkLink();
+     pollRSSI();
+     scanService();
+     watchService();
+     dispatchCommand();
+     armTimer();
+     pthread_mutex_unlock(&mtx);
+}
+//---------------------------------------------------------------------------------------------------
+// pollRSSI  queue an RSSI? when its time has come, never while transmitting or before READY
+//--------------------------------------------------------------------------------------------------
+void DRA818V::pollRSSI() {
+
+    if (pollms==0) return;
+unsigned long long t=usec();
+    if (t<tpoll) return;
+    tpoll=t+(unsigned long long)pollms*1000;
 
-    if (strstr(cmd,"RSSI=")!=NULL) {
-       token = strtok(cmd, "=");
-       strcpy(p,token);
-       while (token!=NULL) {
-         token=strtok(NULL,"=");
-         if (token!=NULL) {
-            strcpy(val,token);
-            strcpy(d[pR].rc,val);
-            r=atof(val);
-            if (changeRSSI != NULL) {
-               changeRSSI(r);
+    if (hs!=DRA_HS_READY || keyed()==true) return;
+    if (scan==DRA_SCAN_TUNE || scan==DRA_SCAN_DWELL) return;      // the scanner samples by itself
+    if (watch==DRA_WATCH_LOOK || watch==DRA_WATCH_BACK) return;   // not on the channel in use
+    polls++;
+    queueCommand((char*)"RSSI?",DRA_LANE_POLL);
+}
+//---------------------------------------------------------------------------------------------------
+// scanRange  sweep lo..hi (Hz) in step increments starting next to the channel in use, the lockout
+// bitmap is kept while the range is the same
+//--------------------------------------------------------------------------------------------------
+int DRA818V::scanRange(long lo,long hi,long step) {
 
+    if (step<=0 || hi<lo) return -1;
+long n=(hi-lo)/step+1;
+    if (n>DRASCANMAX) {n=DRASCANMAX;}
+
+    pthread_mutex_lock(&mtx);
+    if (keyed()==true) {
+       pthread_mutex_unlock(&mtx);
+       return -1;
+    }
+    if (lo!=locklo || step!=lockstep || n!=lockn) {
+       memset(lockout,0,sizeof(lockout));
+       locklo=lo;
+       lockstep=step;
+       lockn=(int)n;
+    }
+    if (scan!=DRA_SCAN_OFF) {scanAdopt();}
+    scanmem=false;
+    scanscope=false;
+    scanlo=lo;
+    scanstep=step;
+    scann=(int)n;
+    scanofs=dra[m].TFW-dra[m].RFW;
+    scanch=(dra[m].RFW>=lo && dra[m].RFW<=lo+(n-1)*step ? (int)((dra[m].RFW-lo)/step) : -1);
+    scannext=-1;
+int k=scanNext(scanch);
+    if (k<0) {
+       pthread_mutex_unlock(&mtx);
+       return -1;
+    }
+    trate=usec();
+    nrate=0;
+    scanTune(k);
+    armTimer();
+    pthread_mutex_unlock(&mtx);
+   (TRACE>=0x01 ? fprintf(stderr,"%s:scanRange() scanning %ld..%ld Hz step %ld Hz, %d channels\n",PROGRAMID,lo,lo+(n-1)*step,step,scann) : _NOP);
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+// scanMemory  sweep the bank slots holding a frequency and not marked to skip
+//--------------------------------------------------------------------------------------------------
+int DRA818V::scanMemory() {
+
+    pthread_mutex_lock(&mtx);
+    if (keyed()==true) {
+       pthread_mutex_unlock(&mtx);
+       return -1;
+    }
+    if (scan!=DRA_SCAN_OFF) {scanAdopt();}
+    scanmem=true;
+    scanscope=false;
+    scann=DRABANK;
+    scanch=m;
+    scannext=-1;
+int k=scanNext(scanch);
+    if (k<0) {
+       pthread_mutex_unlock(&mtx);
+       return -1;
+    }
+    trate=usec();
+    nrate=0;
+    scanTune(k);
+    armTimer();
+    pthread_mutex_unlock(&mtx);
+   (TRACE>=0x01 ? fprintf(stderr,"%s:scanMemory() scanning the channel bank\n",PROGRAMID) : _NOP);
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+// scopeStart  band scope of DRASCOPEBINS channels step (Hz) apart centered on the one in use, the
+// bins already in the cache are shown with the first event; stopScan() returns to the channel
+//--------------------------------------------------------------------------------------------------
+int DRA818V::scopeStart(long step) {
+
+    if (step<=0) return -1;
+
+    pthread_mutex_lock(&mtx);
+    if (keyed()==true) {
+       pthread_mutex_unlock(&mtx);
+       return -1;
+    }
+    if (scan!=DRA_SCAN_OFF) {scanAdopt();}
+    scanmem=false;
+    scanscope=true;
+    scanlo=dra[m].RFW-(DRASCOPEBINS/2)*step;
+    scanstep=step;
+    scann=DRASCOPEBINS;
+    scanofs=dra[m].TFW-dra[m].RFW;
+    scanch=-1;
+    scannext=-1;
+    scopeLoad();
+    scopen=scopeFrame();
+    scopek=0;
+    trate=usec();
+    nrate=0;
+    scanTune(scanNext(scanch));
+    scanEvent();
+    armTimer();
+    pthread_mutex_unlock(&mtx);
+   (TRACE>=0x01 ? fprintf(stderr,"%s:scopeStart() scope %ld..%ld Hz step %ld Hz, %d bins per event\n",PROGRAMID,scanlo,scanlo+(DRASCOPEBINS-1)*step,step,scopen) : _NOP);
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+// stopScan  the channel being listened becomes the one in use
+//--------------------------------------------------------------------------------------------------
+void DRA818V::stopScan() {
+
+    pthread_mutex_lock(&mtx);
+    if (scan!=DRA_SCAN_OFF) {
+       scanAdopt();
+       scan=DRA_SCAN_OFF;
+       scanEvent();
+       armTimer();
+      (TRACE>=0x01 ? fprintf(stderr,"%s:stopScan() scan stopped at channel(%d) f(%ld)\n",PROGRAMID,scanch,dra[m].RFW) : _NOP);
+       scanscope=false;
+    }
+    pthread_mutex_unlock(&mtx);
+}
+//---------------------------------------------------------------------------------------------------
+// skipScan  leave the channel being listened (locking it out if asked) and resume at once
+//--------------------------------------------------------------------------------------------------
+void DRA818V::skipScan(bool lock) {
+
+    pthread_mutex_lock(&mtx);
+    if (scan!=DRA_SCAN_OFF && scanscope==false) {
+       if (lock==true) {(scanmem==true ? setSkip(scanch,true) : setLockout(scanch,true));}
+       int k=scanNext(scanch);
+       if (k<0) {
+          scanAdopt();
+          scan=DRA_SCAN_OFF;
+       } else {
+          trate=usec();
+          nrate=0;
+          scanTune(k);
+       }
+       scanEvent();
+       armTimer();
+    }
+    pthread_mutex_unlock(&mtx);
+}
+//---------------------------------------------------------------------------------------------------
+// setLockout / getLockout  channels a range scan skips, numbered from the start of the range
+//--------------------------------------------------------------------------------------------------
+void DRA818V::setLockout(int ch,bool v) {
+
+    if (ch<0 || ch>=DRASCANMAX) return;
+    if (v==true) {
+       lockout[ch>>3]|=(unsigned char)(1<<(ch&7));
+    } else {
+       lockout[ch>>3]&=(unsigned char)~(1<<(ch&7));
+    }
+}
+//--------------------------------------------------------------------------------------------------
+bool DRA818V::getLockout(int ch) {
+
+    if (ch<0 || ch>=DRASCANMAX) return false;
+    return (lockout[ch>>3] & (1<<(ch&7)))!=0;
+}
+//---------------------------------------------------------------------------------------------------
+// setSkip / getSkip  bank slots a bank scan skips, kept with the channel by store()
+//--------------------------------------------------------------------------------------------------
+void DRA818V::setSkip(byte c,bool v) {
+
+    if (c>=DRABANK) return;
+    dra[c].skip=v;
+}
+//--------------------------------------------------------------------------------------------------
+bool DRA818V::getSkip(byte c) {
+
+    if (c>=DRABANK) return false;
+    return dra[c].skip;
+}
+//---------------------------------------------------------------------------------------------------
+// scanFreq  receive frequency (Hz) of a scan channel, or of the one being listened
+//--------------------------------------------------------------------------------------------------
+long DRA818V::scanFreq(int ch) {
+
+    if (ch<0 || ch>=scann) return dra[m].RFW;
+    return (scanmem==true ? dra[ch].RFW : scanlo+(long)ch*scanstep);
+}
+//--------------------------------------------------------------------------------------------------
+long DRA818V::scanFreq() {
+
+    if (scan==DRA_SCAN_OFF) return dra[m].RFW;
+    return scanFreq(scanch);
+}
+//---------------------------------------------------------------------------------------------------
+// rxFreq  receive frequency (Hz) the chip is listening to, the one of the last GROUP written (a scan
+// channel, the priority one or the channel in use); lock free, safe to call from a GPIO interrupt
+//--------------------------------------------------------------------------------------------------
+long DRA818V::rxFreq() {
+
+    return rxf.load();
+}
+//---------------------------------------------------------------------------------------------------
+// scanNext  next channel after ch not locked out (and holding a frequency on a bank scan), -1 if none;
+// on a band scope the bin measured longest ago other than ch
+//--------------------------------------------------------------------------------------------------
+int DRA818V::scanNext(int ch) {
+
+    if (scanscope==true) {
+       int k=(ch==0 ? 1 : 0);
+       for (int i=0;i<scann;i++) {
+           if (i!=ch && tbin[i]<tbin[k]) {k=i;}
+       }
+       return k;
+    }
+
+    for (int i=1;i<=scann;i++) {
+        int k=(ch+i+scann)%scann;
+        if (scanmem==true && (dra[k].RFW==0 || dra[k].skip==true)) continue;
+        if (scanmem==false && getLockout(k)==true) continue;
+        return k;
+    }
+    return -1;
+}
+//---------------------------------------------------------------------------------------------------
+// scanPrepare  encode the GROUP frame of a range channel in the DRASCAN slot, done while the
+// previous channel is being listened so the retune costs only the write
+//--------------------------------------------------------------------------------------------------
+void DRA818V::scanPrepare(int ch) {
+
+    if (scanmem==true) return;
+    memcpy(&dra[DRASCAN],&dra[m],sizeof(struct DRA));
+    dra[DRASCAN].RFW=scanFreq(ch);
+    dra[DRASCAN].TFW=dra[DRASCAN].RFW+scanofs;
+    encode(DRASCAN);
+    scannext=ch;
+}
+//---------------------------------------------------------------------------------------------------
+// scanTune  write the GROUP of a channel, the dwell starts when the chip acknowledges it (when the
+// same frame is still in flight its own reply does)
+//--------------------------------------------------------------------------------------------------
+void DRA818V::scanTune(int ch) {
+
+    if (scanmem==false && scannext!=ch) {scanPrepare(ch);}
+
+char* s=(scanmem==true ? frame(ch,DRA_CMD_GROUP) : dra[DRASCAN].group);
+    scanch=ch;
+    scan=DRA_SCAN_TUNE;
+    scanasked=false;
+    tscan=usec();
+   (TRACE>=0x03 ? fprintf(stderr,"%s:scanTune() channel(%d) Frame[%s]\n",PROGRAMID,ch,s) : _NOP);
+    if (queueCommand(s,DRA_LANE_TUNE)==-2 && strcmp(shadow[DRA_CMD_GROUP],s)==0) {
+       scanReply(DRA_CMD_GROUP,0);          // the chip is on that channel already
+    }
+}
+//---------------------------------------------------------------------------------------------------
+// scanDecide  act on the signal status of the channel, an empty one is left right away
+//--------------------------------------------------------------------------------------------------
+void DRA818V::scanDecide(bool busy) {
+
+unsigned long long t=usec();
+
+    if (scan==DRA_SCAN_DWELL) {
+       scanlat.record((unsigned long)(t-tscan));
+       scanned++;
+       nrate++;
+       if (busy==true) {
+          scan=DRA_SCAN_HOLD;
+          scanstops++;
+          tsample=t+(unsigned long long)DRAPOLLFAST*1000;
+         (TRACE>=0x02 ? fprintf(stderr,"%s:scanDecide() signal at channel(%d) f(%ld), scan stopped\n",PROGRAMID,scanch,scanFreq(scanch)) : _NOP);
+          scanEvent();
+          return;
+       }
+       int k=scanNext(scanch);
+       if (k<0) {
+          scanAdopt();
+          scan=DRA_SCAN_OFF;
+          scanEvent();
+          return;
+       }
+       scanTune(k);
+       return;
+    }
+
+    if (scan==DRA_SCAN_HOLD && busy==false) {
+       scan=DRA_SCAN_HANG;
+       tscan=t+(unsigned long long)hang*1000;
+       scanEvent();
+       return;
+    }
+    if (scan==DRA_SCAN_HANG && busy==true) {
+       scan=DRA_SCAN_HOLD;
+       scanEvent();
+    }
+}
+//---------------------------------------------------------------------------------------------------
+// scanReply  a command completed (rc -1 on timeout), call with mtx held; RSSI replies asked for
+// before the channel was written are ignored, and so is a GROUP other than the one of the channel
+// (the channel in use replayed after a resync), the channel is written again instead
+//--------------------------------------------------------------------------------------------------
+void DRA818V::scanReply(byte type,int rc) {
+
+    if (scan==DRA_SCAN_OFF) return;
+
+    if (scan==DRA_SCAN_TUNE) {
+       if (type!=DRA_CMD_GROUP) return;
+       char* s=(scanmem==true ? frame(scanch,DRA_CMD_GROUP) : dra[DRASCAN].group);
+       if (rc!=0 || strcmp(shadow[DRA_CMD_GROUP],s)!=0) {
+          scanTune(scanch);
+          return;
+       }
+       scan=DRA_SCAN_DWELL;
+
+//*--- The RSSI? goes out ahead by a typical round trip so its reply lands as the dwell ends,
+//*--- the frame of the next channel is encoded meanwhile
+
+       unsigned long long w=(unsigned long long)(scanscope==true ? DRASCOPEDWELL : dwell)*1000;
+       unsigned long long r=(lat[DRA_CMD_RSSI].count>0 ? lat[DRA_CMD_RSSI].percentile(50.0) : 0);
+       tsample=usec()+(r<w ? w-r : 0);
+       int k=scanNext(scanch);
+       if (k>=0) {scanPrepare(k);}
+       return;
+    }
+
+    if (type!=DRA_CMD_RSSI) return;
+    if (scan==DRA_SCAN_DWELL && scanasked==false) return;
+    if (scanscope==true) {
+       if (scan==DRA_SCAN_DWELL) {scopeRecord(rc);}
+       scanDecide(false);
+       return;
+    }
+    scanDecide(rc>=scanrssi || getWord(RSW,SQ)==true);
+}
+//---------------------------------------------------------------------------------------------------
+// scanService  scanner deadlines, called from service() with mtx held
+//--------------------------------------------------------------------------------------------------
+void DRA818V::scanService() {
+
+    if (scan==DRA_SCAN_OFF) return;
+    if (hs!=DRA_HS_READY || keyed()==true) return;
+
+unsigned long long t=usec();
+
+    if ((scan==DRA_SCAN_TUNE || scan==DRA_SCAN_DWELL) && t>=trate+1000000) {
+       scanrate=(float)(nrate*1000000.0/(t-trate));
+       trate=t;
+       nrate=0;
+       scanEvent();
+    }
+
+    if (scan==DRA_SCAN_HANG && t>=tscan) {
+       int k=scanNext(scanch);
+       if (k<0) {
+          scanAdopt();
+          scan=DRA_SCAN_OFF;
+       } else {
+          trate=t;
+          nrate=0;
+          scanTune(k);
+       }
+       scanEvent();
+       return;
+    }
+
+    if ((scan==DRA_SCAN_DWELL && scanasked==false) || scan==DRA_SCAN_HOLD || scan==DRA_SCAN_HANG) {
+       if (t<tsample) return;
+       if (scan==DRA_SCAN_DWELL) {
+          scanasked=true;
+       } else {
+          tsample=t+(unsigned long long)DRAPOLLFAST*1000;
+       }
+       queueCommand((char*)"RSSI?",DRA_LANE_POLL);
+    }
+}
+//---------------------------------------------------------------------------------------------------
+// scanAdopt  the channel being listened becomes the one in use, a band scope instead returns to the
+// channel it was centered on; a bank slot is copied into m so the VFO never writes over it; call
+// with mtx held
+//--------------------------------------------------------------------------------------------------
+void DRA818V::scanAdopt() {
+
+    if (scanscope==true) {
+       queueCommand(frame(m,DRA_CMD_GROUP),DRA_LANE_TUNE);
+       return;
+    }
+    if (scanch<0 || scanch>=scann) return;
+
+    if (scanmem==false) {
+       dra[m].RFW=scanFreq(scanch);
+       dra[m].TFW=dra[m].RFW+scanofs;
+       dra[m].dirty=true;
+       queueCommand(frame(m,DRA_CMD_GROUP),DRA_LANE_TUNE);
+       return;
+    }
+
+    if (scanch!=m) {
+       bool k=dra[m].skip;
+       memcpy(&dra[m],&dra[scanch],sizeof(struct DRA));
+       dra[m].skip=k;
+    }
+    queueCommand(frame(m,DRA_CMD_GROUP),DRA_LANE_TUNE);
+    queueCommand(frame(m,DRA_CMD_VOLUME),DRA_LANE_TUNE);
+    queueCommand(frame(m,DRA_CMD_FILTER),DRA_LANE_TUNE);
+}
+//---------------------------------------------------------------------------------------------------
+// post  queue an event for processCommand() and wake up the application if it sleeps waiting one
+//--------------------------------------------------------------------------------------------------
+void DRA818V::post(DRA818V_event e) {
+
+    events.push(e);
+    if (notify!=nullptr) {notify->ring();}
+}
+//---------------------------------------------------------------------------------------------------
+// scanEvent  let the application know the scanner changed state
+//--------------------------------------------------------------------------------------------------
+void DRA818V::scanEvent() {
+
+DRA818V_event e;
+    e.type=DRA_EVT_SCAN;
+    e.rc=scan;
+    e.us=scanch;
+    post(e);
+}
+//---------------------------------------------------------------------------------------------------
+// scopeLoad  fill the scope bins from the cache, call with mtx held
+//--------------------------------------------------------------------------------------------------
+void DRA818V::scopeLoad() {
+
+    for (int i=0;i<DRASCOPEBINS;i++) {
+        scope[i]=-1;
+        tbin[i]=0;
+        long f=scanFreq(i);
+        for (int j=0;j<DRASCOPECACHE;j++) {
+            if (cache[j].f==f) {
+               scope[i]=cache[j].rssi;
+               tbin[i]=cache[j].t;
+               break;
             }
-           (TRACE>=0x03 ? fprintf(stderr,"%s:parseCommand(): RSSI(%5.0f)\n",PROGRAMID,r) : _NOP);
-         }
-       } 
+        }
+    }
+}
+//---------------------------------------------------------------------------------------------------
+// scopeRecord  keep the RSSI of the bin being listened (rc -1 on timeout keeps the previous one) in
+// the scope and in the cache, replacing the oldest reading; an event goes out every scopen bins
+//--------------------------------------------------------------------------------------------------
+void DRA818V::scopeRecord(int rc) {
+
+    if (scanch<0 || scanch>=DRASCOPEBINS) return;
+
+unsigned long long t=usec();
+    if (rc>=0) {scope[scanch]=rc;}
+    tbin[scanch]=t;
+
+long f=scanFreq(scanch);
+int  k=0;
+    for (int j=0;j<DRASCOPECACHE;j++) {
+        if (cache[j].f==f) {k=j; break;}
+        if (cache[j].t<cache[k].t) {k=j;}
+    }
+    cache[k].f=f;
+    cache[k].rssi=scope[scanch];
+    cache[k].t=t;
+
+    if (++scopek>=scopen) {
+       scopek=0;
+       scopen=scopeFrame();
+       scanEvent();
+    }
+}
+//---------------------------------------------------------------------------------------------------
+// scopeFrame  bins that fit in DRASCOPEFRAME ms at the round trips measured so far, each one costs a
+// GROUP round trip plus the longest of the dwell and the RSSI round trip
+//--------------------------------------------------------------------------------------------------
+int DRA818V::scopeFrame() {
+
+unsigned long g=(lat[DRA_CMD_GROUP].count>0 ? lat[DRA_CMD_GROUP].percentile(50.0) : 0);
+unsigned long r=(lat[DRA_CMD_RSSI].count>0 ? lat[DRA_CMD_RSSI].percentile(50.0) : 0);
+unsigned long w=DRASCOPEDWELL*1000;
+    if (g==0 || r==0) return 1;
+int n=(int)((unsigned long)DRASCOPEFRAME*1000/(g+(r>w ? r : w)));
+    if (n<1) {n=1;}
+    if (n>DRASCOPEBINS) {n=DRASCOPEBINS;}
+    return n;
+}
+//---------------------------------------------------------------------------------------------------
+// watchStart  look at bank slot c every ms, the first look comes one interval from now
+//--------------------------------------------------------------------------------------------------
+int DRA818V::watchStart(byte c,int ms) {
+
+    if (c>=DRABANK || ms<=0) return -1;
+
+    pthread_mutex_lock(&mtx);
+    if (c==m || dra[c].RFW==0) {
+       pthread_mutex_unlock(&mtx);
+       return -1;
+    }
+    if (watch==DRA_WATCH_LOOK || watch==DRA_WATCH_HOLD) {watchLeave();}
+    if (watch==DRA_WATCH_OFF) {watch=DRA_WATCH_MAIN;}
+    prio=c;
+    prioms=ms;
+    tprio=usec()+(unsigned long long)ms*1000;
+    tsampled=0;
+    watchEvent();
+    armTimer();
+    pthread_mutex_unlock(&mtx);
+   (TRACE>=0x01 ? fprintf(stderr,"%s:watchStart() priority channel(%d) f(%ld) every %d ms\n",PROGRAMID,c,dra[c].RFW,ms) : _NOP);
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+// watchStop  end the priority watch, back to the channel in use if away from it
+//--------------------------------------------------------------------------------------------------
+void DRA818V::watchStop() {
+
+    pthread_mutex_lock(&mtx);
+    if (watch!=DRA_WATCH_OFF) {
+       if (watch==DRA_WATCH_LOOK || watch==DRA_WATCH_HOLD) {watchLeave();}
+       watch=DRA_WATCH_OFF;
+       watchEvent();
+       armTimer();
+      (TRACE>=0x01 ? fprintf(stderr,"%s:watchStop() priority watch stopped\n",PROGRAMID) : _NOP);
+    }
+    pthread_mutex_unlock(&mtx);
+}
+//---------------------------------------------------------------------------------------------------
+// skipWatch  leave a held priority channel now, the next look comes one interval later
+//--------------------------------------------------------------------------------------------------
+void DRA818V::skipWatch() {
+
+    pthread_mutex_lock(&mtx);
+    if (watch==DRA_WATCH_HOLD) {
+       watchLeave();
+       tprio=usec()+(unsigned long long)prioms*1000;
+       watchEvent();
+       armTimer();
+    }
+    pthread_mutex_unlock(&mtx);
+}
+//---------------------------------------------------------------------------------------------------
+// watchLeave  write the GROUP of the channel in use back, call with mtx held; with the link down
+// nothing is written, the resync replays the channel in use once the handshake completes
+//--------------------------------------------------------------------------------------------------
+void DRA818V::watchLeave() {
+
+    prioon=false;
+    if (hs!=DRA_HS_READY) {
+       watch=DRA_WATCH_MAIN;
+       return;
+    }
+    watch=DRA_WATCH_BACK;
+    if (queueCommand(frame(m,DRA_CMD_GROUP),DRA_LANE_WATCH)==-2) {
+       gap.record((unsigned long)(usec()-tlook));  // the priority GROUP was withdrawn before being sent
+       watch=DRA_WATCH_MAIN;
+    }
+}
+//---------------------------------------------------------------------------------------------------
+// watchReply  a command completed (rc -1 on timeout), call with mtx held; the GROUP acknowledged is
+// told apart by the shadow since the application may retune the channel in use meanwhile. A look
+// decides on the RSSI alone, the squelch line seen by the application may still be the one of the
+// channel in use; a held channel counts the squelch line too
+//--------------------------------------------------------------------------------------------------
+void DRA818V::watchReply(byte type,int rc) {
+
+    if (watch==DRA_WATCH_OFF || watch==DRA_WATCH_MAIN) return;
+    if (scan!=DRA_SCAN_OFF) {                // the scanner owns the chip, it retunes the channel in use when done
+       watch=DRA_WATCH_MAIN;
+       prioon=false;
        return;
     }
 
-    if (strstr(commandQueue,"S=") != NULL) {
+unsigned long long t=usec();
+
+    if (type==DRA_CMD_GROUP) {
+       if (watch==DRA_WATCH_LOOK && prioon==false) {
+          if (rc!=0) {watchLeave(); return;}
+          if (strcmp(shadow[DRA_CMD_GROUP],dra[prio].group)!=0) return;
+          prioon=true;
+          unsigned long long w=(unsigned long long)DRAPRIODWELL*1000;
+          unsigned long long r=(lat[DRA_CMD_RSSI].count>0 ? lat[DRA_CMD_RSSI].percentile(50.0) : 0);
+          tpsample=t+(r<w ? w-r : 0);
+          return;
+       }
+       if (watch==DRA_WATCH_BACK) {
+          if (rc!=0) {watchLeave(); return;}
+          if (strcmp(shadow[DRA_CMD_GROUP],dra[m].group)!=0) return;
+          gap.record((unsigned long)(t-tlook));
+          watch=DRA_WATCH_MAIN;
+       }
+       return;
+    }
+
+    if (type!=DRA_CMD_RSSI) return;
+
+    if (watch==DRA_WATCH_LOOK) {
+       if (prioasked==false) return;
+       looks++;
+       if (tsampled!=0) {revisit.record((unsigned long)(t-tsampled));}
+       tsampled=t;
+       if (rc>=scanrssi) {
+          watch=DRA_WATCH_HOLD;
+          priostops++;
+          tgone=0;
+          tpsample=t+(unsigned long long)DRAPOLLFAST*1000;
+         (TRACE>=0x02 ? fprintf(stderr,"%s:watchReply() priority channel(%d) busy RSSI(%d), holding\n",PROGRAMID,prio,rc) : _NOP);
+          watchEvent();
+          return;
+       }
+       watchLeave();
+       return;
+    }
+
+    if (watch==DRA_WATCH_HOLD) {
+       tsampled=t;
+       if (rc>=scanrssi || getWord(RSW,SQ)==true) {
+          tgone=0;
+          return;
+       }
+       if (tgone==0) {tgone=t;}
+       if (t-tgone>=(unsigned long long)hang*1000) {
+          watchLeave();
+          tprio=t+(unsigned long long)prioms*1000;
+          watchEvent();
+       }
+    }
+}
+//---------------------------------------------------------------------------------------------------
+// watchService  priority watch deadlines, called from service() with mtx held; no looks while
+// transmitting, scanning or with the link down (the resync restores the channel in use)
+//--------------------------------------------------------------------------------------------------
+void DRA818V::watchService() {
+
+    if (watch==DRA_WATCH_OFF) return;
+    if (hs!=DRA_HS_READY) {
+       if (watch!=DRA_WATCH_MAIN) {
+          watch=DRA_WATCH_MAIN;
+          prioon=false;
+          watchEvent();
+       }
+       return;
+    }
+    if (keyed()==true || scan!=DRA_SCAN_OFF) return;
+
+unsigned long long t=usec();
+
+    if (watch==DRA_WATCH_MAIN) {
+       if (t<tprio) return;
+       tprio+=(unsigned long long)prioms*1000;             // fixed cadence, a late look does not shift the next ones
+       if (tprio<=t) {tprio=t+(unsigned long long)prioms*1000;}
+       watch=DRA_WATCH_LOOK;
+       if (keying.load()==true) {                           // the mic keyed as the look was starting
+          watch=DRA_WATCH_MAIN;
+          return;
+       }
+       prioon=false;
+       prioasked=false;
+       tlook=t;
+       if (queueCommand(frame(prio,DRA_CMD_GROUP),DRA_LANE_WATCH)==-2) {
+          watchReply(DRA_CMD_GROUP,0);                      // the chip is on the priority channel already
+       }
+       return;
+    }
+
+    if (watch==DRA_WATCH_LOOK && t>=tlook+(unsigned long long)2*DRATIMEOUT*1000) {
+       watchLeave();                                        // the look was overtaken by a retune
+       return;
+    }
+
+    if ((watch==DRA_WATCH_LOOK && prioon==true && prioasked==false) || watch==DRA_WATCH_HOLD) {
+       if (t<tpsample) return;
+       if (watch==DRA_WATCH_LOOK) {
+          prioasked=true;
+       } else {
+          tpsample=t+(unsigned long long)DRAPOLLFAST*1000;
+       }
+       queueCommand((char*)"RSSI?",DRA_LANE_WATCH);
+    }
+}
+//---------------------------------------------------------------------------------------------------
+// watchEvent  let the application know the priority watch changed state
+//--------------------------------------------------------------------------------------------------
+void DRA818V::watchEvent() {
+
+DRA818V_event e;
+    e.type=DRA_EVT_WATCH;
+    e.rc=watch;
+    e.us=prio;
+    post(e);
+}
+//---------------------------------------------------------------------------------------------------
+// setPoll  change the RSSI polling interval (ms, 0 stops polling), a shorter one applies at once
+//--------------------------------------------------------------------------------------------------
+void DRA818V::setPoll(int ms) {
 
+    if (ms==pollms) return;
+    pthread_mutex_lock(&mtx);
+   (TRACE>=0x02 ? fprintf(stderr,"%s:setPoll() RSSI polling every %d ms\n",PROGRAMID,ms) : _NOP);
+unsigned long long t=usec();
+    if (ms>0 && (pollms==0 || tpoll>t+(unsigned long long)ms*1000)) {
+       tpoll=t+(unsigned long long)ms*1000;
     }
+    pollms=ms;
+    armTimer();
+    pthread_mutex_unlock(&mtx);
 }
 //---------------------------------------------------------------------------------------------------
 // processCommand Implementation
+// hand the completed commands to the application callbacks, called from the main loop
 //--------------------------------------------------------------------------------------------------
 void DRA818V::processCommand() {
-char buffer[128];
-char* c;
-
-
-//    (TRACE>=0x03 ? fprintf(stderr,"%s:processCommand() DRA818 Message status(%s)\n",PROGRAMID,BOOL2CHAR(d[pR].active)) : _NOP);
-//
-//     if (d[pR].active==true) {
-//         d[pR].active=false;
-//        (TRACE>=0x03 ? fprintf(stderr,"%s:processCommand() DRA818 Sending command(%s)\n",PROGRAMID,d[pR].command) : _NOP);
-//
-//         strcpy(buffer,d[pR].command);
-//         strcat(buffer,"\r\n");
-//         write(fd,buffer,strlen(buffer)); 
-//         (TRACE>=0x03 ? fprintf(stderr,"%s:processCommand() Write Command[%s]\n",PROGRAMID,d[pR].command) : _NOP);
-//         usleep(100000);
-//     }
-
-c=(char*)malloc(16);
-
-int  n=read(fd,buffer,128);
-     if(n==0) return;
-     (TRACE>=0x03 ? fprintf(stderr,"processCommand() read (%d) characters from serial in\n",n) : _NOP);
-     for (int i=0;i<n;i++) {
-         c[0]=buffer[i];
-         c[1]=0x00;
-         if (strcmp(c,"\r")!=0 && strcmp(c,"\n")!=0) {
-             commandQueue[pWrite]=buffer[i];
-             pWrite++;         
-             commandQueue[pWrite]=0x00;
-         } else {
-             if (strcmp(c,"\n")==0) {
-                commandQueue[pWrite]=0x00;
-                if (strlen(commandQueue)==0) {
-                    return;
-                }
-                (TRACE>=0x03 ? fprintf(stderr,"%s:processCommand() Response[%s]\n",PROGRAMID,commandQueue) : _NOP);
-                parseCommand();
-                pWrite=0x00;
-                //d[pR].serviced=true;
-                //if(strlen(d[pR].command)!=0) {
-                //  (TRACE>=0x02 ? fprintf(stderr,"%s:processCommand() Command(%s) Response(%s) serviced rc(%s)\n",PROGRAMID,d[pR].command,d[pR].response,d[pR].rc) : _NOP);
-                //  if (strcmp(d[pR].command,"AT+DMOCONNECT")==0 && strcmp(d[pR].response,"+DMOCONNECT:0")==0) {
-                //     (TRACE>=0x02 ? fprintf(stderr,"%s:processCommand() Response to DMOCONNECT command recognized, receiver online\n",PROGRAMID) : _NOP);
-                //     setWord(&MSW,RUN,true);
-                //  }
-                //  pR++;
-                //  if (pR>15) {
-                //      pR=0;
-                //  }
-                //}
-              }
-         }
+
+DRA818V_event e;
+
+     if (loop==nullptr) {
+        service();
+     }
+
+int  q=sqin.exchange(-1);           // squelch edge posted by the ISR, applied here under the lock
+     if (q>=0) {setSQ(q==1);}
+
+     while (events.pop(&e)==true) {
+        if (e.type==DRA_EVT_HANDSHAKE) {
+          (TRACE>=0x02 ? fprintf(stderr,"%s:processCommand(): handshake %s after %ld us\n",PROGRAMID,(e.rc==0 ? "completed" : "failed"),e.us) : _NOP);
+           if (changeRUN != NULL) {
+              changeRUN();
+           }
+           continue;
+        }
+        if (e.type==DRA_EVT_SCAN) {
+          (TRACE>=0x02 ? fprintf(stderr,"%s:processCommand(): scan state(%d) channel(%ld) rate(%.1f ch/s)\n",PROGRAMID,e.rc,e.us,scanrate) : _NOP);
+           if (changeSCAN != NULL) {
+              changeSCAN();
+           }
+           continue;
+        }
+        if (e.type==DRA_EVT_WATCH) {
+          (TRACE>=0x02 ? fprintf(stderr,"%s:processCommand(): watch state(%d) priority channel(%ld)\n",PROGRAMID,e.rc,e.us) : _NOP);
+           if (changeWATCH != NULL) {
+              changeWATCH();
+           }
+           continue;
+        }
+        if (e.type==DRA_CMD_RSSI && e.rc>=0) {
+          (TRACE>=0x03 ? fprintf(stderr,"%s:processCommand(): RSSI(%d) latency(%ld us)\n",PROGRAMID,e.rc,e.us) : _NOP);
+           if (changeRSSI != NULL) {
+              changeRSSI((float)e.rc);
+           }
+           if (changeRSSIid != NULL) {
+              changeRSSIid(id,(float)e.rc);
+           }
+        }
      }
 }
 //---------------------------------------------------------------------------------------------------
-// send data, actually queue but not send a command
+// I/O thread handlers
+//--------------------------------------------------------------------------------------------------
+void DRA818V::onSerial(void* p,uint32_t e) {
+DRA818V* r=(DRA818V*)p;
+    if ((e & (EPOLLHUP|EPOLLERR))!=0 && r->hup==false) {
+       pthread_mutex_lock(&r->mtx);
+      (r->TRACE>=0x00 ? fprintf(stderr,"%s:onSerial() serial interface(%s) hung up\n",r->PROGRAMID,r->portname) : _NOP);
+       r->hup=true;
+       if (r->loop!=nullptr) {r->loop->del(r->fd);}
+       if (r->hs==DRA_HS_READY) {r->resync("port hung up");}
+       pthread_mutex_unlock(&r->mtx);
+    }
+    r->service();
+}
+//---------------------------------------------------------------------------------------------------
+void DRA818V::onTimer(void* p,uint32_t e) {
+DRA818V* r=(DRA818V*)p;
+uint64_t v;
+    if (read(r->tfd,&v,sizeof(v))<0) {v=0;}
+    r->service();
+}
+//---------------------------------------------------------------------------------------------------
+// attach  service the serial port from the EventLoop thread, woken by replies and timeouts only
 //--------------------------------------------------------------------------------------------------
-void DRA818V::send_data(char* s) {
+int DRA818V::attach(EventLoop* l) {
 
-    strcpy(buffer,s);
+    if (l->add(fd,EPOLLIN,DRA818V::onSerial,this)<0 || l->add(tfd,EPOLLIN,DRA818V::onTimer,this)<0) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s::attach() unable to register with the I/O thread\n",PROGRAMID) : _NOP);
+       return -1;
+    }
+    loop=l;
+    service();
+   (TRACE>=0x01 ? fprintf(stderr,"%s::attach() serial interface(%s) serviced by the I/O thread\n",PROGRAMID,portname) : _NOP);
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+// armTimer  wake the I/O thread at the deadline of the command in flight, the next RSSI poll or
+// the next scanner deadline, whichever comes first, disarm when there is none
+//--------------------------------------------------------------------------------------------------
+void DRA818V::armTimer() {
+
+    if (tfd<0) return;
+
+unsigned long long w=0;
+    if (pR!=-1) {
+       w=d[pR].tsent+(unsigned long long)d[pR].timeout*1000;
+    }
+    if (pollms>0 && (w==0 || tpoll<w)) {
+       w=tpoll;
+    }
+    if (hs==DRA_HS_BACKOFF && (w==0 || tretry<w)) {
+       w=tretry;
+    }
+    if (((scan==DRA_SCAN_DWELL && scanasked==false) || scan==DRA_SCAN_HOLD || scan==DRA_SCAN_HANG) && (w==0 || tsample<w)) {
+       w=tsample;
+    }
+    if (scan==DRA_SCAN_HANG && (w==0 || tscan<w)) {
+       w=tscan;
+    }
+    if (watch==DRA_WATCH_MAIN && (w==0 || tprio<w)) {
+       w=tprio;
+    }
+    if (((watch==DRA_WATCH_LOOK && prioon==true && prioasked==false) || watch==DRA_WATCH_HOLD) && (w==0 || tpsample<w)) {
+       w=tpsample;
+    }
+    if (watch==DRA_WATCH_LOOK && (w==0 || tlook+(unsigned long long)2*DRATIMEOUT*1000<w)) {
+       w=tlook+(unsigned long long)2*DRATIMEOUT*1000;
+    }
+
+struct itimerspec t;
+    memset(&t,0,sizeof(t));
+    if (w!=0) {
+       t.it_value.tv_sec=w/1000000;
+       t.it_value.tv_nsec=(w%1000000)*1000;
+    }
+    timerfd_settime(tfd,TFD_TIMER_ABSTIME,&t,NULL);
+}
+//---------------------------------------------------------------------------------------------------
+// usec()  monotonic time in microseconds, used to expire commands and measure replies
+//--------------------------------------------------------------------------------------------------
+unsigned long long DRA818V::usec() {
+struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (unsigned long long)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
+//---------------------------------------------------------------------------------------------------
+// settled  the setting the chip will hold for a command type once the link is idle, that is the
+// one in flight if of the same type or else the last acknowledged, NULL when not known
+//--------------------------------------------------------------------------------------------------
+const char* DRA818V::settled(byte type) {
+
+    if (pR!=-1 && d[pR].type==type) {return d[pR].command;}
+    if (shadow[type][0]!=0x00) {return shadow[type];}
+    return NULL;
+}
+//---------------------------------------------------------------------------------------------------
+// queueCommand  place a command in the ring at the given priority lane, never blocks
+// returns the slot used, -1 if the ring is full or -2 if the chip already holds the setting
+//--------------------------------------------------------------------------------------------------
+int DRA818V::queueCommand(char* s,byte lane) {
+
+byte type=DRA_CMD_OTHER;
+    for (int j=0;j<(int)sizearray(REPLY);j++) {
+        if (strncmp(s,REPLY[j],strlen(REPLY[j]))==0) {
+           type=j;
+           break;
+        }
+    }
+
+//*--- Last writer wins, a group/volume/filter (or RSSI poll) still waiting in the ring
+//*--- is replaced in place by the newest one, so only the latest state reaches the chip
+
+//*--- A setting equal to what the chip holds (or is about to) is not sent, and a pending one
+//*--- made redundant by it is withdrawn
+
+const char* c=(type==DRA_CMD_GROUP || type==DRA_CMD_VOLUME || type==DRA_CMD_FILTER ? settled(type) : NULL);
+
+    if (type==DRA_CMD_GROUP || type==DRA_CMD_VOLUME || type==DRA_CMD_FILTER || type==DRA_CMD_RSSI) {
+       for (int i=0;i<DRAQUEUE;i++) {
+           if (d[i].active==true && d[i].sent==false && d[i].type==type) {
+              if (c!=NULL && strcmp(c,s)==0) {
+                 d[i].active=false;
+                 cmdSuppressed++;
+                (TRACE>=0x03 ? fprintf(stderr,"%s:queueCommand() slot(%d) withdrawn, chip holds Command[%s]\n",PROGRAMID,i,s) : _NOP);
+                 return -2;
+              }
+              strncpy(d[i].command,s,sizeof(d[i].command)-3);
+              d[i].command[sizeof(d[i].command)-3]=0x00;
+              d[i].tqueue=usec();
+              if (lane<d[i].lane) {d[i].lane=lane;}
+              coalesced++;
+             (TRACE>=0x03 ? fprintf(stderr,"%s:queueCommand() slot(%d) coalesced(%lu) Command[%s]\n",PROGRAMID,i,coalesced,s) : _NOP);
+              return i;
+           }
+       }
+    }
+
+    if (c!=NULL && strcmp(c,s)==0) {
+       cmdSuppressed++;
+      (TRACE>=0x03 ? fprintf(stderr,"%s:queueCommand() suppressed(%lu) unchanged Command[%s]\n",PROGRAMID,cmdSuppressed,s) : _NOP);
+       return -2;
+    }
+
+    for (int i=0;i<DRAQUEUE;i++) {
+        int k=(pW+i)%DRAQUEUE;
+        if (d[k].active==true) continue;
+
+        strncpy(d[k].command,s,sizeof(d[k].command)-3);
+        d[k].command[sizeof(d[k].command)-3]=0x00;
+        d[k].rc=-1;
+        d[k].type=type;
+        d[k].tqueue=usec();
+        d[k].lane=lane;
+        d[k].seq=seq++;
+        d[k].sent=false;
+        d[k].serviced=false;
+        d[k].timeout=DRATIMEOUT;
+        d[k].active=true;
+        pW=(k+1)%DRAQUEUE;
+       (TRACE>=0x03 ? fprintf(stderr,"%s:queueCommand() slot(%d) lane(%d) Command[%s]\n",PROGRAMID,k,lane,s) : _NOP);
+        dispatchCommand();
+        return k;
+    }
+
+   (TRACE>=0x00 ? fprintf(stderr,"%s:queueCommand() command ring full, Command[%s] dropped\n",PROGRAMID,s) : _NOP);
+    return -1;
+}
+//---------------------------------------------------------------------------------------------------
+// dispatchCommand  when the link is idle write the oldest command of the highest priority lane
+//--------------------------------------------------------------------------------------------------
+void DRA818V::dispatchCommand() {
+
+    if (pR!=-1) return;
+
+int k=-1;
+    for (int i=0;i<DRAQUEUE;i++) {
+        if (d[i].active==false || d[i].sent==true) continue;
+        if (hs!=DRA_HS_READY && d[i].lane!=DRA_LANE_PTT) continue;
+        if (k==-1 || d[i].lane<d[k].lane || (d[i].lane==d[k].lane && d[i].seq<d[k].seq)) {
+           k=i;
+        }
+    }
+    if (k==-1) {
+       armTimer();
+       return;
+    }
+
+    strcpy(buffer,d[k].command);
     strcat(buffer,"\r\n");
-    write(fd,buffer,strlen(buffer)); 
-   (TRACE>=0x03 ? fprintf(stderr,"%s:processCommand() Write Command[%s]\n",PROGRAMID,s) : _NOP);
-    usleep(100000);
+    if (write(fd,buffer,strlen(buffer))<0) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s:dispatchCommand() error %d writing Command[%s]: %s\n",PROGRAMID,errno,d[k].command,strerror(errno)) : _NOP);
+    }
+    if (d[k].type==DRA_CMD_GROUP) {rxf.store(rxHz(d[k].command));}
+    d[k].sent=true;
+    d[k].tsent=usec();
+    cmdSent++;
+    pR=k;
+    armTimer();
+   (TRACE>=0x03 ? fprintf(stderr,"%s:dispatchCommand() Write Command[%s]\n",PROGRAMID,d[k].command) : _NOP);
+
+}
+//---------------------------------------------------------------------------------------------------
+// completeCommand  a reply arrived, retire the command in flight if the reply belongs to it
+//--------------------------------------------------------------------------------------------------
+void DRA818V::completeCommand(DRA818V_msg* r) {
+
+    if (pR==-1 || (int)r->kind!=d[pR].type) {
+       (TRACE>=0x02 ? fprintf(stderr,"%s:completeCommand() unsolicited Response kind(%d) rc(%d) ignored\n",PROGRAMID,r->kind,r->rc) : _NOP);
+        unsolicited++;
+        noise++;
+       return;
+    }
 
-//    strcpy(d[pW].command,s);
-//    d[pW].active=true;
-//    d[pW].serviced=false;
-//    d[pW].timeout=2000;
-//    pW++;
-//    if (pW>15) {
-//        pW=0;
-//    }
+unsigned long long t=usec();
+unsigned long long l=t-d[pR].tsent;
+
+    d[pR].rc=r->rc;
+    d[pR].serviced=true;
+    d[pR].active=false;
+    if (r->rc==0) {
+       strcpy(shadow[d[pR].type],d[pR].command);
+    } else {
+       shadow[d[pR].type][0]=0x00;
+    }
+    if (r->kind==DRA_RPL_VERSION) {
+       char v[sizeof(version)];
+       framer.copy(r,v,sizeof(v));
+       if (version[0]!=0x00 && strcmp(v,version)!=0) {
+          resets++;
+         (TRACE>=0x00 ? fprintf(stderr,"%s:completeCommand() firmware changed from (%s) to (%s), chip replaced or reset\n",PROGRAMID,version,v) : _NOP);
+       }
+       strcpy(version,v);
+    }
+    misses=0;
+    noise=0;
+    if (d[pR].type==DRA_CMD_GROUP && (long)((t-d[pR].tqueue)/1000) > maxTuneLatency) {
+       maxTuneLatency=(t-d[pR].tqueue)/1000;
+    }
+    lat[d[pR].type].record((unsigned long)l);
+
+DRA818V_event e;
+    e.type=d[pR].type;
+    e.rc=r->rc;
+    e.us=(long)l;
+    if (e.type!=DRA_CMD_RSSI || watch!=DRA_WATCH_LOOK) {   // the priority channel is not for the meter
+       post(e);
+    }
+
+   (TRACE>=0x02 ? fprintf(stderr,"%s:completeCommand() Command(%s) serviced rc(%d) in %llu us\n",PROGRAMID,d[pR].command,d[pR].rc,l) : _NOP);
+    e.type=d[pR].type;
+    pR=-1;
+    handshake(e.type,(e.type==DRA_CMD_VERSION || e.rc==0));
+    scanReply(e.type,e.rc);
+    watchReply(e.type,e.rc);
+
+}
+//---------------------------------------------------------------------------------------------------
+// checkTimeout  give up the command in flight if its reply did not arrive in time
+//--------------------------------------------------------------------------------------------------
+void DRA818V::checkTimeout() {
+
+    if (pR==-1) return;
+    if (usec()-d[pR].tsent < (unsigned long long)d[pR].timeout*1000) return;
+
+   (TRACE>=0x00 ? fprintf(stderr,"%s:checkTimeout() Command[%s] timeout, no reply after %d ms\n",PROGRAMID,d[pR].command,d[pR].timeout) : _NOP);
+    d[pR].serviced=true;
+    d[pR].active=false;
+    d[pR].rc=-1;
+    shadow[d[pR].type][0]=0x00;              // the chip may or may not have taken it
+    timeouts[d[pR].type]++;
+    if (hs==DRA_HS_READY) {misses++;}
+
+DRA818V_event e;
+    e.type=d[pR].type;
+    e.rc=-1;
+    e.us=(long)(usec()-d[pR].tsent);
+    post(e);
+    pR=-1;
+    handshake(e.type,false);
+    scanReply(e.type,-1);
+    watchReply(e.type,-1);
+
+}
+//---------------------------------------------------------------------------------------------------
+// handshake  advance the startup sequence CONNECT, VERSION, TAIL as soon as each reply lands,
+// a step not answered is retried up to DRARETRY times; RUN is set only on a confirmed connect
+//--------------------------------------------------------------------------------------------------
+void DRA818V::handshake(byte type,bool ok) {
+
+const char* STEP[]={"","AT+DMOCONNECT","AT+VERSION","AT+SETTAIL=0"};
+const byte  WANT[]={DRA_CMD_OTHER,DRA_CMD_CONNECT,DRA_CMD_VERSION,DRA_CMD_TAIL};
+
+    if (hs<DRA_HS_CONNECT || hs>DRA_HS_TAIL || type!=WANT[hs]) return;
+
+DRA818V_event e;
+    e.type=DRA_EVT_HANDSHAKE;
+
+    if (ok==false) {
+       if (++retries<DRARETRY) {
+          cmdRetries++;
+         (TRACE>=0x01 ? fprintf(stderr,"%s:handshake() Command[%s] not answered, attempt(%d)\n",PROGRAMID,STEP[hs],retries+1) : _NOP);
+          queueCommand((char*)STEP[hs],DRA_LANE_PTT);
+          return;
+       }
+      (TRACE>=0x00 ? fprintf(stderr,"%s:handshake() Command[%s] failed after %d attempts, DRA818V not responding, retry in %d ms\n",PROGRAMID,STEP[hs],retries,backoff) : _NOP);
+       hs=DRA_HS_BACKOFF;
+       tretry=usec()+(unsigned long long)backoff*1000;
+       backoff=(backoff*2>DRABACKOFFMAX ? DRABACKOFFMAX : backoff*2);
+       if (getWord(MSW,RUN)==true) {
+          setWord(&MSW,RUN,false);
+          e.rc=-1;
+          e.us=(long)(usec()-tstart);
+          post(e);
+       }
+       return;
+    }
+
+    if (hs==DRA_HS_CONNECT) {
+       setWord(&MSW,RUN,true);
+      (TRACE>=0x01 ? fprintf(stderr,"%s:handshake() connection with DRA818V confirmed\n",PROGRAMID) : _NOP);
+    }
+
+    retries=0;
+    hs++;
+    if (hs<DRA_HS_READY) {
+       queueCommand((char*)STEP[hs],DRA_LANE_PTT);
+       return;
+    }
+
+    backoff=DRABACKOFF;
+    misses=0;
+    noise=0;
+    if (bootms<0) {
+       bootms=(long)((usec()-tstart)/1000);
+      (TRACE>=0x00 ? fprintf(stderr,"%s:handshake() DRA818V firmware(%s) ready in %ld ms\n",PROGRAMID,version,bootms) : _NOP);
+    } else {
+      (TRACE>=0x00 ? fprintf(stderr,"%s:handshake() DRA818V firmware(%s) resynchronized in %ld ms, restoring settings\n",PROGRAMID,version,(long)((usec()-tstart)/1000)) : _NOP);
+       replay();
+    }
+    e.rc=0;
+    e.us=(long)(usec()-tstart);
+    post(e);
+    dispatchCommand();
+
+}
+//---------------------------------------------------------------------------------------------------
+// checkLink  declare the link down when replies go missing or the line carries garbage, and start
+// a new handshake once the backoff expires; runs on the I/O thread, nothing here ever waits
+//--------------------------------------------------------------------------------------------------
+void DRA818V::checkLink() {
+
+    if (hs==DRA_HS_READY) {
+       if (misses>=DRAMISS) {resync("replies missing");}
+       else if (noise>=DRANOISE) {resync("line noise");}
+       return;
+    }
+
+    if (hs!=DRA_HS_BACKOFF || usec()<tretry) return;
+
+    if (hup==true && reopen()<0) {
+       tretry=usec()+(unsigned long long)backoff*1000;
+       backoff=(backoff*2>DRABACKOFFMAX ? DRABACKOFFMAX : backoff*2);
+       return;
+    }
+
+   (TRACE>=0x01 ? fprintf(stderr,"%s:checkLink() attempting handshake with DRA818V\n",PROGRAMID) : _NOP);
+    tstart=usec();
+    retries=0;
+    hs=DRA_HS_CONNECT;
+    queueCommand((char*)"AT+DMOCONNECT",DRA_LANE_PTT);
+}
+//---------------------------------------------------------------------------------------------------
+// reopen  open the port again after a hang up, the device may take a while to come back
+//--------------------------------------------------------------------------------------------------
+int DRA818V::reopen() {
+
+int n=open(portname,O_RDWR|O_NOCTTY|O_NONBLOCK);
+    if (n<0) {
+      (TRACE>=0x01 ? fprintf(stderr,"%s:reopen() %s not available yet, retry in %d ms\n",PROGRAMID,portname,backoff) : _NOP);
+       return -1;
+    }
+    close(fd);
+    fd=n;
+    set_interface_attribs(fd,B9600,0);
+    set_blocking(fd,0);
+    if (loop!=nullptr) {loop->add(fd,EPOLLIN,DRA818V::onSerial,this);}
+    hup=false;
+   (TRACE>=0x00 ? fprintf(stderr,"%s:reopen() serial interface(%s) open again\n",PROGRAMID,portname) : _NOP);
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+// resync  forget what the chip is believed to hold, flush the line and run the handshake again,
+// the settings are replayed once it completes; nothing still queued but a handshake step survives,
+// on a dead link each one would cost a timeout before the handshake, and a scan dwelling is tuned
+// again by the replay (its RSSI? is gone)
+//--------------------------------------------------------------------------------------------------
+void DRA818V::resync(const char* why) {
+
+   (TRACE>=0x00 ? fprintf(stderr,"%s:resync() link with DRA818V lost (%s), resynchronizing\n",PROGRAMID,why) : _NOP);
+    resyncs++;
+    memset(shadow,0,sizeof(shadow));
+    if (pR!=-1) {
+       d[pR].active=false;
+       pR=-1;
+    }
+    for (int i=0;i<DRAQUEUE;i++) {
+        if (d[i].type==DRA_CMD_CONNECT || d[i].type==DRA_CMD_VERSION || d[i].type==DRA_CMD_TAIL) continue;
+        d[i].active=false;
+    }
+    if (scan==DRA_SCAN_DWELL) {scan=DRA_SCAN_TUNE;}
+    tcflush(fd,TCIOFLUSH);
+    framer.reset();
+    misses=0;
+    noise=0;
+
+    setWord(&MSW,RUN,false);
+DRA818V_event e;
+    e.type=DRA_EVT_HANDSHAKE;
+    e.rc=-1;
+    e.us=0;
+    post(e);
+
+    backoff=DRABACKOFF;
+    tretry=usec();
+    hs=DRA_HS_BACKOFF;
+    checkLink();
+}
+//---------------------------------------------------------------------------------------------------
+// replay  queue the full desired state, the commands still pending coalesce with these
+//--------------------------------------------------------------------------------------------------
+void DRA818V::replay() {
+
+    queueCommand(frame(m,DRA_CMD_GROUP),DRA_LANE_TUNE);
+    queueCommand(frame(m,DRA_CMD_VOLUME),DRA_LANE_TUNE);
+    queueCommand(frame(m,DRA_CMD_FILTER),DRA_LANE_TUNE);
+}
+//---------------------------------------------------------------------------------------------------
+// send data, actually queue but not send a command
+//--------------------------------------------------------------------------------------------------
+void DRA818V::send_data(char* s,byte lane) {
+
+    pthread_mutex_lock(&mtx);
+    queueCommand(s,lane);
+    pthread_mutex_unlock(&mtx);
 
 }
 //---------------------------------------------------------------------------------------------------
@@ -403,12 +1821,16 @@ int n = read (fd, buffer, len);
 }
 
 //---------------------------------------------------------------------------------------------------
-// start operations
+// start operations, the port defaults to the serial UART where the DRA818V is wired
 //--------------------------------------------------------------------------------------------------
 int DRA818V::start() {
+     return start("/dev/ttyS0");
+}
+//--------------------------------------------------------------------------------------------------
+int DRA818V::start(const char* port) {
 
-     strcpy(portname,"/dev/ttyS0");
-     fd = open (portname, O_RDWR | O_NOCTTY | O_SYNC);
+     snprintf(portname,sizeof(portname),"%s",port);
+     fd = open (portname, O_RDWR | O_NOCTTY | O_NONBLOCK);
      if (fd < 0) {
         (TRACE>=0x00 ? fprintf(stderr,"%s::start() error %d opening %s: %s", PROGRAMID,errno, portname, strerror (errno)) : _NOP);
         return -1;
@@ -416,19 +1838,21 @@ int DRA818V::start() {
 
      set_interface_attribs (fd, B9600, 0);  // set speed to 115,200 bps, 8n1 (no parity)
      set_blocking (fd, 0);                // set no blocking
-     strcpy(command,"AT+DMOCONNECT");
-     this->send_data(command);
 
-     strcpy(command,"AT+VERSION");
-     this->send_data(command);
+     tfd=timerfd_create(CLOCK_MONOTONIC,TFD_NONBLOCK|TFD_CLOEXEC);
+
+//*--- Start the handshake, VERSION and SETTAIL follow each as soon as the previous reply lands
+//*--- whatever is queued meanwhile waits until the chip is READY
 
-     strcpy(command,"AT+SETTAIL=0");
-     this->send_data(command);
+     tstart=usec();
+     retries=0;
+     hs=DRA_HS_CONNECT;
+     strcpy(command,"AT+DMOCONNECT");
+     this->send_data(command,DRA_LANE_PTT);
 
      sendRSSI();
 
-     setWord(&MSW,RUN,true);
-    (TRACE>=0x00 ? fprintf(stderr,"%s::start() serial interface(%s) active\n",PROGRAMID,portname) : _NOP);
+    (TRACE>=0x00 ? fprintf(stderr,"%s::start() serial interface(%s) active, handshake started\n",PROGRAMID,portname) : _NOP);
 
     return 0;
 }
@@ -437,12 +1861,51 @@ int DRA818V::start() {
 //--------------------------------------------------------------------------------------------------
 void DRA818V::stop() {
 
+  if (loop!=nullptr) {
+     loop->del(fd);
+     loop->del(tfd);
+     loop=nullptr;
+  }
   close(fd);
+  if (tfd>=0) {close(tfd); tfd=-1;}
+ (TRACE>=0x00 ? stats(stderr) : _NOP);
  (TRACE>=0x00 ? fprintf(stderr,"%s::stop() connection with DRA818V chipset terminated\n",PROGRAMID) : _NOP);
 
   return;
 }
 //---------------------------------------------------------------------------------------------------
+// stats()  link statistics as key=value lines, latencies in microseconds
+//--------------------------------------------------------------------------------------------------
+int DRA818V::stats(FILE* f) {
+
+const char* NAME[DRA_CMDS]={"CONNECT","GROUP","VOLUME","FILTER","TAIL","VERSION","RSSI","OTHER"};
+
+    pthread_mutex_lock(&mtx);
+    fprintf(f,"# %s link statistics port=%s firmware=%s boot_ms=%ld\n",PROGRAMID,portname,version,bootms);
+    fprintf(f,"link sent=%lu suppressed=%lu coalesced=%lu retries=%lu unsolicited=%lu malformed=%lu overflow=%lu polls=%lu tune_worst_ms=%ld resyncs=%lu resets=%lu\n",
+            cmdSent,cmdSuppressed,coalesced,cmdRetries,unsolicited,framer.malformed,framer.overflow,polls,maxTuneLatency,resyncs,resets);
+    fprintf(f,"timeouts");
+    for (int i=0;i<DRA_CMDS;i++) {
+        fprintf(f," %s=%lu",NAME[i],timeouts[i]);
+    }
+    fprintf(f,"\n");
+    for (int i=0;i<DRA_CMDS;i++) {
+        if (lat[i].count==0) continue;
+        lat[i].print(f,NAME[i]);
+    }
+    if (scanned>0) {
+       fprintf(f,"scan channels=%lu stops=%lu rate=%.1f\n",scanned,scanstops,scanrate);
+       scanlat.print(f,"SCAN");
+    }
+    if (looks>0) {
+       fprintf(f,"watch slot=%d every=%d ms looks=%lu stops=%lu\n",prio,prioms,looks,priostops);
+       revisit.print(f,"REVISIT");
+       gap.print(f,"GAP");
+    }
+    pthread_mutex_unlock(&mtx);
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
 // set_interface_attribs()  CLASS Implementation
 //--------------------------------------------------------------------------------------------------
 int DRA818V::set_interface_attribs (int fd, int speed, int parity)
@@ -466,7 +1929,7 @@ int DRA818V::set_interface_attribs (int fd, int speed, int parity)
                                            // no canonical processing
            tty.c_oflag = 0;                // no remapping, no delays
            tty.c_cc[VMIN]  = 0;            // read doesn't block
-           tty.c_cc[VTIME] = 5;            // 0.5 seconds read timeout
+           tty.c_cc[VTIME] = 0;            // no read timeout, the I/O thread waits on epoll
 
            tty.c_iflag &= ~(IXON | IXOFF | IXANY); // shut off xon/xoff ctrl
 
@@ -498,19 +1961,140 @@ void DRA818V::set_blocking (int fd, int should_block)
            }
 
            tty.c_cc[VMIN]  = should_block ? 1 : 0;
-           tty.c_cc[VTIME] = 5;            // 0.5 seconds read timeout
+           tty.c_cc[VTIME] = 0;            // no read timeout, the I/O thread waits on epoll
 
            if (tcsetattr (fd, TCSANOW, &tty) != 0)
                    (TRACE>=0x00 ? fprintf(stderr,"error %d setting term attributes", errno) : _NOP);
 }
 //--------------------------------------------------------------------------------------------------
+// toHz  frequency coming as a float (genVFO) to integer Hz on the DRARASTER grid, a float only
+// resolves 16 Hz at 147 MHz so the value is rounded to the grid rather than truncated
+//--------------------------------------------------------------------------------------------------
+long DRA818V::toHz(float f) {
+
+     if (f<0.0) return -(((long)(-f)+DRARASTER/2)/DRARASTER)*DRARASTER;
+     return (((long)f+DRARASTER/2)/DRARASTER)*DRARASTER;
+}
+//--------------------------------------------------------------------------------------------------
+// putNum  write v in decimal at p zero padded to w digits, returns the position after the last one
+//--------------------------------------------------------------------------------------------------
+char* DRA818V::putNum(char* p,unsigned long v,int w) {
+
+char b[24];
+int  n=0;
+     do {
+       b[n++]='0'+(char)(v%10);
+       v/=10;
+     } while (v!=0 && n<(int)sizeof(b));
+     while (n<w && n<(int)sizeof(b)) {b[n++]='0';}
+     while (n>0) {*p++=b[--n];}
+     return p;
+}
+//--------------------------------------------------------------------------------------------------
+// putMHz  write f (Hz) as MHz with dec decimals (0..6), rounded, same text as printf("%.*f")
+//--------------------------------------------------------------------------------------------------
+char* DRA818V::putMHz(char* p,long f,int dec) {
+
+static const long SCALE[7]={1000000,100000,10000,1000,100,10,1};
+
+     if (dec<0) {dec=0;}
+     if (dec>6) {dec=6;}
+     if (f<0) {
+        *p++='-';
+        f=-f;
+     }
+long u=(f+SCALE[dec]/2)/SCALE[dec];
+long k=SCALE[6-dec];
+     p=putNum(p,(unsigned long)(u/k),1);
+     if (dec>0) {
+        *p++='.';
+        p=putNum(p,(unsigned long)(u%k),dec);
+     }
+     return p;
+}
+//--------------------------------------------------------------------------------------------------
+// rxHz  receive frequency (Hz) of an AT+DMOSETGROUP frame, the third field as putMHz() wrote it,
+// 0 when the frame has none
+//--------------------------------------------------------------------------------------------------
+long DRA818V::rxHz(const char* s) {
+
+const char* p=strchr(s,'=');
+     for (int i=0;i<2 && p!=NULL;i++) {p=strchr(p+1,',');}
+     if (p==NULL) return 0;
+long f=0;
+long k=1000000;
+     for (p++;*p>='0' && *p<='9';p++) {f=f*10+(*p-'0');}
+     f*=k;
+     if (*p=='.') {
+        for (p++;*p>='0' && *p<='9' && k>1;p++) {
+            k/=10;
+            f+=(*p-'0')*k;
+        }
+     }
+     return f;
+}
+//--------------------------------------------------------------------------------------------------
+// encode  build the AT frames of a channel slot, only done after one of its settings changed,
+// call with mtx held; the setters take it too, so a frame never mixes a field half written
+//--------------------------------------------------------------------------------------------------
+void DRA818V::encode(byte c) {
+
+     dra[c].dirty=false;
+
+char* p=dra[c].group;
+     memcpy(p,"AT+DMOSETGROUP=",15);
+     p+=15;
+     *p++=(getWord(dra[c].STATUS,GBW) ? '1' : '0');
+     *p++=',';
+     p=putMHz(p,dra[c].TFW,4);
+     *p++=',';
+     p=putMHz(p,dra[c].RFW,4);
+     *p++=',';
+     p=putNum(p,dra[c].Rx_CTCSS,4);
+     *p++=',';
+     p=putNum(p,dra[c].SQL,1);
+     *p++=',';
+     p=putNum(p,dra[c].Tx_CTCSS,4);
+     *p=0x00;
+
+     p=dra[c].volume;
+     memcpy(p,"AT+DMOSETVOLUME=",16);
+     p=putNum(p+16,dra[c].Vol,1);
+     *p=0x00;
+
+     p=dra[c].filter;
+     memcpy(p,"AT+SETFILTER=",13);
+     p+=13;
+     *p++=(getWord(dra[c].STATUS,PEF) ? '1' : '0');
+     *p++=',';
+     *p++=(getWord(dra[c].STATUS,HPF) ? '1' : '0');
+     *p++=',';
+     *p++=(getWord(dra[c].STATUS,LPF) ? '1' : '0');
+     *p=0x00;
+    (TRACE>=0x03 ? fprintf(stderr,"%s:encode() slot(%d) Frame[%s]\n",PROGRAMID,c,dra[c].group) : _NOP);
+}
+//--------------------------------------------------------------------------------------------------
+// frame  encoded frame of a slot for DRA_CMD_GROUP, DRA_CMD_VOLUME or DRA_CMD_FILTER, call with mtx held
+//--------------------------------------------------------------------------------------------------
+char* DRA818V::frame(byte c,byte type) {
+
+     if (dra[c].dirty==true || dra[c].group[0]==0x00) {encode(c);}
+     if (type==DRA_CMD_VOLUME) {return dra[c].volume;}
+     if (type==DRA_CMD_FILTER) {return dra[c].filter;}
+     return dra[c].group;
+}
+//--------------------------------------------------------------------------------------------------
 // This method sends the DMOSETGROUP command
 //--------------------------------------------------------------------------------------------------
 void DRA818V::sendSetGroup() {
 
-     sprintf(command,"AT+DMOSETGROUP=%d,%3.4f,%3.4f,%04d,%d,%04d",getWord(dra[m].STATUS,GBW),dra[m].TFW,dra[m].RFW,dra[m].Rx_CTCSS,dra[m].SQL,dra[m].Tx_CTCSS);
-     this->send_data(command);
-     //usleep(100000);
+     pthread_mutex_lock(&mtx);
+     if (watch==DRA_WATCH_LOOK || watch==DRA_WATCH_HOLD) {
+        frame(m,DRA_CMD_GROUP);              // away on the priority channel, written on the way back
+     } else {
+        queueCommand(frame(m,DRA_CMD_GROUP),DRA_LANE_TUNE);
+     }
+     pthread_mutex_unlock(&mtx);
 
 }
 //--------------------------------------------------------------------------------------------------
@@ -518,17 +2102,48 @@ void DRA818V::sendSetGroup() {
 //--------------------------------------------------------------------------------------------------
 void DRA818V::sendSetVolume() {
 
-     sprintf(command,"AT+DMOSETVOLUME=%d",dra[m].Vol);
-     this->send_data(command);
-     //usleep(100000);
+     pthread_mutex_lock(&mtx);
+     queueCommand(frame(m,DRA_CMD_VOLUME),DRA_LANE_TUNE);
+     pthread_mutex_unlock(&mtx);
 }
 //--------------------------------------------------------------------------------------------------
 // This method sends the SETFILTER (why not DMOSETFILTER?) command
 //--------------------------------------------------------------------------------------------------
 void DRA818V::sendSetFilter() {
 
-     sprintf(command,"AT+SETFILTER=%d,%d,%d",getWord(dra[m].STATUS,PEF),getWord(dra[m].STATUS,HPF),getWord(dra[m].STATUS,LPF));
-     this->send_data(command);
+     pthread_mutex_lock(&mtx);
+     queueCommand(frame(m,DRA_CMD_FILTER),DRA_LANE_TUNE);
+     pthread_mutex_unlock(&mtx);
+}
+//--------------------------------------------------------------------------------------------------
+// recall  copy channel slot c into the one in use, its frames are written as they are; volume and
+// filter usually match what the chip holds already and are suppressed
+//--------------------------------------------------------------------------------------------------
+void DRA818V::recall(byte c) {
+
+     if (c>=DRABANK) return;
+     pthread_mutex_lock(&mtx);
+     if (c!=m) {
+        bool k=dra[m].skip;
+        memcpy(&dra[m],&dra[c],sizeof(struct DRA));
+        dra[m].skip=k;
+     }
+     queueCommand(frame(m,DRA_CMD_GROUP),DRA_LANE_TUNE);
+     queueCommand(frame(m,DRA_CMD_VOLUME),DRA_LANE_TUNE);
+     queueCommand(frame(m,DRA_CMD_FILTER),DRA_LANE_TUNE);
+     pthread_mutex_unlock(&mtx);
+    (TRACE>=0x02 ? fprintf(stderr,"%s:recall() channel(%d) Frame[%s]\n",PROGRAMID,c,dra[c].group) : _NOP);
+}
+//--------------------------------------------------------------------------------------------------
+// store  save the channel in use into slot c
+//--------------------------------------------------------------------------------------------------
+void DRA818V::store(byte c) {
+
+     if (c>=DRABANK || c==m) return;
+     pthread_mutex_lock(&mtx);
+     memcpy(&dra[c],&dra[m],sizeof(struct DRA));
+     pthread_mutex_unlock(&mtx);
+    (TRACE>=0x02 ? fprintf(stderr,"%s:store() channel(%d) Frame[%s]\n",PROGRAMID,c,dra[c].group) : _NOP);
 }
 //--------------------------------------------------------------------------------------------------
 // This method sends the RSSI (Receiver Signal Strength Indicator)
@@ -537,80 +2152,90 @@ void DRA818V::sendRSSI() {
 
     (TRACE>=0x03 ? fprintf(stderr,"%s::sendRSSI() Sending RSSI? command\n",PROGRAMID) : _NOP);
 
-     if (getWord(dra[0].STATUS,PT)==true) {return;}
+     if (keyed()==true) {return;}
 
-     strcpy(command,"RSSI?");
-     this->send_data(command);
+     this->send_data((char*)"RSSI?",DRA_LANE_POLL);
 
 }
 //--------------------------------------------------------------------------------------------------
-// getter and setters for the different parameters (some validation performed)
+// getter and setters for the different parameters (some validation performed), the setters write
+// the slot under mtx as the I/O thread encodes and copies slots; a frame it sends between two of
+// them is followed by the one the application sends once done (sendSetGroup() and the like)
 //--------------------------------------------------------------------------------------------------
-float DRA818V::getRFW(byte m) {
+long DRA818V::getRFW(byte m) {
 
-    if (m<0 || m>15) return 0.0;
+    if (m<0 || m>=DRABANK) return 0;
 
-   (TRACE>=0x00 ? fprintf(stderr,"%s::getRFW() RFW(%6.2f)\n",PROGRAMID,dra[m].RFW) : _NOP);
+   (TRACE>=0x03 ? fprintf(stderr,"%s::getRFW() RFW(%ld)\n",PROGRAMID,dra[m].RFW) : _NOP);
     return dra[m].RFW;
 }
 //--------------------------------------------------------------------------------------------------
-float DRA818V::getRFW() {
+long DRA818V::getRFW() {
    return this->getRFW(this->m);
 }
 //--------------------------------------------------------------------------------------------------
-void DRA818V::setRFW(byte m,float f) {
+void DRA818V::setRFW(byte m,long f) {
 
-    if (m<0 || m>15) return;
+    if (m<0 || m>=DRABANK) return;
 
+    pthread_mutex_lock(&mtx);
     dra[m].RFW=f;
-   (TRACE>=0x00 ? fprintf(stderr,"%s::setRFW() TFW(%6.2f)\n",PROGRAMID,dra[m].RFW) : _NOP);
+    dra[m].dirty=true;
+    pthread_mutex_unlock(&mtx);
+   (TRACE>=0x03 ? fprintf(stderr,"%s::setRFW() RFW(%ld)\n",PROGRAMID,dra[m].RFW) : _NOP);
     return;
 }
 //--------------------------------------------------------------------------------------------------
-void DRA818V::setRFW(float f) {
+void DRA818V::setRFW(long f) {
     this->setRFW(this->m,f);
     return;
 }
 //--------------------------------------------------------------------------------------------------
-float DRA818V::getTFW(byte m) {
-    if (m<0 || m>15) return 0.0;
+long DRA818V::getTFW(byte m) {
+    if (m<0 || m>=DRABANK) return 0;
 
-   (TRACE>=0x00 ? fprintf(stderr,"%s::getTFW() TFW(%6.2f)\n",PROGRAMID,dra[m].TFW) : _NOP);
+   (TRACE>=0x03 ? fprintf(stderr,"%s::getTFW() TFW(%ld)\n",PROGRAMID,dra[m].TFW) : _NOP);
     return dra[m].TFW;
 }
 //--------------------------------------------------------------------------------------------------
-float DRA818V::getTFW() {
+long DRA818V::getTFW() {
    return this->getTFW(this->m);
 }
 //--------------------------------------------------------------------------------------------------
-void DRA818V::setTFW(float f) {
+void DRA818V::setTFW(long f) {
     this->setTFW(this->m,f);
     return;
 }
 //--------------------------------------------------------------------------------------------------
-void DRA818V::setTFW(byte m,float f) {
-    if (m<0 || m>15) return;
+void DRA818V::setTFW(byte m,long f) {
+    if (m<0 || m>=DRABANK) return;
+    pthread_mutex_lock(&mtx);
     dra[m].TFW=f;
-   (TRACE>=0x00 ? fprintf(stderr,"%s::setTFW() TFW(%6.2f)\n",PROGRAMID,dra[m].TFW) : _NOP);
+    dra[m].dirty=true;
+    pthread_mutex_unlock(&mtx);
+   (TRACE>=0x03 ? fprintf(stderr,"%s::setTFW() TFW(%ld)\n",PROGRAMID,dra[m].TFW) : _NOP);
     return;
 }
 //--------------------------------------------------------------------------------------------------
 int DRA818V::getTxCTCSS(byte m) {
 
-    if (m<0 || m>15) return 0;
-   (TRACE>=0x00 ? fprintf(stderr,"%s::getTxCTCSS() CTCSS(%x)\n",PROGRAMID,dra[m].Tx_CTCSS) : _NOP);
+    if (m<0 || m>=DRABANK) return 0;
+   (TRACE>=0x03 ? fprintf(stderr,"%s::getTxCTCSS() CTCSS(%x)\n",PROGRAMID,dra[m].Tx_CTCSS) : _NOP);
    return dra[m].Tx_CTCSS;
 }
 //--------------------------------------------------------------------------------------------------
 void DRA818V::setTxCTCSS(byte m,int t) {
-   if (m<0 || m>15) return;
+   if (m<0 || m>=DRABANK) return;
    (TRACE>=0x00 ? fprintf(stderr,"%s::setTxCTCSS() CTCSS(%x)\n",PROGRAMID,t) : _NOP);
+   pthread_mutex_lock(&mtx);
    dra[m].Tx_CTCSS=t;
+   dra[m].dirty=true;
+   pthread_mutex_unlock(&mtx);
    return;   
 }
 //--------------------------------------------------------------------------------------------------
 void DRA818V::setTxCTCSS(int t) {
-   this->setTxCTCSS(0,t);
+   this->setTxCTCSS(this->m,t);
    return;
 }
 //--------------------------------------------------------------------------------------------------
@@ -620,8 +2245,8 @@ int DRA818V::getTxCTCSS() {
 //--------------------------------------------------------------------------------------------------
 int DRA818V::getRxCTCSS(byte m) {
 
-    if (m<0 || m>15) return 0;
-   (TRACE>=0x00 ? fprintf(stderr,"%s::getRxCTCSS() CTCSS(%x)\n",PROGRAMID,dra[m].Rx_CTCSS) : _NOP);
+    if (m<0 || m>=DRABANK) return 0;
+   (TRACE>=0x03 ? fprintf(stderr,"%s::getRxCTCSS() CTCSS(%x)\n",PROGRAMID,dra[m].Rx_CTCSS) : _NOP);
    return dra[m].Rx_CTCSS;
 }
 //--------------------------------------------------------------------------------------------------
@@ -630,8 +2255,11 @@ int DRA818V::getRxCTCSS() {
 }
 //--------------------------------------------------------------------------------------------------
 void DRA818V::setRxCTCSS(byte m,int t){
-   if (m<0 || m>15) return;
+   if (m<0 || m>=DRABANK) return;
+   pthread_mutex_lock(&mtx);
    dra[m].Rx_CTCSS=t;
+   dra[m].dirty=true;
+   pthread_mutex_unlock(&mtx);
    (TRACE>=0x00 ? fprintf(stderr,"%s::setRxCTCSS() CTCSS(%d)\n",PROGRAMID,t) : _NOP);
    return;   
 }
@@ -642,31 +2270,35 @@ void DRA818V::setRxCTCSS(int t) {
 }
 //--------------------------------------------------------------------------------------------------
 int DRA818V::getVol(byte m) {
-    if (m<0 || m>15) return 0;
+    if (m<0 || m>=DRABANK) return 0;
    (TRACE>=0x00 ? fprintf(stderr,"%s::getVol() Vol(%d)\n",PROGRAMID,dra[m].Vol) : _NOP);
    return dra[m].Vol;
 }
 //--------------------------------------------------------------------------------------------------
 void DRA818V::setPD(bool v) {
-   setWord(&dra[m].STATUS,PD,v);
-   (TRACE>=0x00 ? fprintf(stderr,"%s::setPD() PD(%s)\n",PROGRAMID,BOOL2CHAR(getWord(dra[m].STATUS,PD))) : _NOP);
+   pthread_mutex_lock(&mtx);
+   setWord(&RSW,PD,v);
+   pthread_mutex_unlock(&mtx);
+   (TRACE>=0x00 ? fprintf(stderr,"%s::setPD() PD(%s)\n",PROGRAMID,BOOL2CHAR(getWord(RSW,PD))) : _NOP);
    if(changePD!=NULL) {changePD();}
    return;
 }
 //--------------------------------------------------------------------------------------------------
 bool DRA818V::getPD() {
-   return getWord(dra[m].STATUS,PD);
+   return getWord(RSW,PD);
 }
 //--------------------------------------------------------------------------------------------------
 void DRA818V::setHL(bool v) {
-   setWord(&dra[m].STATUS,HL,v);
-   (TRACE>=0x00 ? fprintf(stderr,"%s::setHL() HL(%s)\n",PROGRAMID,BOOL2CHAR(getWord(dra[m].STATUS,HL))) : _NOP);
+   pthread_mutex_lock(&mtx);
+   setWord(&RSW,HL,v);
+   pthread_mutex_unlock(&mtx);
+   (TRACE>=0x00 ? fprintf(stderr,"%s::setHL() HL(%s)\n",PROGRAMID,BOOL2CHAR(getWord(RSW,HL))) : _NOP);
    if (changeHL!=NULL) {changeHL();}
    return;
 }
 //--------------------------------------------------------------------------------------------------
 bool DRA818V::getHL() {
-   return getWord(dra[m].STATUS,HL);
+   return getWord(RSW,HL);
 }
 //--------------------------------------------------------------------------------------------------
 int DRA818V::getVol() {
@@ -674,9 +2306,12 @@ int DRA818V::getVol() {
 }
 //--------------------------------------------------------------------------------------------------
 void DRA818V::setVol(byte m,byte v) {
-    if (m<0 || m>15) return;
+    if (m<0 || m>=DRABANK) return;
    (TRACE>=0x00 ? fprintf(stderr,"%s::setVol() Vol(%d)\n",PROGRAMID,v) : _NOP);
+    pthread_mutex_lock(&mtx);
     dra[m].Vol=v;
+    dra[m].dirty=true;
+    pthread_mutex_unlock(&mtx);
     return;
 }
 //--------------------------------------------------------------------------------------------------
@@ -686,7 +2321,7 @@ void DRA818V::setVol(byte v) {
 }
 //--------------------------------------------------------------------------------------------------
 int DRA818V::getSQL(byte m) {
-    if (m<0 || m>15) return 0;
+    if (m<0 || m>=DRABANK) return 0;
    (TRACE>=0x00 ? fprintf(stderr,"%s::getSQL() SQL(%d)\n",PROGRAMID,dra[m].SQL) : _NOP);
    return dra[m].SQL;
 }
@@ -696,9 +2331,12 @@ int DRA818V::getSQL() {
 }
 //--------------------------------------------------------------------------------------------------
 void DRA818V::setSQL(byte m,byte v) {
-    if (m<0 || m>15) return;
+    if (m<0 || m>=DRABANK) return;
    (TRACE>=0x00 ? fprintf(stderr,"%s::setSQL() SQL(%d)\n",PROGRAMID,v) : _NOP);
+    pthread_mutex_lock(&mtx);
     dra[m].SQL=v;
+    dra[m].dirty=true;
+    pthread_mutex_unlock(&mtx);
     return;
 }
 //--------------------------------------------------------------------------------------------------
@@ -708,7 +2346,7 @@ void DRA818V::setSQL(byte v) {
 }
 //--------------------------------------------------------------------------------------------------
 bool DRA818V::getGBW(byte m) {
-    if (m<0 || m>15) return false;
+    if (m<0 || m>=DRABANK) return false;
    (TRACE>=0x00 ? fprintf(stderr,"%s::getGBW() GBW(%s)\n",PROGRAMID,BOOL2CHAR(getWord(dra[m].STATUS,GBW))) : _NOP);
     return getWord(dra[m].STATUS,GBW);
 }
@@ -718,9 +2356,12 @@ bool DRA818V::getGBW() {
 }
 //--------------------------------------------------------------------------------------------------
 void DRA818V::setGBW(byte m,bool v) {
-    if (m<0 || m>15) return;
+    if (m<0 || m>=DRABANK) return;
    (TRACE>=0x00 ? fprintf(stderr,"%s::setGBW() PEF(%s)\n",PROGRAMID,BOOL2CHAR(v)) : _NOP);
+    pthread_mutex_lock(&mtx);
     setWord(&dra[m].STATUS,GBW,v);
+    dra[m].dirty=true;
+    pthread_mutex_unlock(&mtx);
     return;
 }
 //--------------------------------------------------------------------------------------------------
@@ -730,7 +2371,7 @@ void DRA818V::setGBW(bool v) {
 }
 //--------------------------------------------------------------------------------------------------
 bool DRA818V::getPEF(byte m) {
-    if (m<0 || m>15) return false;
+    if (m<0 || m>=DRABANK) return false;
    (TRACE>=0x00 ? fprintf(stderr,"%s::getPEF() PEF(%s)\n",PROGRAMID,BOOL2CHAR(getWord(dra[m].STATUS,PEF))) : _NOP);
     return getWord(dra[m].STATUS,PEF);
 }
@@ -740,9 +2381,12 @@ bool DRA818V::getPEF() {
 }
 //--------------------------------------------------------------------------------------------------
 void DRA818V::setPEF(byte m,bool v) {
-    if (m<0 || m>15) return;
+    if (m<0 || m>=DRABANK) return;
    (TRACE>=0x00 ? fprintf(stderr,"%s::setPEF() PEF(%s)\n",PROGRAMID,BOOL2CHAR(v)) : _NOP);
+    pthread_mutex_lock(&mtx);
     setWord(&dra[m].STATUS,PEF,v);
+    dra[m].dirty=true;
+    pthread_mutex_unlock(&mtx);
     return;
 }
 //--------------------------------------------------------------------------------------------------
@@ -755,7 +2399,7 @@ void DRA818V::setPEF(bool v) {
 
 //--------------------------------------------------------------------------------------------------
 bool DRA818V::getHPF(byte m) {
-    if (m<0 || m>15) return false;
+    if (m<0 || m>=DRABANK) return false;
    (TRACE>=0x00 ? fprintf(stderr,"%s::getHPF() HPF(%s)\n",PROGRAMID,BOOL2CHAR(getWord(dra[m].STATUS,HPF))) : _NOP);
     return getWord(dra[m].STATUS,HPF);
 }
@@ -765,9 +2409,12 @@ bool DRA818V::getHPF() {
 }
 //--------------------------------------------------------------------------------------------------
 void DRA818V::setHPF(byte m,bool v) {
-    if (m<0 || m>15) return;
+    if (m<0 || m>=DRABANK) return;
    (TRACE>=0x00 ? fprintf(stderr,"%s::setHPF() HPF(%s)\n",PROGRAMID,BOOL2CHAR(v)) : _NOP);
+    pthread_mutex_lock(&mtx);
     setWord(&dra[m].STATUS,HPF,v);
+    dra[m].dirty=true;
+    pthread_mutex_unlock(&mtx);
     return;
 }
 //--------------------------------------------------------------------------------------------------
@@ -777,7 +2424,7 @@ void DRA818V::setHPF(bool v) {
 }
 //--------------------------------------------------------------------------------------------------
 bool DRA818V::getLPF(byte m) {
-    if (m<0 || m>15) return false;
+    if (m<0 || m>=DRABANK) return false;
    (TRACE>=0x00 ? fprintf(stderr,"%s::getLPF() LPF(%s)\n",PROGRAMID,BOOL2CHAR(getWord(dra[m].STATUS,LPF))) : _NOP);
     return getWord(dra[m].STATUS,LPF);
 }
@@ -787,9 +2434,12 @@ bool DRA818V::getLPF() {
 }
 //--------------------------------------------------------------------------------------------------
 void DRA818V::setLPF(byte m,bool v) {
-    if (m<0 || m>15) return;
+    if (m<0 || m>=DRABANK) return;
    (TRACE>=0x00 ? fprintf(stderr,"%s::setLPF() LPF(%s)\n",PROGRAMID,BOOL2CHAR(getWord(dra[m].STATUS,LPF))) : _NOP);
+    pthread_mutex_lock(&mtx);
     setWord(&dra[m].STATUS,LPF,v);
+    dra[m].dirty=true;
+    pthread_mutex_unlock(&mtx);
     return;
 }
 //--------------------------------------------------------------------------------------------------
@@ -799,14 +2449,76 @@ void DRA818V::setLPF(bool v) {
 }
 //--------------------------------------------------------------------------------------------------
 bool DRA818V::getPTT() {
-    return getWord(dra[0].STATUS,PT);
+    return getWord(RSW,PT);
+}
+//--------------------------------------------------------------------------------------------------
+// canKey  claim the transmitter for the mic if the PTT can be keyed on the channel tuned as it is,
+// without waiting for setPTT() to stop the scan or bring the receiver back from a priority look;
+// lock free, the GPIO callback of the mic PTT calls it and must not wait for the I/O thread to
+// finish a service() pass. The claim is raised before the scanner and the watch are looked at and
+// the watch looks at it again after leaving the channel, so either the look or the key gives way
+//--------------------------------------------------------------------------------------------------
+bool DRA818V::canKey() {
+    keying.store(true);
+byte w=watch.load();
+    if (scan.load()==DRA_SCAN_OFF && w!=DRA_WATCH_LOOK && w!=DRA_WATCH_BACK) return true;
+    keying.store(false);
+    return false;
+}
+//--------------------------------------------------------------------------------------------------
+// unKey  the mic was released, drop the claim taken by canKey()
+//--------------------------------------------------------------------------------------------------
+void DRA818V::unKey() {
+    keying.store(false);
+}
+//--------------------------------------------------------------------------------------------------
+// keyed  transmitting or claimed by the mic, no retune nor RSSI? goes out
+//--------------------------------------------------------------------------------------------------
+bool DRA818V::keyed() {
+    return (getWord(RSW,PT)==true || keying.load()==true);
 }
 //--------------------------------------------------------------------------------------------------
 void DRA818V::setPTT(bool v) {
-    setWord(&dra[0].STATUS,PT,v);
+    if (v==true) {
+       stopScan();
+       pthread_mutex_lock(&mtx);
+       if (watch==DRA_WATCH_LOOK) {watchLeave();}         // a held priority channel is the one to answer on
+       pthread_mutex_unlock(&mtx);
+    }
+    pthread_mutex_lock(&mtx);
+    setWord(&RSW,PT,v);
+    if (v==false) {keying.store(false);}
+    pthread_mutex_unlock(&mtx);
     if (changePTT!=NULL) {changePTT();}
     return;
 }
+//--------------------------------------------------------------------------------------------------
+// setSQ  squelch status from the GPIO, while the scan is stopped it decides at once when to resume
+// (during the dwell it is only looked at together with the RSSI, the line may still be settling)
+//--------------------------------------------------------------------------------------------------
+void DRA818V::setSQ(bool v) {
+
+    pthread_mutex_lock(&mtx);
+    setWord(&RSW,SQ,v);
+    if (scan==DRA_SCAN_HOLD || scan==DRA_SCAN_HANG) {
+       scanDecide(v);
+       armTimer();
+    }
+    pthread_mutex_unlock(&mtx);
+}
+//--------------------------------------------------------------------------------------------------
+// postSQ  squelch status from an interrupt handler, only the latest level is kept (no lock taken)
+// and setSQ() applies it on the next processCommand()
+//--------------------------------------------------------------------------------------------------
+void DRA818V::postSQ(bool v) {
+
+    sqin.store(v==true ? 1 : 0);
+    if (notify!=nullptr) {notify->ring();}
+}
+//--------------------------------------------------------------------------------------------------
+bool DRA818V::getSQ() {
+    return getWord(RSW,SQ);
+}
 //*--------------------------------------------------------------------------------------------------*
 //*                                   End of Code                                                    *
 //*--------------------------------------------------------------------------------------------------*
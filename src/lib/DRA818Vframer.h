@@ -0,0 +1,210 @@
+//--------------------------------------------------------------------------------------------------
+// DRA818V reply framer   (HEADER CLASS)
+// incremental framer over a fixed ring buffer plus a typed parser for the replies of the
+// Dorji DRA818V chipset, nothing is allocated and the lines are parsed in place
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef DRA818Vframer_h
+#define DRA818Vframer_h
+
+#include <string.h>
+
+#define  DRAFRAME     256            // ring size, must be a power of two
+#define  DRALINE       64            // longest reply line accepted, longer ones are discarded
+
+//*--- Reply kinds, the first ones share the value of the DRA_CMD_xxx command they answer
+
+enum DRA818V_reply {
+        DRA_RPL_CONNECT=0,           // +DMOCONNECT:rc
+        DRA_RPL_GROUP=1,             // +DMOSETGROUP:rc
+        DRA_RPL_VOLUME=2,            // +DMOSETVOLUME:rc
+        DRA_RPL_FILTER=3,            // +DMOSETFILTER:rc
+        DRA_RPL_TAIL=4,              // +DMOSETTAIL:rc
+        DRA_RPL_VERSION=5,           // +VERSION:text
+        DRA_RPL_RSSI=6,              // RSSI=value
+        DRA_RPL_SCAN=7,              // S=rc
+        DRA_RPL_UNKNOWN=8            // anything else
+};
+
+//*--- A parsed reply, text/len locate the value inside the ring (it may wrap, use copy())
+
+struct DRA818V_msg
+{
+        DRA818V_reply kind;
+        int      rc;                 // numeric rc or RSSI value, -1 when not numeric
+        unsigned text;               // ring position of the value
+        int      len;                // length of the value
+};
+
+//---------------------------------------------------------------------------------------------------
+// DRA818Vframer splits the serial byte stream into lines and parses them without copying
+//---------------------------------------------------------------------------------------------------
+class DRA818Vframer {
+
+  public:
+
+         DRA818Vframer();
+
+     int feed(const char* b,int n);
+    bool next(DRA818V_msg* r);
+     int copy(DRA818V_msg* r,char* s,int n);
+    void reset();
+
+    char  ring[DRAFRAME];
+unsigned  head=0;                    // next position to write (free running)
+unsigned  tail=0;                    // start of the line being framed (free running)
+unsigned  scan=0;                    // next position to look for the end of line
+    bool  skip=false;                // discarding an overlong line
+unsigned long lines=0;               // lines framed
+unsigned long malformed=0;           // unknown or overlong lines
+unsigned long overflow=0;            // bytes dropped because the ring was full
+
+  private:
+
+    char  at(unsigned i) { return ring[i&(DRAFRAME-1)]; }
+    bool  match(unsigned p,int len,const char* s,int n);
+     int  number(unsigned p,int len);
+
+};
+
+//*--- Reply prefixes, in the order of DRA818V_reply
+
+static const char* DRA818V_PREFIX[]={"+DMOCONNECT:","+DMOSETGROUP:","+DMOSETVOLUME:","+DMOSETFILTER:","+DMOSETTAIL:","+VERSION:","RSSI=","S="};
+static const int   DRA818V_PREFIXLEN[]={12,13,14,14,12,9,5,2};
+
+#endif
+//---------------------------------------------------------------------------------------------------
+// DRA818Vframer CLASS Implementation
+//--------------------------------------------------------------------------------------------------
+DRA818Vframer::DRA818Vframer() {
+    reset();
+}
+//---------------------------------------------------------------------------------------------------
+// reset  drop whatever partial line is held
+//--------------------------------------------------------------------------------------------------
+void DRA818Vframer::reset() {
+    head=0;
+    tail=0;
+    scan=0;
+    skip=false;
+}
+//---------------------------------------------------------------------------------------------------
+// feed  append bytes read from the serial port, returns the bytes accepted
+//--------------------------------------------------------------------------------------------------
+int DRA818Vframer::feed(const char* b,int n) {
+
+int k=DRAFRAME-(int)(head-tail);
+    if (n<k) {k=n;}
+    if (k<n) {overflow+=n-k;}
+
+int o=head&(DRAFRAME-1);
+int f=(k < DRAFRAME-o ? k : DRAFRAME-o);
+    memcpy(ring+o,b,f);
+    memcpy(ring,b+f,k-f);
+    head+=k;
+    return k;
+}
+//---------------------------------------------------------------------------------------------------
+// match  true if the len bytes at ring position p start with the n bytes of s
+//--------------------------------------------------------------------------------------------------
+bool DRA818Vframer::match(unsigned p,int len,const char* s,int n) {
+
+    if (len<n) return false;
+    for (int i=0;i<n;i++) {
+        if (at(p+i)!=s[i]) return false;
+    }
+    return true;
+}
+//---------------------------------------------------------------------------------------------------
+// number  decimal value of the len bytes at ring position p, -1 if not a number
+//--------------------------------------------------------------------------------------------------
+int DRA818Vframer::number(unsigned p,int len) {
+
+int v=0;
+    if (len<=0 || len>9) return -1;
+    for (int i=0;i<len;i++) {
+        char c=at(p+i);
+        if (c<'0' || c>'9') return -1;
+        v=v*10+(c-'0');
+    }
+    return v;
+}
+//---------------------------------------------------------------------------------------------------
+// next  frame and parse the next complete line, false when none is available yet
+//--------------------------------------------------------------------------------------------------
+bool DRA818Vframer::next(DRA818V_msg* r) {
+
+    while (scan!=head) {
+
+       char c=at(scan);
+       scan++;
+
+       if (skip==true) {                    // discarding an overlong line up to its end
+          if (c=='\n') {skip=false;}
+          tail=scan;
+          continue;
+       }
+
+       if (c!='\n') {
+          if (scan-tail > DRALINE) {
+             malformed++;
+             skip=true;
+             tail=scan;
+          }
+          continue;
+       }
+
+unsigned p=tail;
+int      len=(int)(scan-tail)-1;
+       tail=scan;
+
+       while (len>0 && (at(p+len-1)=='\r' || at(p+len-1)==' ')) {len--;}
+       while (len>0 && (at(p)=='\r' || at(p)==' ' || at(p)==0x00)) {p++; len--;}
+       if (len==0) continue;
+
+       lines++;
+       r->kind=DRA_RPL_UNKNOWN;
+       r->rc=-1;
+       r->text=p;
+       r->len=len;
+
+//*--- Replies start either with '+' or with the letter of RSSI/S, skip the prefixes that cannot match
+
+char     c0=at(p);
+char     c4=(len>4 ? at(p+4) : 0x00);
+       for (int k=0;k<(int)(sizeof(DRA818V_PREFIX)/sizeof(DRA818V_PREFIX[0]));k++) {
+           int n=DRA818V_PREFIXLEN[k];
+           if (DRA818V_PREFIX[k][0]!=c0 || (n>4 && DRA818V_PREFIX[k][4]!=c4)) continue;
+           if (match(p,len,DRA818V_PREFIX[k],n)) {
+              r->kind=(DRA818V_reply)k;
+              r->text=p+n;
+              r->len=len-n;
+              r->rc=number(r->text,r->len);
+              break;
+           }
+       }
+       if (r->kind==DRA_RPL_UNKNOWN || (r->kind!=DRA_RPL_VERSION && r->rc<0)) {
+          malformed++;
+       }
+       return true;
+    }
+    return false;
+}
+//---------------------------------------------------------------------------------------------------
+// copy  extract the value of a reply (i.e. the version string), only valid until the next feed()
+//--------------------------------------------------------------------------------------------------
+int DRA818Vframer::copy(DRA818V_msg* r,char* s,int n) {
+
+int k=(r->len < n-1 ? r->len : n-1);
+    for (int i=0;i<k;i++) {
+        s[i]=at(r->text+i);
+    }
+    s[k]=0x00;
+    return k;
+}
+//*--------------------------------------------------------------------------------------------------*
+//*                                   End of Code                                                    *
+//*--------------------------------------------------------------------------------------------------*
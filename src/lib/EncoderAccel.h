@@ -0,0 +1,100 @@
+//--------------------------------------------------------------------------------------------------
+// EncoderAccel   (HEADER CLASS)
+// knob acceleration, the step multiplier (1x, 10x or 100x) of every detent from the speed the knob
+// is turned at, measured with the microsecond tick pigpio stamps each edge with
+//--------------------------------------------------------------------------------------------------
+// The speed is a moving average of the rate between detents, so a single quick pair of clicks does
+// not jump ahead. It starts over after a pause or when the knob turns back (the usual reaction to
+// an overshoot), which brings the fine step back at once. The curve is the speed where 10x and 100x
+// start; once reached each holds until the speed drops a fifth below it.
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef EncoderAccel_h
+#define EncoderAccel_h
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define  ACCEL10        10            // detents/s where 10x starts by default
+#define  ACCEL100       30            // detents/s where 100x starts by default
+#define  ACCELIDLE  250000            // us without a detent that start the speed over
+#define  ACCELALPHA    0.5            // weight of the newest rate in the average
+
+//---------------------------------------------------------------------------------------------------
+// EncoderAccel
+//---------------------------------------------------------------------------------------------------
+class EncoderAccel {
+
+  public:
+
+         EncoderAccel();
+
+     int step(uint32_t tick,int dir);
+    void setCurve(int v10,int v100);
+    void reset();
+    void stats(FILE* f);
+
+     int v10=ACCEL10;                  // detents/s for 10x, 0 never
+     int v100=ACCEL100;                // detents/s for 100x, 0 never
+   float speed=0.0;                    // detents/s, averaged
+     int mult=1;                       // multiplier of the last detent
+unsigned long n[3]={0,0,0};            // detents at 1x, 10x and 100x
+
+  private:
+
+uint32_t last=0;
+     int dir=0;
+
+};
+
+#endif
+//---------------------------------------------------------------------------------------------------
+// EncoderAccel CLASS Implementation
+//--------------------------------------------------------------------------------------------------
+EncoderAccel::EncoderAccel() {
+    reset();
+}
+//---------------------------------------------------------------------------------------------------
+void EncoderAccel::reset() {
+    speed=0.0;
+    mult=1;
+    dir=0;
+}
+//---------------------------------------------------------------------------------------------------
+// setCurve  speeds (detents/s) where 10x and 100x start, 0 leaves the step out, both 0 turns it off
+//--------------------------------------------------------------------------------------------------
+void EncoderAccel::setCurve(int a,int b) {
+    v10=(a<0 ? 0 : a);
+    v100=(b<0 ? 0 : b);
+    reset();
+}
+//---------------------------------------------------------------------------------------------------
+// step  multiplier of a detent turned dir (+1/-1) at tick (us, wraps around)
+//--------------------------------------------------------------------------------------------------
+int EncoderAccel::step(uint32_t tick,int d) {
+
+uint32_t dt=tick-last;
+
+    if (dir==0 || d!=dir || dt>=ACCELIDLE || dt==0) {
+       speed=0.0;
+       mult=1;
+    } else {
+       speed+=ACCELALPHA*(1000000.0/dt-speed);
+    }
+    last=tick;
+    dir=d;
+
+int m=1;
+    if (v10!=0 && (speed>=v10 || (mult>=10 && speed>=0.8*v10))) {m=10;}
+    if (v100!=0 && (speed>=v100 || (mult==100 && speed>=0.8*v100))) {m=100;}
+    mult=m;
+    n[(m==1 ? 0 : (m==10 ? 1 : 2))]++;
+    return m;
+}
+//---------------------------------------------------------------------------------------------------
+void EncoderAccel::stats(FILE* f) {
+    fprintf(f,"accel curve 10x=%d 100x=%d detents/s, detents 1x=%lu 10x=%lu 100x=%lu\n",v10,v100,n[0],n[1],n[2]);
+}
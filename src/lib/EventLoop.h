@@ -0,0 +1,207 @@
+//--------------------------------------------------------------------------------------------------
+// EventLoop   (HEADER CLASS)
+// epoll based reactor, calls a handler when one of the registered file descriptors is ready
+// it can run on the calling thread (run()) or on a thread of its own (start()), or be stepped by
+// the caller (poll())
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef EventLoop_h
+#define EventLoop_h
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#define  EVLMAX       32             // file descriptors that can be registered
+
+typedef void (*CALLEVENT)(void* ctx,uint32_t events);
+
+struct EventLoop_handler
+{
+        int       fd;
+        CALLEVENT f;
+        void*     ctx;
+};
+
+//---------------------------------------------------------------------------------------------------
+// EventLoop
+//---------------------------------------------------------------------------------------------------
+class EventLoop {
+
+  public:
+
+         EventLoop();
+        ~EventLoop();
+
+     int add(int fd,uint32_t events,CALLEVENT f,void* ctx);
+    void del(int fd);
+     int run();
+     int poll(int ms);
+     int start();
+    void stop();
+
+    unsigned char TRACE=0x00;
+    int      efd=-1;                 // epoll instance
+    int      wfd=-1;                 // eventfd used to wake up the loop on stop()
+    volatile bool running=false;
+    bool     threaded=false;
+    pthread_t thread;
+    unsigned long wakeups=0;         // epoll_wait() returns with something ready
+struct EventLoop_handler h[EVLMAX];
+
+const char   *PROGRAMID="EventLoop";
+
+  private:
+
+    static void* loop(void* p);
+
+};
+
+#endif
+//---------------------------------------------------------------------------------------------------
+// EventLoop CLASS Implementation
+//--------------------------------------------------------------------------------------------------
+EventLoop::EventLoop() {
+
+    for (int i=0;i<EVLMAX;i++) {
+        h[i].fd=-1;
+        h[i].f=NULL;
+        h[i].ctx=NULL;
+    }
+    efd=epoll_create1(EPOLL_CLOEXEC);
+    wfd=eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+    if (efd<0 || wfd<0) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s::EventLoop() error %d creating epoll: %s\n",PROGRAMID,errno,strerror(errno)) : 0);
+       return;
+    }
+struct epoll_event ev;
+    memset(&ev,0,sizeof(ev));
+    ev.events=EPOLLIN;
+    ev.data.ptr=NULL;
+    epoll_ctl(efd,EPOLL_CTL_ADD,wfd,&ev);
+}
+//---------------------------------------------------------------------------------------------------
+EventLoop::~EventLoop() {
+    stop();
+    if (wfd>=0) {close(wfd);}
+    if (efd>=0) {close(efd);}
+}
+//---------------------------------------------------------------------------------------------------
+// add  register fd, f(ctx,events) is called from the loop whenever fd is ready
+//--------------------------------------------------------------------------------------------------
+int EventLoop::add(int fd,uint32_t events,CALLEVENT f,void* ctx) {
+
+    for (int i=0;i<EVLMAX;i++) {
+        if (h[i].fd!=-1) continue;
+        h[i].fd=fd;
+        h[i].f=f;
+        h[i].ctx=ctx;
+
+struct  epoll_event ev;
+        memset(&ev,0,sizeof(ev));
+        ev.events=events;
+        ev.data.ptr=&h[i];
+        if (epoll_ctl(efd,EPOLL_CTL_ADD,fd,&ev)<0) {
+           (TRACE>=0x00 ? fprintf(stderr,"%s::add() error %d registering fd(%d): %s\n",PROGRAMID,errno,fd,strerror(errno)) : 0);
+           h[i].fd=-1;
+           return -1;
+        }
+        return i;
+    }
+    (TRACE>=0x00 ? fprintf(stderr,"%s::add() no room to register fd(%d)\n",PROGRAMID,fd) : 0);
+    return -1;
+}
+//---------------------------------------------------------------------------------------------------
+// del  unregister fd
+//--------------------------------------------------------------------------------------------------
+void EventLoop::del(int fd) {
+
+    for (int i=0;i<EVLMAX;i++) {
+        if (h[i].fd!=fd) continue;
+        epoll_ctl(efd,EPOLL_CTL_DEL,fd,NULL);
+        h[i].fd=-1;
+    }
+}
+//---------------------------------------------------------------------------------------------------
+// run  dispatch events on the calling thread until stop() is called
+//--------------------------------------------------------------------------------------------------
+int EventLoop::run() {
+
+    if (threaded==false) {running=true;}
+    while (running==true) {
+       if (poll(-1)<0) {return -1;}
+    }
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+// poll  wait up to ms (-1 forever, 0 not at all) and dispatch once whatever is ready, returns the
+// number of descriptors found ready or -1 on error
+//--------------------------------------------------------------------------------------------------
+int EventLoop::poll(int ms) {
+
+struct epoll_event ev[EVLMAX];
+
+    int n=epoll_wait(efd,ev,EVLMAX,ms);
+    if (n<0) {
+       if (errno==EINTR) return 0;
+       (TRACE>=0x00 ? fprintf(stderr,"%s::poll() epoll_wait error %d: %s\n",PROGRAMID,errno,strerror(errno)) : 0);
+       return -1;
+    }
+    if (n>0) {wakeups++;}
+    for (int i=0;i<n;i++) {
+        EventLoop_handler* p=(EventLoop_handler*)ev[i].data.ptr;
+        if (p==NULL) {                     // stop() request
+           uint64_t v;
+           if (read(wfd,&v,sizeof(v))<0) {v=0;}
+           continue;
+        }
+        if (p->fd!=-1 && p->f!=NULL) {
+           p->f(p->ctx,ev[i].events);
+        }
+    }
+    return n;
+}
+//---------------------------------------------------------------------------------------------------
+// start  run the loop on a thread of its own
+//--------------------------------------------------------------------------------------------------
+void* EventLoop::loop(void* p) {
+    ((EventLoop*)p)->run();
+    return NULL;
+}
+//---------------------------------------------------------------------------------------------------
+int EventLoop::start() {
+
+    running=true;
+    threaded=true;
+    if (pthread_create(&thread,NULL,EventLoop::loop,this)!=0) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s::start() unable to create I/O thread\n",PROGRAMID) : 0);
+       running=false;
+       threaded=false;
+       return -1;
+    }
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+// stop  make run() return, joins the thread if start() created one
+//--------------------------------------------------------------------------------------------------
+void EventLoop::stop() {
+
+    running=false;
+uint64_t v=1;
+    if (wfd>=0 && write(wfd,&v,sizeof(v))<0) {v=0;}
+    if (threaded==true) {
+       pthread_join(thread,NULL);
+       threaded=false;
+    }
+}
+//*--------------------------------------------------------------------------------------------------*
+//*                                   End of Code                                                    *
+//*--------------------------------------------------------------------------------------------------*
@@ -0,0 +1,80 @@
+//--------------------------------------------------------------------------------------------------
+// HAL   (HEADER CLASS)
+// hardware abstraction of the front panel, the GPIO lines and the character LCD, so the GUI and
+// the input handling run the same against the pigpio/LCDLib backend (HALpigpio.h) on the board
+// or against the in-process simulator (HALsim.h) on any Linux box
+//--------------------------------------------------------------------------------------------------
+// The calls follow the pigpio and LCDLib ones the program always used, same arguments and same
+// meaning: edge callbacks get the line, its new level and the microsecond tick it changed at,
+// alerts come for every change and the ISR ones only for the edges selected. The serial port of
+// the DRA818V modules is not part of it, it already is a file descriptor opened by name, which is
+// a pseudo-terminal served by DRA818Vemu when running without the radio board.
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef HAL_h
+#define HAL_h
+
+#include <stdint.h>
+
+#define  HAL_INPUT      0             // modes, same values as pigpio
+#define  HAL_OUTPUT     1
+#define  HAL_PUD_OFF    0             // pull up/down
+#define  HAL_PUD_DOWN   1
+#define  HAL_PUD_UP     2
+#define  HAL_RISING     0             // edges of an ISR callback
+#define  HAL_FALLING    1
+#define  HAL_EITHER     2
+
+typedef void (*HALEDGE)(int gpio,int level,uint32_t tick);
+typedef void (*HALSIGNAL)(int signum);
+
+//---------------------------------------------------------------------------------------------------
+// HALgpio  GPIO lines
+//---------------------------------------------------------------------------------------------------
+class HALgpio {
+
+  public:
+
+  virtual ~HALgpio() {}
+
+  virtual int  init()=0;                                   // <0 if the lines can not be used
+  virtual void terminate()=0;
+  virtual int  setMode(unsigned gpio,unsigned mode)=0;
+  virtual int  setPull(unsigned gpio,unsigned pud)=0;
+  virtual int  read(unsigned gpio)=0;
+  virtual int  write(unsigned gpio,unsigned level)=0;
+  virtual int  setAlert(unsigned gpio,HALEDGE f)=0;        // every change, all lines on one thread
+  virtual int  setISR(unsigned gpio,unsigned edge,HALEDGE f)=0;
+  virtual int  setGlitch(unsigned gpio,unsigned us)=0;     // changes shorter than us are dropped
+  virtual int  setSignal(unsigned signum,HALSIGNAL f)=0;
+  virtual uint32_t tick()=0;                               // us, wraps around
+
+  const char* name="none";
+
+};
+
+//---------------------------------------------------------------------------------------------------
+// HALlcd  character LCD
+//---------------------------------------------------------------------------------------------------
+class HALlcd {
+
+  public:
+
+  virtual ~HALlcd() {}
+
+  virtual void begin(int cols,int rows)=0;
+  virtual void clear()=0;
+  virtual void setCursor(int col,int row)=0;
+  virtual void print(const char* s)=0;
+  virtual void println(int col,int row,const char* s)=0;
+  virtual void write(uint8_t c)=0;
+  virtual void typeChar(char c)=0;
+  virtual void createChar(int n,uint8_t* glyph)=0;
+  virtual void backlight(bool on)=0;
+
+};
+
+#endif
@@ -0,0 +1,378 @@
+//--------------------------------------------------------------------------------------------------
+// HALgpiod   (HEADER CLASS)
+// HAL backend of the GPIO lines on the kernel GPIO character device (libgpiod v2), the lines are
+// watched with edge interrupts stamped by the kernel instead of being sampled continuously
+//--------------------------------------------------------------------------------------------------
+// Each line is a request of its own, (re)configured as the program sets its mode, pull, filter and
+// callbacks. A single thread sleeps in poll() on all the requests with edge detection, reads the
+// events pending in batches and hands them to the callbacks ordered by their kernel timestamp, so
+// the edges of the two encoder lines arrive in the order they happened, as pigpio alerts do. Those
+// stamped after the reading started wait for the next pass, another line may still have earlier
+// ones unread. The tick is CLOCK_MONOTONIC in us, the clock the events are stamped with. The glitch
+// filter is the kernel debounce of the line. Works the same on the gpio-sim module, pass its chip.
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef HALgpiod_h
+#define HALgpiod_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <vector>
+#include <algorithm>
+#include <gpiod.h>
+#include "./HAL.h"
+
+#define  GPIODCHIP     "/dev/gpiochip0"
+#define  GPIODLINES     64
+#define  GPIODBATCH     64            // events read at once from a line
+#define  GPIODCONSUMER "picoFM"
+
+struct GPIOD_event {
+       uint64_t ns;
+       int      gpio;
+       int      level;
+};
+
+//---------------------------------------------------------------------------------------------------
+// GpiodGPIO
+//---------------------------------------------------------------------------------------------------
+class GpiodGPIO : public HALgpio {
+
+  public:
+
+         GpiodGPIO(const char* chip);
+        ~GpiodGPIO();
+
+     int init();
+    void terminate();
+     int setMode(unsigned g,unsigned m);
+     int setPull(unsigned g,unsigned p);
+     int read(unsigned g);
+     int write(unsigned g,unsigned l);
+     int setAlert(unsigned g,HALEDGE f);
+     int setISR(unsigned g,unsigned e,HALEDGE f);
+     int setGlitch(unsigned g,unsigned us);
+     int setSignal(unsigned s,HALSIGNAL f);
+uint32_t tick();
+
+    void stats(FILE* f);
+
+     int TRACE=0x00;
+const char   *PROGRAMID="GpiodGPIO";
+unsigned long events=0;                // handed to the callbacks
+unsigned long wakes=0;                 // times the thread woke up with events
+unsigned long maxbatch=0;              // most events handled in one wake
+
+  private:
+
+  static void* loop(void* p);
+    void run();
+     int request(unsigned g);
+     int level(unsigned g);
+
+   char  path[64];
+struct gpiod_chip* chip=NULL;
+struct gpiod_line_request* req[GPIODLINES];
+struct gpiod_edge_event_buffer* buffer=NULL;
+     int mode[GPIODLINES];
+     int pull[GPIODLINES];
+     int out[GPIODLINES];              // level of an output
+unsigned debounce[GPIODLINES];
+ HALEDGE alert[GPIODLINES];
+ HALEDGE isr[GPIODLINES];
+unsigned isredge[GPIODLINES];
+     int wake=-1;                      // eventfd, the set of lines watched changed or stop
+    bool running=false;
+pthread_t thread;
+pthread_mutex_t mtx;
+
+};
+
+#endif
+//---------------------------------------------------------------------------------------------------
+// GpiodGPIO CLASS Implementation
+//--------------------------------------------------------------------------------------------------
+GpiodGPIO::GpiodGPIO(const char* c) {
+
+    name="gpiod";
+    strncpy(path,(c!=NULL ? c : GPIODCHIP),sizeof(path)-1);
+    path[sizeof(path)-1]=0x00;
+    pthread_mutex_init(&mtx,NULL);
+    for (int i=0;i<GPIODLINES;i++) {
+        req[i]=NULL;
+        mode[i]=HAL_INPUT;
+        pull[i]=HAL_PUD_OFF;
+        out[i]=0;
+        debounce[i]=0;
+        alert[i]=NULL;
+        isr[i]=NULL;
+        isredge[i]=HAL_EITHER;
+    }
+}
+GpiodGPIO::~GpiodGPIO() {
+    terminate();
+    pthread_mutex_destroy(&mtx);
+}
+//---------------------------------------------------------------------------------------------------
+// init  open the chip and start the event thread
+//--------------------------------------------------------------------------------------------------
+int GpiodGPIO::init() {
+
+    chip=gpiod_chip_open(path);
+    if (chip==NULL) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s::init() error %d opening %s: %s\n",PROGRAMID,errno,path,strerror(errno)) : 0);
+       return -1;
+    }
+    buffer=gpiod_edge_event_buffer_new(GPIODBATCH);
+    wake=eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);
+    if (buffer==NULL || wake<0) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s::init() unable to allocate the event buffer\n",PROGRAMID) : 0);
+       terminate();
+       return -1;
+    }
+    running=true;
+    if (pthread_create(&thread,NULL,&GpiodGPIO::loop,this)!=0) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s::init() unable to create the event thread\n",PROGRAMID) : 0);
+       running=false;
+       terminate();
+       return -1;
+    }
+    (TRACE>=0x01 ? fprintf(stderr,"%s::init() %s opened\n",PROGRAMID,path) : 0);
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+// terminate  stop the thread, release the lines and close the chip
+//--------------------------------------------------------------------------------------------------
+void GpiodGPIO::terminate() {
+
+uint64_t v=1;
+    if (running==true) {
+       pthread_mutex_lock(&mtx);
+       running=false;
+       pthread_mutex_unlock(&mtx);
+       if (::write(wake,&v,sizeof(v))<0) {v=0;}
+       pthread_join(thread,NULL);
+    }
+    for (int i=0;i<GPIODLINES;i++) {
+        if (req[i]!=NULL) {gpiod_line_request_release(req[i]);}
+        req[i]=NULL;
+        alert[i]=NULL;
+        isr[i]=NULL;
+    }
+    if (buffer!=NULL) {gpiod_edge_event_buffer_free(buffer);}
+    buffer=NULL;
+    if (wake>=0) {close(wake);}
+    wake=-1;
+    if (chip!=NULL) {gpiod_chip_close(chip);}
+    chip=NULL;
+}
+//---------------------------------------------------------------------------------------------------
+// request  (re)configure line g as its settings are now, edges are detected when it has a callback
+//--------------------------------------------------------------------------------------------------
+int GpiodGPIO::request(unsigned g) {
+
+    if (chip==NULL || g>=GPIODLINES) {return -1;}
+
+struct gpiod_line_settings* s=gpiod_line_settings_new();
+struct gpiod_line_config* c=gpiod_line_config_new();
+struct gpiod_request_config* r=gpiod_request_config_new();
+int e=-1;
+
+    if (s!=NULL && c!=NULL && r!=NULL) {
+       if (mode[g]==HAL_OUTPUT) {
+          gpiod_line_settings_set_direction(s,GPIOD_LINE_DIRECTION_OUTPUT);
+          gpiod_line_settings_set_output_value(s,(out[g]!=0 ? GPIOD_LINE_VALUE_ACTIVE : GPIOD_LINE_VALUE_INACTIVE));
+       } else {
+          gpiod_line_settings_set_direction(s,GPIOD_LINE_DIRECTION_INPUT);
+          gpiod_line_settings_set_bias(s,(pull[g]==HAL_PUD_UP ? GPIOD_LINE_BIAS_PULL_UP :
+                                         (pull[g]==HAL_PUD_DOWN ? GPIOD_LINE_BIAS_PULL_DOWN : GPIOD_LINE_BIAS_DISABLED)));
+          gpiod_line_settings_set_edge_detection(s,(alert[g]!=NULL || isr[g]!=NULL ? GPIOD_LINE_EDGE_BOTH : GPIOD_LINE_EDGE_NONE));
+          gpiod_line_settings_set_event_clock(s,GPIOD_LINE_CLOCK_MONOTONIC);
+          gpiod_line_settings_set_debounce_period_us(s,debounce[g]);
+       }
+       unsigned int offset=g;
+       gpiod_line_config_add_line_settings(c,&offset,1,s);
+       gpiod_request_config_set_consumer(r,GPIODCONSUMER);
+       gpiod_request_config_set_event_buffer_size(r,GPIODBATCH);
+
+       pthread_mutex_lock(&mtx);
+       if (req[g]!=NULL) {
+          e=gpiod_line_request_reconfigure_lines(req[g],c);
+       } else {
+          req[g]=gpiod_chip_request_lines(chip,r,c);
+          e=(req[g]!=NULL ? 0 : -1);
+       }
+       pthread_mutex_unlock(&mtx);
+    }
+    if (e<0) {(TRACE>=0x00 ? fprintf(stderr,"%s::request() error %d on line %u: %s\n",PROGRAMID,errno,g,strerror(errno)) : 0);}
+    if (r!=NULL) {gpiod_request_config_free(r);}
+    if (c!=NULL) {gpiod_line_config_free(c);}
+    if (s!=NULL) {gpiod_line_settings_free(s);}
+
+uint64_t v=1;
+    if (wake>=0 && ::write(wake,&v,sizeof(v))<0) {v=0;}     // the thread picks up the new line
+    return e;
+}
+//---------------------------------------------------------------------------------------------------
+int GpiodGPIO::setMode(unsigned g,unsigned m) {
+    if (g>=GPIODLINES) {return -1;}
+    mode[g]=m;
+    return request(g);
+}
+//---------------------------------------------------------------------------------------------------
+int GpiodGPIO::setPull(unsigned g,unsigned p) {
+    if (g>=GPIODLINES) {return -1;}
+    pull[g]=p;
+    return (mode[g]==HAL_INPUT ? request(g) : 0);
+}
+//---------------------------------------------------------------------------------------------------
+int GpiodGPIO::setGlitch(unsigned g,unsigned us) {
+    if (g>=GPIODLINES) {return -1;}
+    debounce[g]=us;
+    return request(g);
+}
+//---------------------------------------------------------------------------------------------------
+int GpiodGPIO::setAlert(unsigned g,HALEDGE f) {
+    if (g>=GPIODLINES) {return -1;}
+    alert[g]=f;
+    return request(g);
+}
+//---------------------------------------------------------------------------------------------------
+// setISR  the edges not selected are dropped when dispatched, the line reports both
+//--------------------------------------------------------------------------------------------------
+int GpiodGPIO::setISR(unsigned g,unsigned e,HALEDGE f) {
+    if (g>=GPIODLINES) {return -1;}
+    isr[g]=f;
+    isredge[g]=e;
+    return request(g);
+}
+//---------------------------------------------------------------------------------------------------
+// setSignal  nothing to take over, the handlers the program set stay in place
+//--------------------------------------------------------------------------------------------------
+int GpiodGPIO::setSignal(unsigned s,HALSIGNAL f) {
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+int GpiodGPIO::level(unsigned g) {
+    if (req[g]==NULL && request(g)<0) {return -1;}
+int v=gpiod_line_request_get_value(req[g],g);
+    return (v==GPIOD_LINE_VALUE_ACTIVE ? 1 : (v==GPIOD_LINE_VALUE_INACTIVE ? 0 : -1));
+}
+//---------------------------------------------------------------------------------------------------
+int GpiodGPIO::read(unsigned g) {
+    if (g>=GPIODLINES) {return -1;}
+    return (mode[g]==HAL_OUTPUT ? out[g] : level(g));
+}
+//---------------------------------------------------------------------------------------------------
+int GpiodGPIO::write(unsigned g,unsigned l) {
+    if (g>=GPIODLINES) {return -1;}
+    out[g]=(l!=0);
+    if (req[g]==NULL || mode[g]!=HAL_OUTPUT) {
+       mode[g]=HAL_OUTPUT;
+       return request(g);
+    }
+    return gpiod_line_request_set_value(req[g],g,(l!=0 ? GPIOD_LINE_VALUE_ACTIVE : GPIOD_LINE_VALUE_INACTIVE));
+}
+//---------------------------------------------------------------------------------------------------
+uint32_t GpiodGPIO::tick() {
+struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint32_t)((uint64_t)ts.tv_sec*1000000+ts.tv_nsec/1000);
+}
+//---------------------------------------------------------------------------------------------------
+void* GpiodGPIO::loop(void* p) {
+    ((GpiodGPIO*)p)->run();
+    return NULL;
+}
+//---------------------------------------------------------------------------------------------------
+// run  sleep until an edge or a change of the lines watched, then dispatch what is pending in order
+//--------------------------------------------------------------------------------------------------
+void GpiodGPIO::run() {
+
+struct pollfd pfd[GPIODLINES+1];
+int    line[GPIODLINES+1];
+std::vector<GPIOD_event> ev;
+
+    while (true) {
+
+//*--- Lines with edge detection, rebuilt every pass as they are few
+
+       pthread_mutex_lock(&mtx);
+       if (running==false) {
+          pthread_mutex_unlock(&mtx);
+          break;
+       }
+       int n=0;
+       pfd[n].fd=wake;
+       pfd[n].events=POLLIN;
+       line[n++]=-1;
+       for (int g=0;g<GPIODLINES;g++) {
+           if (req[g]==NULL || (alert[g]==NULL && isr[g]==NULL)) {continue;}
+           pfd[n].fd=gpiod_line_request_get_fd(req[g]);
+           pfd[n].events=POLLIN;
+           line[n++]=g;
+       }
+       pthread_mutex_unlock(&mtx);
+
+//*--- Events held from the former pass are handed over once nothing earlier can be pending
+
+       if (poll(pfd,n,(ev.empty() ? -1 : 0))<=0 && ev.empty()) {continue;}
+       if ((pfd[0].revents&POLLIN)!=0) {
+          uint64_t v;
+          if (::read(wake,&v,sizeof(v))<0) {v=0;}
+       }
+
+       struct timespec ts;
+       clock_gettime(CLOCK_MONOTONIC,&ts);
+       uint64_t horizon=(uint64_t)ts.tv_sec*1000000000ULL+ts.tv_nsec;
+       poll(pfd,n,0);                                      // every line with events up to the horizon
+       pthread_mutex_lock(&mtx);                           // no reconfiguration while reading
+       for (int i=1;i<n;i++) {
+           if ((pfd[i].revents&POLLIN)==0) {continue;}
+           int k=GPIODBATCH;
+           while (k==GPIODBATCH) {                          // until the line has nothing pending
+              k=gpiod_line_request_read_edge_events(req[line[i]],buffer,GPIODBATCH);
+              for (int j=0;j<k;j++) {
+                  struct gpiod_edge_event* e=gpiod_edge_event_buffer_get_event(buffer,j);
+                  ev.push_back({gpiod_edge_event_get_timestamp_ns(e),(int)gpiod_edge_event_get_line_offset(e),
+                                (gpiod_edge_event_get_event_type(e)==GPIOD_EDGE_EVENT_RISING_EDGE ? 1 : 0)});
+              }
+           }
+       }
+       pthread_mutex_unlock(&mtx);
+       if (ev.empty()) {continue;}
+       std::stable_sort(ev.begin(),ev.end(),[](const GPIOD_event& a,const GPIOD_event& b) {return a.ns<b.ns;});
+
+//*--- Events stamped after the lines started to be read may have earlier ones of another line still
+//*--- unread, they wait for the next pass
+
+       size_t m=0;
+       while (m<ev.size() && ev[m].ns<=horizon) {m++;}
+       if (m==0) {continue;}
+       wakes++;
+       if (m>maxbatch) {maxbatch=m;}
+       for (size_t i=0;i<m;i++) {
+           int g=ev[i].gpio;
+           if (g<0 || g>=GPIODLINES) {continue;}
+           uint32_t t=(uint32_t)(ev[i].ns/1000);
+           events++;
+           if (alert[g]!=NULL) {alert[g](g,ev[i].level,t);}
+           if (isr[g]!=NULL && (isredge[g]==HAL_EITHER || (isredge[g]==HAL_RISING)==(ev[i].level==1))) {isr[g](g,ev[i].level,t);}
+       }
+       ev.erase(ev.begin(),ev.begin()+m);
+    }
+}
+//---------------------------------------------------------------------------------------------------
+void GpiodGPIO::stats(FILE* f) {
+    fprintf(f,"gpiod %s events=%lu wakes=%lu max batch=%lu\n",path,events,wakes,maxbatch);
+}
@@ -0,0 +1,40 @@
+//--------------------------------------------------------------------------------------------------
+// HALlcdlib   (HEADER CLASS)
+// HAL backend of the LCD of the board through LCDLib (PixiePi), include LCDLib.h before this one
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef HALlcdlib_h
+#define HALlcdlib_h
+
+#include "./HAL.h"
+
+//---------------------------------------------------------------------------------------------------
+// PiLCD
+//---------------------------------------------------------------------------------------------------
+class PiLCD : public HALlcd {
+
+  public:
+
+         PiLCD()  {lcd=new LCDLib(NULL);}
+        ~PiLCD()  {delete(lcd);}
+
+    void begin(int c,int r)                      {lcd->begin(c,r);}
+    void clear()                                 {lcd->clear();}
+    void setCursor(int c,int r)                  {lcd->setCursor(c,r);}
+    void print(const char* s)                    {lcd->print((char*)s);}
+    void println(int c,int r,const char* s)      {lcd->println(c,r,(char*)s);}
+    void write(uint8_t c)                        {lcd->write(c);}
+    void typeChar(char c)                        {lcd->typeChar(c);}
+    void createChar(int n,uint8_t* g)            {lcd->createChar(n,g);}
+    void backlight(bool on)                      {lcd->backlight(on);}
+
+  private:
+
+  LCDLib* lcd=NULL;
+
+};
+
+#endif
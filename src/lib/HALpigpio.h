@@ -0,0 +1,39 @@
+//--------------------------------------------------------------------------------------------------
+// HALpigpio   (HEADER CLASS)
+// HAL backend of the GPIO lines of the board through pigpio, include pigpio.h before this one
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef HALpigpio_h
+#define HALpigpio_h
+
+#include "./HAL.h"
+
+#define  PIGPIOCLOCK    5             // us, pigpio sampling period
+
+//---------------------------------------------------------------------------------------------------
+// PiGPIO
+//---------------------------------------------------------------------------------------------------
+class PiGPIO : public HALgpio {
+
+  public:
+
+         PiGPIO() {name="pigpio";}
+
+     int init()                                  {gpioCfgClock(PIGPIOCLOCK,0,0); return gpioInitialise();}
+    void terminate()                             {gpioTerminate();}
+     int setMode(unsigned g,unsigned m)          {return gpioSetMode(g,m);}
+     int setPull(unsigned g,unsigned p)          {return gpioSetPullUpDown(g,p);}
+     int read(unsigned g)                        {return gpioRead(g);}
+     int write(unsigned g,unsigned l)            {return gpioWrite(g,l);}
+     int setAlert(unsigned g,HALEDGE f)          {return gpioSetAlertFunc(g,f);}
+     int setISR(unsigned g,unsigned e,HALEDGE f) {return gpioSetISRFunc(g,e,0,f);}
+     int setGlitch(unsigned g,unsigned us)       {return gpioGlitchFilter(g,us);}
+     int setSignal(unsigned s,HALSIGNAL f)       {return gpioSetSignalFunc(s,f);}
+uint32_t tick()                                  {return gpioTick();}
+
+};
+
+#endif
@@ -0,0 +1,392 @@
+//--------------------------------------------------------------------------------------------------
+// HALsim   (HEADER CLASS)
+// in-process HAL backend, GPIO lines fed from a script of timed edges and an LCD kept in memory
+// whose frames are captured as text, so the GUI can be driven off the board and as fast as it goes
+//--------------------------------------------------------------------------------------------------
+// Time is virtual: advance() moves the tick forward and calls the callbacks of every scripted edge
+// due, with the level and the tick of the edge, from the thread calling it. The inputs rest at the
+// level their pull sets and only changes are reported, as pigpio does; outputs take what is
+// written and, with a capture file, every change is logged there. The script has one edge per line
+//
+//    time_ms gpio level
+//    time_ms enc detents [rate]      detents of the encoder from time_ms, negative counter clockwise,
+//                                    at rate detents/s (SIMRATE by default), both lines in Gray code
+//
+// '#' starts a comment. The LCD keeps the characters written to it and capture() writes a frame
+// each time they changed; custom characters show as '#' and the arrows as '<' and '>'.
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef HALsim_h
+#define HALsim_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include "./HAL.h"
+
+#define  SIMGPIOS      54             // lines of the BCM2835
+#define  SIMRATE       10             // detents/s of an enc line without rate
+#define  SIMROWS        4
+#define  SIMCOLS       40
+
+struct SIM_edge {
+       uint32_t t;                    // us
+       int      gpio;
+       int      level;
+};
+
+//---------------------------------------------------------------------------------------------------
+// SimGPIO
+//---------------------------------------------------------------------------------------------------
+class SimGPIO : public HALgpio {
+
+  public:
+
+         SimGPIO();
+
+     int init();
+    void terminate();
+     int setMode(unsigned g,unsigned m);
+     int setPull(unsigned g,unsigned p);
+     int read(unsigned g);
+     int write(unsigned g,unsigned l);
+     int setAlert(unsigned g,HALEDGE f);
+     int setISR(unsigned g,unsigned e,HALEDGE f);
+     int setGlitch(unsigned g,unsigned us);
+     int setSignal(unsigned s,HALSIGNAL f);
+uint32_t tick();
+
+     int load(const char* file);
+    void setEncoder(int clk,int dt);
+    void inject(int g,int l);
+    void advance(uint32_t us);
+    bool done();
+
+     int TRACE=0x00;
+const char   *PROGRAMID="SimGPIO";
+    FILE* capture=NULL;                // output changes are logged here when set
+unsigned long edges=0;                 // reported to callbacks
+unsigned long writes=0;
+
+  private:
+
+    void fire(int g,int l);
+
+     int level[SIMGPIOS];
+     int mode[SIMGPIOS];
+ HALEDGE alert[SIMGPIOS];
+ HALEDGE isr[SIMGPIOS];
+unsigned isredge[SIMGPIOS];
+uint32_t now=0;
+     int clk=-1;
+     int dt=-1;
+std::vector<SIM_edge> script;
+  size_t next=0;
+
+};
+
+//---------------------------------------------------------------------------------------------------
+// SimLCD
+//---------------------------------------------------------------------------------------------------
+class SimLCD : public HALlcd {
+
+  public:
+
+         SimLCD();
+
+    void begin(int c,int r);
+    void clear();
+    void setCursor(int c,int r);
+    void print(const char* s);
+    void println(int c,int r,const char* s);
+    void write(uint8_t c);
+    void typeChar(char c);
+    void createChar(int n,uint8_t* g);
+    void backlight(bool on);
+
+    bool capture(uint32_t tick);
+    void row(int r,char* s);
+
+    FILE* out=NULL;                    // frames are written here when set
+     int cols=16;
+     int rows=2;
+    bool light=false;
+unsigned long frames=0;                // different frames captured
+unsigned long writes=0;                // characters written
+
+  private:
+
+ uint8_t ddram[SIMROWS][SIMCOLS];
+     int x=0;
+     int y=0;
+    bool changed=true;
+
+};
+
+#endif
+//---------------------------------------------------------------------------------------------------
+// SimGPIO CLASS Implementation
+//--------------------------------------------------------------------------------------------------
+SimGPIO::SimGPIO() {
+    name="simulator";
+    init();
+}
+//---------------------------------------------------------------------------------------------------
+int SimGPIO::init() {
+    for (int i=0;i<SIMGPIOS;i++) {
+        level[i]=0;
+        mode[i]=HAL_INPUT;
+        alert[i]=NULL;
+        isr[i]=NULL;
+        isredge[i]=HAL_EITHER;
+    }
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+void SimGPIO::terminate() {
+    for (int i=0;i<SIMGPIOS;i++) {
+        alert[i]=NULL;
+        isr[i]=NULL;
+    }
+}
+//---------------------------------------------------------------------------------------------------
+int SimGPIO::setMode(unsigned g,unsigned m) {
+    if (g>=SIMGPIOS) {return -1;}
+    mode[g]=m;
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+// setPull  an input rests at the level its pull sets
+//--------------------------------------------------------------------------------------------------
+int SimGPIO::setPull(unsigned g,unsigned p) {
+    if (g>=SIMGPIOS) {return -1;}
+    if (mode[g]==HAL_INPUT && p!=HAL_PUD_OFF) {level[g]=(p==HAL_PUD_UP ? 1 : 0);}
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+int SimGPIO::read(unsigned g) {
+    return (g<SIMGPIOS ? level[g] : -1);
+}
+//---------------------------------------------------------------------------------------------------
+int SimGPIO::write(unsigned g,unsigned l) {
+    if (g>=SIMGPIOS) {return -1;}
+    writes++;
+    if (level[g]==(l!=0)) {return 0;}
+    level[g]=(l!=0);
+    if (capture!=NULL) {fprintf(capture,"%10.3f gpio %u=%u\n",now/1000.0,g,(l!=0));}
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+int SimGPIO::setAlert(unsigned g,HALEDGE f) {
+    if (g>=SIMGPIOS) {return -1;}
+    alert[g]=f;
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+int SimGPIO::setISR(unsigned g,unsigned e,HALEDGE f) {
+    if (g>=SIMGPIOS) {return -1;}
+    isr[g]=f;
+    isredge[g]=e;
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+// setGlitch  the scripted edges are clean, nothing to filter
+//--------------------------------------------------------------------------------------------------
+int SimGPIO::setGlitch(unsigned g,unsigned us) {
+    return (g<SIMGPIOS ? 0 : -1);
+}
+//---------------------------------------------------------------------------------------------------
+// setSignal  pigpio takes over the signals, here the handlers the program set stay in place
+//--------------------------------------------------------------------------------------------------
+int SimGPIO::setSignal(unsigned s,HALSIGNAL f) {
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+uint32_t SimGPIO::tick() {
+    return now;
+}
+//---------------------------------------------------------------------------------------------------
+// setEncoder  lines the enc script entries drive
+//--------------------------------------------------------------------------------------------------
+void SimGPIO::setEncoder(int c,int d) {
+    clk=c;
+    dt=d;
+}
+//---------------------------------------------------------------------------------------------------
+// load  read a script, returns the edges in it or -1
+//--------------------------------------------------------------------------------------------------
+int SimGPIO::load(const char* file) {
+
+FILE* f=fopen(file,"r");
+    if (f==NULL) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s::load() unable to open script %s\n",PROGRAMID,file) : 0);
+       return -1;
+    }
+
+char line[128];
+int  n=0;
+    while (fgets(line,sizeof(line),f)!=NULL) {
+       n++;
+       char* c=strchr(line,'#');
+       if (c!=NULL) {*c=0x00;}
+       double ms;
+       char   what[16];
+       double a;
+       double b=SIMRATE;
+       int    k=sscanf(line,"%lf %15s %lf %lf",&ms,what,&a,&b);
+       if (k<=0) {continue;}
+       if (k<3 || ms<0) {
+          (TRACE>=0x00 ? fprintf(stderr,"%s::load() %s line %d ignored\n",PROGRAMID,file,n) : 0);
+          continue;
+       }
+       uint32_t t=(uint32_t)(ms*1000.0);
+       if (strcmp(what,"enc")!=0) {
+          script.push_back({t,atoi(what),(a!=0 ? 1 : 0)});
+          continue;
+       }
+
+//*--- Clockwise the DT line leads (DT 0, CLK 0, DT 1, CLK 1), counter clockwise CLK does
+
+       if (clk<0 || dt<0 || b<=0) {
+          (TRACE>=0x00 ? fprintf(stderr,"%s::load() %s line %d, no encoder lines\n",PROGRAMID,file,n) : 0);
+          continue;
+       }
+       int d=(int)a;
+       int first=(d>0 ? dt : clk);
+       int second=(d>0 ? clk : dt);
+       double q=1000000.0/(b*4);
+       for (int i=0;i<abs(d);i++) {
+           for (int j=0;j<4;j++) {
+               t+=(uint32_t)q;
+               script.push_back({t,(j%2==0 ? first : second),(j<2 ? 0 : 1)});
+           }
+       }
+    }
+    fclose(f);
+    std::stable_sort(script.begin(),script.end(),[](const SIM_edge& x,const SIM_edge& y) {return x.t<y.t;});
+    (TRACE>=0x01 ? fprintf(stderr,"%s::load() %s %d edges\n",PROGRAMID,file,(int)script.size()) : 0);
+    return (int)script.size();
+}
+//---------------------------------------------------------------------------------------------------
+// fire  a line changes, report it to its callbacks as the GPIO library would
+//--------------------------------------------------------------------------------------------------
+void SimGPIO::fire(int g,int l) {
+
+    if (g<0 || g>=SIMGPIOS || level[g]==l) {return;}
+    level[g]=l;
+    edges++;
+    if (alert[g]!=NULL) {alert[g](g,l,now);}
+    if (isr[g]!=NULL && (isredge[g]==HAL_EITHER || (isredge[g]==HAL_RISING)==(l==1))) {isr[g](g,l,now);}
+}
+//---------------------------------------------------------------------------------------------------
+// inject  a line changes now
+//--------------------------------------------------------------------------------------------------
+void SimGPIO::inject(int g,int l) {
+    fire(g,(l!=0 ? 1 : 0));
+}
+//---------------------------------------------------------------------------------------------------
+// advance  move the time us forward, firing the scripted edges due on the way
+//--------------------------------------------------------------------------------------------------
+void SimGPIO::advance(uint32_t us) {
+
+uint32_t end=now+us;
+    while (next<script.size() && script[next].t<=end) {
+       now=script[next].t;
+       fire(script[next].gpio,script[next].level);
+       next++;
+    }
+    now=end;
+}
+//---------------------------------------------------------------------------------------------------
+bool SimGPIO::done() {
+    return next>=script.size();
+}
+//---------------------------------------------------------------------------------------------------
+// SimLCD CLASS Implementation
+//--------------------------------------------------------------------------------------------------
+SimLCD::SimLCD() {
+    clear();
+}
+//---------------------------------------------------------------------------------------------------
+void SimLCD::begin(int c,int r) {
+    cols=(c<1 ? 1 : (c>SIMCOLS ? SIMCOLS : c));
+    rows=(r<1 ? 1 : (r>SIMROWS ? SIMROWS : r));
+    clear();
+}
+//---------------------------------------------------------------------------------------------------
+void SimLCD::clear() {
+    memset(ddram,' ',sizeof(ddram));
+    x=y=0;
+    changed=true;
+}
+//---------------------------------------------------------------------------------------------------
+void SimLCD::setCursor(int c,int r) {
+    x=c;
+    y=r;
+}
+//---------------------------------------------------------------------------------------------------
+// write  a character at the cursor, past the end of the row it is lost as on the display
+//--------------------------------------------------------------------------------------------------
+void SimLCD::write(uint8_t c) {
+    writes++;
+    if (x>=0 && x<cols && y>=0 && y<rows && ddram[y][x]!=c) {
+       ddram[y][x]=c;
+       changed=true;
+    }
+    x++;
+}
+//---------------------------------------------------------------------------------------------------
+void SimLCD::print(const char* s) {
+    while (*s!=0x00) {write((uint8_t)*s++);}
+}
+//---------------------------------------------------------------------------------------------------
+void SimLCD::println(int c,int r,const char* s) {
+    setCursor(c,r);
+    print(s);
+}
+//---------------------------------------------------------------------------------------------------
+void SimLCD::typeChar(char c) {
+    write((uint8_t)c);
+}
+//---------------------------------------------------------------------------------------------------
+void SimLCD::createChar(int n,uint8_t* g) {
+}
+//---------------------------------------------------------------------------------------------------
+void SimLCD::backlight(bool on) {
+    if (light!=on) {changed=true;}
+    light=on;
+}
+//---------------------------------------------------------------------------------------------------
+// row  text of a row as it reads on the display
+//--------------------------------------------------------------------------------------------------
+void SimLCD::row(int r,char* s) {
+    for (int i=0;i<cols;i++) {
+        uint8_t c=ddram[r][i];
+        s[i]=(c<8 || c==255 ? '#' : (c==126 ? '>' : (c==127 ? '<' : (c<' ' || c>126 ? '?' : (char)c))));
+    }
+    s[cols]=0x00;
+}
+//---------------------------------------------------------------------------------------------------
+// capture  write the frame at tick if it changed since the last one, returns whether it did
+//--------------------------------------------------------------------------------------------------
+bool SimLCD::capture(uint32_t tick) {
+
+    if (changed==false) {return false;}
+    changed=false;
+    frames++;
+    if (out==NULL) {return true;}
+
+char s[SIMCOLS+1];
+    fprintf(out,"%10.3f %s",tick/1000.0,(light==true ? "on " : "off"));
+    for (int r=0;r<rows;r++) {
+        row(r,s);
+        fprintf(out," |%s|",s);
+    }
+    fprintf(out,"\n");
+    return true;
+}
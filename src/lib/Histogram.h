@@ -0,0 +1,135 @@
+//--------------------------------------------------------------------------------------------------
+// Histogram   (HEADER CLASS)
+// log-linear (HDR style) histogram of unsigned values, fixed memory and constant time record()
+// every power of two is split in HSUB linear buckets, so any value is reported within 1/HSUB
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef Histogram_h
+#define Histogram_h
+
+#include <stdio.h>
+#include <string.h>
+
+#define  HSUB          16            // linear buckets per power of two (6.25% resolution)
+#define  HSUBBITS       4            // log2(HSUB)
+#define  HMAG          24            // bucket groups, values up to HSUB*2^(HMAG-1) are resolved
+
+//---------------------------------------------------------------------------------------------------
+// Histogram
+//---------------------------------------------------------------------------------------------------
+class Histogram {
+
+  public:
+
+         Histogram();
+
+    void record(unsigned long v);
+    void reset();
+unsigned long percentile(float p);
+unsigned long mean();
+    void print(FILE* f,const char* name);
+
+unsigned long count=0;               // values recorded
+unsigned long over=0;                // values beyond the range, counted in the last bucket
+unsigned long min=0;
+unsigned long max=0;
+unsigned long long sum=0;
+unsigned long b[HMAG*HSUB];
+
+  private:
+
+     int  index(unsigned long v);
+unsigned long value(int i);
+
+};
+
+#endif
+//---------------------------------------------------------------------------------------------------
+// Histogram CLASS Implementation
+//--------------------------------------------------------------------------------------------------
+Histogram::Histogram() {
+    reset();
+}
+//---------------------------------------------------------------------------------------------------
+void Histogram::reset() {
+    memset(b,0,sizeof(b));
+    count=0;
+    over=0;
+    min=0;
+    max=0;
+    sum=0;
+}
+//---------------------------------------------------------------------------------------------------
+// index  group 0 holds 0..HSUB-1 one per bucket, group g holds [HSUB*2^(g-1),HSUB*2^g) in HSUB
+// buckets 2^(g-1) wide
+//--------------------------------------------------------------------------------------------------
+int Histogram::index(unsigned long v) {
+
+    if (v<HSUB) return (int)v;
+
+int msb=(int)(sizeof(unsigned long)*8-1)-__builtin_clzl(v);
+int g=msb-HSUBBITS+1;
+    if (g>=HMAG) return -1;
+    return g*HSUB+(int)((v-((unsigned long)HSUB<<(g-1)))>>(g-1));
+}
+//---------------------------------------------------------------------------------------------------
+// value  highest value that falls in bucket i
+//--------------------------------------------------------------------------------------------------
+unsigned long Histogram::value(int i) {
+
+int g=i/HSUB;
+int s=i%HSUB;
+    if (g==0) return (unsigned long)s;
+    return ((unsigned long)HSUB<<(g-1))+((unsigned long)(s+1)<<(g-1))-1;
+}
+//---------------------------------------------------------------------------------------------------
+// record  add a value
+//--------------------------------------------------------------------------------------------------
+void Histogram::record(unsigned long v) {
+
+int i=index(v);
+    if (i<0) {
+       i=HMAG*HSUB-1;
+       over++;
+    }
+    b[i]++;
+    if (count==0 || v<min) {min=v;}
+    if (v>max) {max=v;}
+    sum+=v;
+    count++;
+}
+//---------------------------------------------------------------------------------------------------
+// percentile  value at or below which p percent of the values fall (bucket resolution)
+//--------------------------------------------------------------------------------------------------
+unsigned long Histogram::percentile(float p) {
+
+    if (count==0) return 0;
+unsigned long n=(unsigned long)(p*count/100.0+0.999999);
+    if (n==0) {n=1;}
+unsigned long c=0;
+    for (int i=0;i<HMAG*HSUB;i++) {
+        c+=b[i];
+        if (c>=n) {
+           unsigned long v=value(i);
+           return (v>max ? max : (v<min ? min : v));
+        }
+    }
+    return max;
+}
+//---------------------------------------------------------------------------------------------------
+unsigned long Histogram::mean() {
+    return (count>0 ? (unsigned long)(sum/count) : 0);
+}
+//---------------------------------------------------------------------------------------------------
+// print  one line of key=value pairs, easy to read and to parse
+//--------------------------------------------------------------------------------------------------
+void Histogram::print(FILE* f,const char* name) {
+
+    fprintf(f,"%s n=%lu min=%lu p50=%lu p90=%lu p99=%lu max=%lu mean=%lu\n",name,count,min,percentile(50.0),percentile(90.0),percentile(99.0),max,mean());
+}
+//*--------------------------------------------------------------------------------------------------*
+//*                                   End of Code                                                    *
+//*--------------------------------------------------------------------------------------------------*
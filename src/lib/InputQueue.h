@@ -0,0 +1,127 @@
+//--------------------------------------------------------------------------------------------------
+// InputQueue   (HEADER CLASS)
+// timestamped front panel events (encoder detents, push button, mic PTT and squelch edges) handed
+// from the GPIO callbacks to the GUI without losing any
+//--------------------------------------------------------------------------------------------------
+// pigpio runs the callback of every GPIO on a thread of its own, so each source gets its own
+// lock-free single producer ring and the GUI, the only consumer, drains them all at once and
+// merges the events by their tick. An event is only lost when a ring is full, which is counted.
+// Every event queued rings notify, if set, so the GUI can sleep until there is one.
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef InputQueue_h
+#define InputQueue_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include "./SPSCQueue.h"
+#include "./Wakeup.h"
+
+#define  INP_ENC       0              // encoder detent, v=+1 clockwise -1 counterclockwise
+#define  INP_SW        1              // push button released, v=0 brief 1 long
+#define  INP_PTT       2              // mic PTT, v=1 pressed 0 released
+#define  INP_SQL       3              // squelch, v=1 open 0 closed
+#define  INPSOURCES    4
+
+#define  INPSLOTS    256              // events queued per source
+#define  INPBATCH    (INPSOURCES*INPSLOTS)
+
+//*---- Event as queued by the callback, tick is the pigpio one (us, wraps every 72 min)
+
+struct InputEvent {
+        uint32_t tick;
+        uint8_t  kind;
+        int8_t   v;
+        uint8_t  pad[2];
+};
+
+//---------------------------------------------------------------------------------------------------
+// InputQueue
+//---------------------------------------------------------------------------------------------------
+class InputQueue {
+
+  public:
+
+    bool push(uint8_t kind,int8_t v,uint32_t tick);
+     int drain(InputEvent* e,int max);
+unsigned long dropped();
+    void stats(FILE* f);
+
+unsigned long pushed[INPSOURCES]={0,0,0,0};   // written by the producer of each source only
+unsigned long drained=0;
+     int depth=0;                      // most events found by a single drain
+  Wakeup* notify=nullptr;              // rung after every event queued, none if the GUI polls
+
+  private:
+
+SPSCQueue<InputEvent,INPSLOTS> q[INPSOURCES];
+
+};
+
+#endif
+//---------------------------------------------------------------------------------------------------
+// InputQueue CLASS Implementation
+//--------------------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// push  queue an event, called from the callback of its source only
+//--------------------------------------------------------------------------------------------------
+bool InputQueue::push(uint8_t kind,int8_t v,uint32_t tick) {
+
+    if (kind>=INPSOURCES) {return false;}
+InputEvent e;
+    e.tick=tick;
+    e.kind=kind;
+    e.v=v;
+    e.pad[0]=e.pad[1]=0;
+    if (q[kind].push(e)==false) {return false;}
+    pushed[kind]++;
+    if (notify!=nullptr) {notify->ring();}
+    return true;
+}
+//---------------------------------------------------------------------------------------------------
+// drain  take every queued event of every source, oldest first, up to max (INPBATCH takes all)
+//--------------------------------------------------------------------------------------------------
+int InputQueue::drain(InputEvent* e,int max) {
+
+int n=0;
+    for (int k=0;k<INPSOURCES;k++) {
+        while (n<max && q[k].pop(&e[n])==true) {
+           n++;
+        }
+    }
+
+//*--- Each source is already in order, an insertion sort merges them; ticks are compared as a
+//*--- signed difference so the order holds across the wrap
+
+    for (int i=1;i<n;i++) {
+        InputEvent x=e[i];
+        int j=i-1;
+        while (j>=0 && (int32_t)(e[j].tick-x.tick)>0) {
+           e[j+1]=e[j];
+           j--;
+        }
+        e[j+1]=x;
+    }
+    drained+=n;
+    if (n>depth) {depth=n;}
+    return n;
+}
+//---------------------------------------------------------------------------------------------------
+// dropped  events lost because their ring was full
+//--------------------------------------------------------------------------------------------------
+unsigned long InputQueue::dropped() {
+
+unsigned long n=0;
+    for (int k=0;k<INPSOURCES;k++) {
+        n+=q[k].dropped.load(std::memory_order_relaxed);
+    }
+    return n;
+}
+//---------------------------------------------------------------------------------------------------
+void InputQueue::stats(FILE* f) {
+    fprintf(f,"input enc=%lu sw=%lu ptt=%lu sql=%lu drained=%lu depth=%d dropped=%lu\n",
+            pushed[INP_ENC],pushed[INP_SW],pushed[INP_PTT],pushed[INP_SQL],drained,depth,dropped());
+}
@@ -0,0 +1,103 @@
+//--------------------------------------------------------------------------------------------------
+// Quadrature   (HEADER CLASS)
+// table driven decoder of the quadrature (Gray code) signal of the tuning encoder, fed with every
+// edge of both lines as pigpio reports it (level and tick)
+//--------------------------------------------------------------------------------------------------
+// The state is the level of both lines; each valid transition moves a quarter step forward or back
+// and a detent is reported once QUADSTEPS quarters add up with the encoder resting at its detent
+// state. Contact bounce only moves back and forth between two neighbour states, which cancel, so
+// it can neither add a detent nor reverse one. Only the line reported changes, so both lines never
+// move at once; an edge lost shows up instead as a line reported again at the level it already had,
+// its missing edge and this one moved a quarter and back, so it is only counted. Pulses shorter than
+// QUADGLITCH us are filtered out by pigpio before they get here (gpioGlitchFilter, also in ticks).
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef Quadrature_h
+#define Quadrature_h
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define  QUADSTEPS      4             // quarter steps per detent (KY-040 style, one full cycle)
+#define  QUADREST       3             // state at the detent, both lines high (pulled up)
+#define  QUADGLITCH   100             // us a level must hold to be reported
+
+#define  QUAD_CLK       0             // lines
+#define  QUAD_DT        1
+
+//---------------------------------------------------------------------------------------------------
+// Quadrature
+//---------------------------------------------------------------------------------------------------
+class Quadrature {
+
+  public:
+
+         Quadrature();
+
+     int edge(int line,int level,uint32_t tick);
+    void reset(int clk,int dt);
+    void stats(FILE* f);
+
+     int state=QUADREST;               // CLK<<1 | DT
+     int q=0;                          // quarter steps since the last detent
+uint32_t tick=0;                       // of the last edge
+unsigned long edges=0;
+unsigned long detents=0;
+unsigned long lost=0;                  // a line reported at the level it had, the edge before it was lost
+
+};
+
+#endif
+//---------------------------------------------------------------------------------------------------
+// Quadrature CLASS Implementation
+//--------------------------------------------------------------------------------------------------
+//---------------------------------------------------------------------------------------------------
+// Quarter step of every transition, indexed by old state<<2 | new state. Clockwise the DT line
+// leads, 3 (11) -> 2 (10) -> 0 (00) -> 1 (01) -> 3; a transition skipping a state can not happen,
+// edge() changes one line at a time
+//--------------------------------------------------------------------------------------------------
+static const int8_t QUADTABLE[16]={ 0,+1,-1, 0,
+                                   -1, 0, 0,+1,
+                                   +1, 0, 0,-1,
+                                    0,-1,+1, 0};
+
+Quadrature::Quadrature() {
+    reset(1,1);
+}
+//---------------------------------------------------------------------------------------------------
+// reset  start from the levels read from the lines
+//--------------------------------------------------------------------------------------------------
+void Quadrature::reset(int clk,int dt) {
+    state=((clk!=0)<<1)|(dt!=0);
+    q=0;
+}
+//---------------------------------------------------------------------------------------------------
+// edge  line took level at tick, returns +1 (clockwise) or -1 when it completes a detent, 0 if not
+//--------------------------------------------------------------------------------------------------
+int Quadrature::edge(int line,int level,uint32_t t) {
+
+int s=(line==QUAD_CLK ? ((level!=0)<<1)|(state&1) : (state&2)|(level!=0));
+int m=QUADTABLE[(state<<2)|s];
+
+    edges++;
+    tick=t;
+    if (s==state) {
+       lost++;
+       return 0;
+    }
+    state=s;
+    q+=m;
+    if (state!=QUADREST || (q<QUADSTEPS && q>-QUADSTEPS)) {return 0;}
+
+int d=(q>0 ? +1 : -1);
+    q=0;
+    detents++;
+    return d;
+}
+//---------------------------------------------------------------------------------------------------
+void Quadrature::stats(FILE* f) {
+    fprintf(f,"encoder edges=%lu detents=%lu lost=%lu\n",edges,detents,lost);
+}
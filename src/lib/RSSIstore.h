@@ -0,0 +1,235 @@
+//--------------------------------------------------------------------------------------------------
+// RSSIstore   (HEADER CLASS)
+// multi-resolution time series of the RSSI readings, the raw samples plus 1 s, 1 min and 1 h
+// min/mean/max roll-ups, each kept in a ring of fixed size so memory never grows
+//--------------------------------------------------------------------------------------------------
+// A single thread adds the samples; any thread may read a tier at any time without locking. Every
+// ring publishes the count of points written after the point itself, a reader copies the points
+// and then checks the count again, dropping those the writer may have overwritten meanwhile. A
+// bucket is closed, and rolled into the next tier, by the first sample that falls past it.
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef RSSIstore_h
+#define RSSIstore_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define  RSSI_RAW      0              // tiers
+#define  RSSI_SEC      1
+#define  RSSI_MIN      2
+#define  RSSI_HOUR     3
+#define  RSSITIERS     4
+
+#define  RSSIRAW    1024              // raw samples kept (about 100 s at the fast poll)
+#define  RSSISEC    3600              // 1 s buckets kept (1 hour)
+#define  RSSIMIN    1440              // 1 min buckets kept (1 day)
+#define  RSSIHOUR    720              // 1 h buckets kept (30 days)
+
+//*---- Sample or bucket, a raw sample has min=mean=max and n=1
+
+struct RSSI_point {
+        uint64_t t;                   // ms since the epoch, start of the bucket
+        uint8_t  min;
+        uint8_t  mean;
+        uint8_t  max;
+        uint8_t  pad;
+        uint32_t n;                   // samples in the bucket
+};
+
+//*---- Bucket being filled
+
+struct RSSI_acc {
+        uint64_t t;
+        int      min;
+        int      max;
+        uint64_t sum;
+        uint32_t n;
+};
+
+//---------------------------------------------------------------------------------------------------
+// RSSIstore
+//---------------------------------------------------------------------------------------------------
+class RSSIstore {
+
+  public:
+
+         RSSIstore();
+
+    void add(int rssi);
+    void add(uint64_t t,int rssi);
+     int read(int k,RSSI_point* p,int max);
+     int last(int k,RSSI_point* p);
+uint64_t count(int k);
+     int write(FILE* f,int k);
+    void reset();
+
+  static uint64_t now();
+  static const char* name(int k);
+
+uint64_t span[RSSITIERS]={0,1000,60000,3600000};   // ms per bucket
+uint32_t size[RSSITIERS]={RSSIRAW,RSSISEC,RSSIMIN,RSSIHOUR};
+
+  private:
+
+    void push(int k,RSSI_point* p);
+    void roll(int k,uint64_t t,int min,int max,uint64_t sum,uint32_t n);
+
+RSSI_point raw[RSSIRAW];
+RSSI_point sec[RSSISEC];
+RSSI_point mins[RSSIMIN];
+RSSI_point hour[RSSIHOUR];
+RSSI_point* ring[RSSITIERS]={raw,sec,mins,hour};
+uint64_t head[RSSITIERS];             // points written per tier, published after the point
+RSSI_acc acc[RSSITIERS];              // bucket being filled per tier, none for the raw one
+
+};
+
+#endif
+//---------------------------------------------------------------------------------------------------
+// RSSIstore CLASS Implementation
+//--------------------------------------------------------------------------------------------------
+RSSIstore::RSSIstore() {
+    reset();
+}
+//---------------------------------------------------------------------------------------------------
+// reset  forget every sample, not to be called while readers are active
+//--------------------------------------------------------------------------------------------------
+void RSSIstore::reset() {
+    memset(head,0,sizeof(head));
+    memset(acc,0,sizeof(acc));
+}
+//---------------------------------------------------------------------------------------------------
+// now  ms since the epoch, buckets are aligned to the wall clock
+//--------------------------------------------------------------------------------------------------
+uint64_t RSSIstore::now() {
+struct timespec ts;
+    clock_gettime(CLOCK_REALTIME,&ts);
+    return (uint64_t)ts.tv_sec*1000+ts.tv_nsec/1000000;
+}
+//---------------------------------------------------------------------------------------------------
+const char* RSSIstore::name(int k) {
+const char* NAME[]={"raw","1s","1m","1h"};
+    return (k>=0 && k<RSSITIERS ? NAME[k] : "?");
+}
+//---------------------------------------------------------------------------------------------------
+// add  a sample taken now or at t (ms since the epoch), producer thread only
+//--------------------------------------------------------------------------------------------------
+void RSSIstore::add(int rssi) {
+    add(now(),rssi);
+}
+void RSSIstore::add(uint64_t t,int rssi) {
+
+    if (rssi<0) {rssi=0;}
+    if (rssi>255) {rssi=255;}
+
+RSSI_point p;
+    p.t=t;
+    p.min=p.mean=p.max=(uint8_t)rssi;
+    p.pad=0;
+    p.n=1;
+    push(RSSI_RAW,&p);
+    roll(RSSI_SEC,t,rssi,rssi,(uint64_t)rssi,1);
+}
+//---------------------------------------------------------------------------------------------------
+// push  write the point in its slot then publish it
+//--------------------------------------------------------------------------------------------------
+void RSSIstore::push(int k,RSSI_point* p) {
+
+uint64_t h=head[k];
+    ring[k][h%size[k]]=*p;
+    __atomic_store_n(&head[k],h+1,__ATOMIC_RELEASE);
+}
+//---------------------------------------------------------------------------------------------------
+// roll  fold a sample or a closed bucket of the tier below into tier k; a bucket that falls past
+// the one being filled closes it, which is pushed and rolled up in turn
+//--------------------------------------------------------------------------------------------------
+void RSSIstore::roll(int k,uint64_t t,int min,int max,uint64_t sum,uint32_t n) {
+
+RSSI_acc* a=&acc[k];
+uint64_t b=t-t%span[k];
+
+    if (a->n!=0 && a->t!=b) {
+       RSSI_point p;
+       p.t=a->t;
+       p.min=(uint8_t)a->min;
+       p.max=(uint8_t)a->max;
+       p.mean=(uint8_t)((a->sum+a->n/2)/a->n);
+       p.pad=0;
+       p.n=a->n;
+       push(k,&p);
+       if (k+1<RSSITIERS) {roll(k+1,a->t,a->min,a->max,a->sum,a->n);}
+       a->n=0;
+    }
+
+    if (a->n==0) {
+       a->t=b;
+       a->min=min;
+       a->max=max;
+       a->sum=0;
+    }
+    if (min<a->min) {a->min=min;}
+    if (max>a->max) {a->max=max;}
+    a->sum+=sum;
+    a->n+=n;
+}
+//---------------------------------------------------------------------------------------------------
+// count  points ever written to tier k, a change means a new point to show
+//--------------------------------------------------------------------------------------------------
+uint64_t RSSIstore::count(int k) {
+    return __atomic_load_n(&head[k],__ATOMIC_ACQUIRE);
+}
+//---------------------------------------------------------------------------------------------------
+// read  copy up to max of the newest points of tier k, oldest first, returns how many; any thread
+//--------------------------------------------------------------------------------------------------
+int RSSIstore::read(int k,RSSI_point* p,int max) {
+
+    if (k<0 || k>=RSSITIERS || max<=0) {return 0;}
+
+uint64_t h=__atomic_load_n(&head[k],__ATOMIC_ACQUIRE);
+uint64_t n=(h<size[k] ? h : size[k]);
+    if (n>(uint64_t)max) {n=(uint64_t)max;}
+uint64_t first=h-n;
+    for (uint64_t i=0;i<n;i++) {
+        p[i]=ring[k][(first+i)%size[k]];
+    }
+
+//*--- The writer may be filling slot h2%size while h2 is read, so only points from h2+1-size
+//*--- onwards are known to be intact
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+uint64_t h2=__atomic_load_n(&head[k],__ATOMIC_RELAXED);
+uint64_t valid=(h2+1>size[k] ? h2+1-size[k] : 0);
+    if (valid>first) {
+       uint64_t drop=valid-first;
+       if (drop>=n) {return 0;}
+       memmove(p,p+drop,(size_t)(n-drop)*sizeof(RSSI_point));
+       n-=drop;
+    }
+    return (int)n;
+}
+//---------------------------------------------------------------------------------------------------
+// last  newest point of tier k, 0 if there is none yet
+//--------------------------------------------------------------------------------------------------
+int RSSIstore::last(int k,RSSI_point* p) {
+    return read(k,p,1);
+}
+//---------------------------------------------------------------------------------------------------
+// write  export tier k as "tier,time,min,mean,max,n" lines, time in ms since the epoch
+//--------------------------------------------------------------------------------------------------
+int RSSIstore::write(FILE* f,int k) {
+
+    if (k<0 || k>=RSSITIERS) {return -1;}
+RSSI_point* p=new RSSI_point[size[k]];
+int n=read(k,p,(int)size[k]);
+    for (int i=0;i<n;i++) {
+        fprintf(f,"%s,%llu,%d,%d,%d,%u\n",name(k),(unsigned long long)p[i].t,p[i].min,p[i].mean,p[i].max,p[i].n);
+    }
+    delete[] p;
+    return n;
+}
@@ -0,0 +1,67 @@
+//--------------------------------------------------------------------------------------------------
+// SPSCQueue   (HEADER CLASS)
+// bounded lock-free queue for exactly one producer thread and one consumer thread
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SPSCQueue_h
+#define SPSCQueue_h
+
+#include <atomic>
+
+//---------------------------------------------------------------------------------------------------
+// SPSCQueue  N slots (a power of two), push() never blocks and counts what could not be queued
+//---------------------------------------------------------------------------------------------------
+template <class T,unsigned N>
+class SPSCQueue {
+
+  static_assert((N&(N-1))==0,"SPSCQueue size must be a power of two");
+
+  public:
+
+//*--- Producer side
+
+    bool push(const T& v) {
+         unsigned h=head.load(std::memory_order_relaxed);
+         if (h-tail.load(std::memory_order_acquire) >= N) {
+            dropped.fetch_add(1,std::memory_order_relaxed);
+            return false;
+         }
+         buf[h&(N-1)]=v;
+         head.store(h+1,std::memory_order_release);
+         return true;
+    }
+
+//*--- Consumer side
+
+    bool pop(T* v) {
+         unsigned t=tail.load(std::memory_order_relaxed);
+         if (t==head.load(std::memory_order_acquire)) {
+            return false;
+         }
+         *v=buf[t&(N-1)];
+         tail.store(t+1,std::memory_order_release);
+         return true;
+    }
+
+    unsigned size() {
+         return head.load(std::memory_order_acquire)-tail.load(std::memory_order_acquire);
+    }
+
+    std::atomic<unsigned long> dropped{0};  // push() calls rejected because the queue was full
+
+  private:
+
+    T buf[N];
+    std::atomic<unsigned> head{0};
+    char pad[64];                    // producer and consumer indexes kept on different cache lines
+    std::atomic<unsigned> tail{0};
+
+};
+
+#endif
+//*--------------------------------------------------------------------------------------------------*
+//*                                   End of Code                                                    *
+//*--------------------------------------------------------------------------------------------------*
@@ -0,0 +1,489 @@
+//--------------------------------------------------------------------------------------------------
+// SQLog   (HEADER CLASS)
+// append-only log of squelch openings, one fixed size record per opening with its frequency,
+// duration, peak and mean RSSI and CTCSS settings, written to a file thru mmap
+//--------------------------------------------------------------------------------------------------
+// The squelch interrupt only pushes the edge into a lock-free ring (one per module, pigpio runs
+// each GPIO callback on its own thread) and the application pushes the RSSI readings into another;
+// a thread of its own merges both by time, pairs the edges, folds the readings taken while the
+// squelch was open into the opening and appends the records. The record
+// count in the header is written after the record, a crash never leaves a partial one behind.
+// Records are appended as the squelch closes so they are sorted by closing time, which lets a
+// query binary search the mapped file and touch only the pages of the window asked for. A Pi has
+// no RTC and steps its clock when NTP syncs, so events are stamped from the monotonic clock plus
+// the offset to the wall clock taken at open(), and a record never closes ahead of the last one.
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef SQLog_h
+#define SQLog_h
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "./SPSCQueue.h"
+
+#define  SQLMAGIC     "picoSQL"      // file signature
+#define  SQLVERSION   1
+#define  SQLCHUNK     4096           // records the file grows by
+#define  SQLRIGS      8              // modules logged, one edge ring each
+#define  SQLCOMMIT    250            // ms between commits
+#define  SQLEDGES      64            // edges queued per module
+#define  SQLSAMPLES   256            // RSSI readings queued, all modules
+#define  SQLBATCH     (SQLSAMPLES+SQLRIGS*SQLEDGES)
+
+#define  SQL_CLOSE    0              // event kinds
+#define  SQL_OPEN     1
+#define  SQL_RSSI     2
+
+#define  SQLTRUNC     0x01           // record flag, still open when the log was closed
+
+//*---- Edge or RSSI reading handed to the commit thread
+
+struct SQLog_event
+{
+        uint64_t t;                  // us since the epoch, as of the wall clock at open()
+        uint32_t f;                  // Hz the module was listening to
+        uint8_t  rig;
+        uint8_t  kind;               // SQL_xxx
+        uint8_t  rx;                 // CTCSS index
+        uint8_t  tx;
+        int      rssi;
+};
+
+//*---- Record kept in the file, 24 bytes
+
+struct SQLog_rec
+{
+        uint64_t t;                  // us since the epoch the squelch opened
+        uint32_t ms;                 // ms it stayed open
+        uint32_t f;                  // Hz
+        uint8_t  peak;               // RSSI
+        uint8_t  mean;
+        uint8_t  rx;                 // CTCSS index
+        uint8_t  tx;
+        uint8_t  rig;
+        uint8_t  flags;              // SQLTRUNC
+        uint16_t n;                  // RSSI readings folded in
+};
+
+//*---- File header, followed by capacity records
+
+struct SQLog_hdr
+{
+        char     magic[8];
+        uint32_t version;
+        uint32_t size;               // bytes per record
+        uint64_t count;              // records committed, written after the record itself
+        uint64_t capacity;           // records the file has room for
+        uint32_t maxms;              // longest opening logged, bounds the scan of a query
+        char     pad[28];
+};
+
+//*---- Opening in progress per module
+
+struct SQLog_open
+{
+        bool     open;
+        uint64_t t;
+        uint32_t f;
+        uint8_t  rx;
+        uint8_t  tx;
+        int      peak;
+        uint64_t sum;
+        uint32_t n;
+};
+
+//---------------------------------------------------------------------------------------------------
+// SQLog
+//---------------------------------------------------------------------------------------------------
+class SQLog {
+
+  public:
+
+         SQLog();
+        ~SQLog();
+
+     int open(const char* path);
+    void close();
+    void edge(uint8_t rig,bool open,long f,int rx,int tx);
+    void sample(uint8_t rig,int rssi);
+     int commit();
+     int append(SQLog_rec* r);
+     int grow();
+    void fold(SQLog_event* e);
+     int end(uint8_t rig,uint64_t t,uint8_t flags);
+
+     uint64_t now();
+  static SQLog_hdr* map(const char* path,size_t* len);
+  static SQLog_rec* rec(SQLog_hdr* h,uint64_t i);
+  static uint64_t find(SQLog_hdr* h,uint64_t n,uint64_t t);
+
+    unsigned char TRACE=0x00;
+    int      fd=-1;
+    size_t   len=0;                  // bytes mapped
+    uint64_t base=0;                 // us the wall clock was ahead of the monotonic one at open()
+SQLog_hdr*   h=nullptr;
+    volatile bool running=false;
+    pthread_t thread;
+    unsigned long records=0;         // records appended since open()
+    unsigned long grows=0;           // times the file was extended
+    unsigned long lost=0;            // edges or readings dropped with a full ring
+SPSCQueue<SQLog_event,SQLEDGES>   edges[SQLRIGS];
+SPSCQueue<SQLog_event,SQLSAMPLES> samples;
+SQLog_open   cur[SQLRIGS];
+SQLog_event  batch[SQLBATCH];        // events of a commit pass, in time order
+
+const char   *PROGRAMID="SQLog";
+
+  private:
+
+    static void* loop(void* p);
+
+};
+
+#endif
+//---------------------------------------------------------------------------------------------------
+// SQLog CLASS Implementation
+//--------------------------------------------------------------------------------------------------
+SQLog::SQLog() {
+    memset(cur,0,sizeof(cur));
+}
+//---------------------------------------------------------------------------------------------------
+SQLog::~SQLog() {
+    close();
+}
+//---------------------------------------------------------------------------------------------------
+// now  microseconds since the epoch, the monotonic clock shifted by the wall clock at open() so a
+// step of the system clock never sends the stamps back
+//--------------------------------------------------------------------------------------------------
+uint64_t SQLog::now() {
+struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return base+(uint64_t)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
+//---------------------------------------------------------------------------------------------------
+// open  create the log or append to an existing one, map it and start the commit thread
+//--------------------------------------------------------------------------------------------------
+int SQLog::open(const char* path) {
+
+    fd=::open(path,O_RDWR|O_CREAT|O_CLOEXEC,0644);
+    if (fd<0) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s::open() error %d opening %s: %s\n",PROGRAMID,errno,path,strerror(errno)) : 0);
+       return -1;
+    }
+
+struct stat st;
+    fstat(fd,&st);
+bool fresh=(st.st_size==0);
+    len=(fresh==true ? sizeof(SQLog_hdr)+SQLCHUNK*sizeof(SQLog_rec) : (size_t)st.st_size);
+    if (fresh==true && ftruncate(fd,len)<0) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s::open() error %d sizing %s: %s\n",PROGRAMID,errno,path,strerror(errno)) : 0);
+       ::close(fd);
+       fd=-1;
+       return -1;
+    }
+
+void* p=mmap(NULL,len,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    if (p==MAP_FAILED) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s::open() error %d mapping %s: %s\n",PROGRAMID,errno,path,strerror(errno)) : 0);
+       ::close(fd);
+       fd=-1;
+       return -1;
+    }
+    h=(SQLog_hdr*)p;
+
+struct timespec rt;
+struct timespec mt;
+    clock_gettime(CLOCK_REALTIME,&rt);
+    clock_gettime(CLOCK_MONOTONIC,&mt);
+    base=((uint64_t)rt.tv_sec*1000000+rt.tv_nsec/1000)-((uint64_t)mt.tv_sec*1000000+mt.tv_nsec/1000);
+
+    if (fresh==true) {
+       memcpy(h->magic,SQLMAGIC,sizeof(h->magic));
+       h->version=SQLVERSION;
+       h->size=sizeof(SQLog_rec);
+       h->count=0;
+       h->capacity=SQLCHUNK;
+       h->maxms=0;
+    }
+    if (memcmp(h->magic,SQLMAGIC,sizeof(h->magic))!=0 || h->version!=SQLVERSION || h->size!=sizeof(SQLog_rec) ||
+        sizeof(SQLog_hdr)+h->capacity*sizeof(SQLog_rec)>len) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s::open() %s is not a squelch log, left untouched\n",PROGRAMID,path) : 0);
+       munmap(h,len);
+       h=nullptr;
+       ::close(fd);
+       fd=-1;
+       return -1;
+    }
+
+    running=true;
+    if (pthread_create(&thread,NULL,SQLog::loop,this)!=0) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s::open() unable to create commit thread\n",PROGRAMID) : 0);
+       running=false;
+       return -1;
+    }
+    (TRACE>=0x01 ? fprintf(stderr,"%s::open() %s holds %llu records\n",PROGRAMID,path,(unsigned long long)h->count) : 0);
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+// close  stop the commit thread, openings still in progress are logged as truncated
+//--------------------------------------------------------------------------------------------------
+void SQLog::close() {
+
+    if (running==true) {
+       running=false;
+       pthread_join(thread,NULL);
+    }
+    if (h==nullptr) return;
+
+    commit();
+uint64_t t=now();
+    for (int i=0;i<SQLRIGS;i++) {
+        if (cur[i].open==true) {end(i,t,SQLTRUNC);}
+    }
+    msync(h,len,MS_SYNC);
+    munmap(h,len);
+    h=nullptr;
+    ::close(fd);
+    fd=-1;
+}
+//---------------------------------------------------------------------------------------------------
+// edge  squelch of a module opened or closed, called from the GPIO interrupt: only a push
+//--------------------------------------------------------------------------------------------------
+void SQLog::edge(uint8_t rig,bool open,long f,int rx,int tx) {
+
+    if (rig>=SQLRIGS) return;
+SQLog_event e;
+    e.t=now();
+    e.f=(uint32_t)f;
+    e.rig=rig;
+    e.kind=(open==true ? SQL_OPEN : SQL_CLOSE);
+    e.rx=(uint8_t)rx;
+    e.tx=(uint8_t)tx;
+    e.rssi=0;
+    edges[rig].push(e);
+}
+//---------------------------------------------------------------------------------------------------
+// sample  RSSI reading of a module, folded into the opening in progress if any
+//--------------------------------------------------------------------------------------------------
+void SQLog::sample(uint8_t rig,int rssi) {
+
+    if (rig>=SQLRIGS) return;
+SQLog_event e;
+    e.t=now();
+    e.f=0;
+    e.rig=rig;
+    e.kind=SQL_RSSI;
+    e.rx=0;
+    e.tx=0;
+    e.rssi=rssi;
+    samples.push(e);
+}
+//---------------------------------------------------------------------------------------------------
+// commit  drain the rings into the file, edges and readings handled in the order they were taken
+// so a reading counts for the opening it was taken in, whatever pass it comes in; returns the
+// records appended
+//--------------------------------------------------------------------------------------------------
+int SQLog::commit() {
+
+SQLog_event e;
+int n=0;
+int k=0;
+
+    while (k<SQLBATCH && samples.pop(&batch[k])==true) {k++;}
+    for (int i=0;i<SQLRIGS;i++) {
+        while (k<SQLBATCH && edges[i].pop(&batch[k])==true) {k++;}
+    }
+
+//*--- Every ring is already in order, an insertion sort merges them, the readings (first in the
+//*--- batch) stay ahead of an edge taken at the same us
+
+    for (int i=1;i<k;i++) {
+        e=batch[i];
+        int j=i-1;
+        while (j>=0 && batch[j].t>e.t) {
+           batch[j+1]=batch[j];
+           j--;
+        }
+        batch[j+1]=e;
+    }
+
+    for (int m=0;m<k;m++) {
+        SQLog_event* p=&batch[m];
+        int i=p->rig;
+        if (p->kind==SQL_RSSI) {
+           fold(p);
+           continue;
+        }
+        if (p->kind==SQL_OPEN) {
+           if (cur[i].open==true) {n+=(end(i,p->t,0)==0 ? 1 : 0);}   // close edge lost
+           cur[i].open=true;
+           cur[i].t=p->t;
+           cur[i].f=p->f;
+           cur[i].rx=p->rx;
+           cur[i].tx=p->tx;
+           cur[i].peak=0;
+           cur[i].sum=0;
+           cur[i].n=0;
+           continue;
+        }
+        if (cur[i].open==true) {n+=(end(i,p->t,0)==0 ? 1 : 0);}
+    }
+
+unsigned long d=samples.dropped;
+    for (int i=0;i<SQLRIGS;i++) {d+=edges[i].dropped;}
+    lost=d;
+    return n;
+}
+//---------------------------------------------------------------------------------------------------
+// fold  RSSI reading into the opening in progress of its module, readings past its close never
+// get here as the close comes first in the batch
+//--------------------------------------------------------------------------------------------------
+void SQLog::fold(SQLog_event* e) {
+
+SQLog_open* o=&cur[e->rig];
+    if (o->open==false || e->t<o->t || e->rssi<0) return;
+    if (e->rssi>o->peak) {o->peak=e->rssi;}
+    o->sum+=(uint64_t)e->rssi;
+    o->n++;
+}
+//---------------------------------------------------------------------------------------------------
+// end  the opening of a module closed at t, append its record; a close ahead of the last record
+// (the wall clock went back between two runs) is moved up to it to keep find() valid
+//--------------------------------------------------------------------------------------------------
+int SQLog::end(uint8_t rig,uint64_t t,uint8_t flags) {
+
+SQLog_open* o=&cur[rig];
+SQLog_rec r;
+    o->open=false;
+    memset(&r,0,sizeof(r));
+    r.t=o->t;
+    r.ms=(uint32_t)(t>o->t ? (t-o->t)/1000 : 0);
+    if (h!=nullptr && h->count>0) {
+       SQLog_rec* l=rec(h,h->count-1);
+       uint64_t c=l->t+(uint64_t)l->ms*1000;
+       if (r.t+(uint64_t)r.ms*1000<c) {r.t=c-(uint64_t)r.ms*1000;}
+    }
+    r.f=o->f;
+    r.peak=(uint8_t)(o->peak>255 ? 255 : o->peak);
+    r.mean=(uint8_t)(o->n>0 ? (o->sum/o->n>255 ? 255 : o->sum/o->n) : 0);
+    r.rx=o->rx;
+    r.tx=o->tx;
+    r.rig=rig;
+    r.flags=flags;
+    r.n=(uint16_t)(o->n>65535 ? 65535 : o->n);
+    return append(&r);
+}
+//---------------------------------------------------------------------------------------------------
+// append  copy the record past the last one and only then count it
+//--------------------------------------------------------------------------------------------------
+int SQLog::append(SQLog_rec* r) {
+
+    if (h==nullptr) return -1;
+    if (h->count>=h->capacity && grow()<0) return -1;
+
+    memcpy(rec(h,h->count),r,sizeof(SQLog_rec));
+    if (r->ms>h->maxms) {h->maxms=r->ms;}
+    __atomic_store_n(&h->count,h->count+1,__ATOMIC_RELEASE);
+    records++;
+    (TRACE>=0x02 ? fprintf(stderr,"%s::append() f(%u) %u ms peak(%d) mean(%d)\n",PROGRAMID,r->f,r->ms,r->peak,r->mean) : 0);
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+// grow  extend the file by SQLCHUNK records and map it again
+//--------------------------------------------------------------------------------------------------
+int SQLog::grow() {
+
+size_t n=len+SQLCHUNK*sizeof(SQLog_rec);
+    if (ftruncate(fd,n)<0) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s::grow() error %d extending the log: %s\n",PROGRAMID,errno,strerror(errno)) : 0);
+       return -1;
+    }
+void* p=mremap(h,len,n,MREMAP_MAYMOVE);
+    if (p==MAP_FAILED) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s::grow() error %d mapping the log: %s\n",PROGRAMID,errno,strerror(errno)) : 0);
+       return -1;
+    }
+    h=(SQLog_hdr*)p;
+    len=n;
+    h->capacity+=SQLCHUNK;
+    grows++;
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+// loop  commit thread
+//--------------------------------------------------------------------------------------------------
+void* SQLog::loop(void* p) {
+
+SQLog* l=(SQLog*)p;
+struct timespec ts;
+    ts.tv_sec=SQLCOMMIT/1000;
+    ts.tv_nsec=(SQLCOMMIT%1000)*1000000L;
+    while (l->running==true) {
+       if (l->commit()>0) {msync(l->h,l->len,MS_ASYNC);}
+       nanosleep(&ts,NULL);
+    }
+    return NULL;
+}
+//---------------------------------------------------------------------------------------------------
+// map  read only mapping of a log for queries, pages are only read as they are touched
+//--------------------------------------------------------------------------------------------------
+SQLog_hdr* SQLog::map(const char* path,size_t* len) {
+
+int fd=::open(path,O_RDONLY|O_CLOEXEC);
+    if (fd<0) return nullptr;
+struct stat st;
+    if (fstat(fd,&st)<0 || (size_t)st.st_size<sizeof(SQLog_hdr)) {
+       ::close(fd);
+       return nullptr;
+    }
+void* p=mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+    ::close(fd);
+    if (p==MAP_FAILED) return nullptr;
+
+SQLog_hdr* h=(SQLog_hdr*)p;
+    if (memcmp(h->magic,SQLMAGIC,sizeof(h->magic))!=0 || h->version!=SQLVERSION || h->size!=sizeof(SQLog_rec) ||
+        sizeof(SQLog_hdr)+h->count*sizeof(SQLog_rec)>(size_t)st.st_size) {
+       munmap(p,st.st_size);
+       return nullptr;
+    }
+    *len=st.st_size;
+    return h;
+}
+//---------------------------------------------------------------------------------------------------
+// rec  record i of a mapped log
+//--------------------------------------------------------------------------------------------------
+SQLog_rec* SQLog::rec(SQLog_hdr* h,uint64_t i) {
+    return (SQLog_rec*)((char*)h+sizeof(SQLog_hdr))+i;
+}
+//---------------------------------------------------------------------------------------------------
+// find  first of the n records mapped closed at or after t (us since the epoch), n if none
+//--------------------------------------------------------------------------------------------------
+uint64_t SQLog::find(SQLog_hdr* h,uint64_t n,uint64_t t) {
+
+uint64_t lo=0;
+uint64_t hi=n;
+    while (lo<hi) {
+       uint64_t k=lo+(hi-lo)/2;
+       SQLog_rec* r=rec(h,k);
+       if (r->t+(uint64_t)r->ms*1000<t) {
+          lo=k+1;
+       } else {
+          hi=k;
+       }
+    }
+    return lo;
+}
+//*--------------------------------------------------------------------------------------------------*
+//*                                   End of Code                                                    *
+//*--------------------------------------------------------------------------------------------------*
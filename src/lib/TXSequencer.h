@@ -0,0 +1,316 @@
+//--------------------------------------------------------------------------------------------------
+// TXSequencer   (HEADER CLASS)
+// keys the transmitter straight from the mic PTT edge, enabling the PA first and the PTT line
+// once the key-up delay elapsed, and on release dropping the PTT first and the PA once the
+// key-down delay elapsed, so the amplifier never switches with RF on it
+//--------------------------------------------------------------------------------------------------
+// The GPIO callback only posts the request; a thread of its own (real time priority when allowed)
+// runs the sequence on a monotonic clock and is the only one writing both lines. Requests coming
+// from the application (CAT, watchdog, menu) go the same way and are no-ops when the line is
+// already where asked. The mic callback reports every edge (mic()), the application can release
+// the transmitter anytime but only key it while the mic is held, so a press the GUI replays
+// after the release never keys it again. A release during the key-up delay aborts it with the
+// PTT never keyed.
+// The latency from the mic edge (pigpio tick) to each line is kept in histograms.
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef TXSequencer_h
+#define TXSequencer_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+//*--- Histogram comes with DRA818V.h, include ./Histogram.h first when used without it
+
+#define  TXKEYUP       20             // ms from the PA enabled to the PTT keyed
+#define  TXKEYDOWN     20             // ms from the PTT released to the PA disabled
+#define  TXPRIORITY    50             // SCHED_FIFO priority of the sequencer thread
+
+#define  TX_RX          0             // states
+#define  TX_KEYUP       1             // PA enabled, waiting to key the PTT
+#define  TX_TX          2
+#define  TX_KEYDOWN     3             // PTT released, waiting to disable the PA
+
+typedef int      (*TXWRITE)(unsigned gpio,unsigned level);
+typedef uint32_t (*TXTICK)(void);
+
+//---------------------------------------------------------------------------------------------------
+// TXSequencer
+//---------------------------------------------------------------------------------------------------
+class TXSequencer {
+
+  public:
+
+         TXSequencer(TXWRITE w,TXTICK t);
+        ~TXSequencer();
+
+     int start(int ptt,int pa);
+    void stop();
+    void key(bool on,uint32_t tick);
+    void mic(bool pressed);
+    void setDelay(int up,int down);
+    bool keyed();
+    void stats(FILE* f);
+
+     int up=TXKEYUP;                   // ms
+     int down=TXKEYDOWN;               // ms
+     int state=TX_RX;
+     int TRACE=0x00;
+const char   *PROGRAMID="TXSequencer";
+unsigned long keys=0;                  // times the PTT was keyed
+unsigned long aborts=0;                // releases during the key-up delay
+unsigned long ignored=0;               // application key-ups with the mic already released
+Histogram latency;                     // us from the mic edge to the PTT keyed beyond the key-up delay
+Histogram palatency;                   // us from the mic edge to the PA enabled
+
+  private:
+
+  static void* loop(void* p);
+    void run();
+    void apply(bool on,uint32_t tick);
+    void keyPTT(bool on,uint32_t tick);
+    void enablePA(bool on,uint32_t tick);
+  static uint64_t now();
+
+TXWRITE  write=NULL;
+TXTICK   tick=NULL;
+     int ptt=-1;                       // GPIO, active low
+     int pa=-1;                        // GPIO, active high, -1 if there is none
+bool     running=false;
+bool     pending=false;
+bool     want=false;
+bool     held=false;                   // mic PTT pressed, as the mic callback last reported it
+uint32_t wtick=0;                      // mic edge of the request, 0 if it came from the application
+uint32_t etick=0;                      // mic edge of the sequence running
+uint64_t tnext=0;                      // us (monotonic) of the next step
+pthread_t thread;
+pthread_mutex_t mtx;
+pthread_cond_t  cond;
+
+};
+
+#endif
+//---------------------------------------------------------------------------------------------------
+// TXSequencer CLASS Implementation
+//--------------------------------------------------------------------------------------------------
+TXSequencer::TXSequencer(TXWRITE w,TXTICK t) {
+
+    write=w;
+    tick=t;
+    pthread_mutex_init(&mtx,NULL);
+pthread_condattr_t a;
+    pthread_condattr_init(&a);
+    pthread_condattr_setclock(&a,CLOCK_MONOTONIC);
+    pthread_cond_init(&cond,&a);
+    pthread_condattr_destroy(&a);
+}
+TXSequencer::~TXSequencer() {
+    stop();
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mtx);
+}
+//---------------------------------------------------------------------------------------------------
+uint64_t TXSequencer::now() {
+struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
+//---------------------------------------------------------------------------------------------------
+// setDelay  key-up and key-down delays in ms, 0 switches both lines together
+//--------------------------------------------------------------------------------------------------
+void TXSequencer::setDelay(int u,int d) {
+    pthread_mutex_lock(&mtx);
+    up=(u<0 ? 0 : u);
+    down=(d<0 ? 0 : d);
+    pthread_mutex_unlock(&mtx);
+}
+//---------------------------------------------------------------------------------------------------
+// start  take over the PTT and PA lines (both left off) and start the sequencer thread
+//--------------------------------------------------------------------------------------------------
+int TXSequencer::start(int p,int a) {
+
+    if (running==true) {return 0;}
+    ptt=p;
+    pa=a;
+    state=TX_RX;
+    pending=false;                     // a request posted before it started is stale
+    if (ptt>=0) {write(ptt,1);}
+    if (pa>=0) {write(pa,0);}
+    running=true;
+    if (pthread_create(&thread,NULL,&TXSequencer::loop,this)!=0) {
+       running=false;
+       (TRACE>=0x00 ? fprintf(stderr,"%s::start() unable to create the sequencer thread\n",PROGRAMID) : 0);
+       return -1;
+    }
+
+struct sched_param sp;
+    sp.sched_priority=TXPRIORITY;
+    if (pthread_setschedparam(thread,SCHED_FIFO,&sp)!=0) {
+       (TRACE>=0x01 ? fprintf(stderr,"%s::start() no real time priority, running as a normal thread\n",PROGRAMID) : 0);
+    }
+    (TRACE>=0x01 ? fprintf(stderr,"%s::start() PTT(%d) PA(%d) key-up(%d ms) key-down(%d ms)\n",PROGRAMID,ptt,pa,up,down) : 0);
+    return 0;
+}
+//---------------------------------------------------------------------------------------------------
+// stop  end the thread and leave both lines off at once
+//--------------------------------------------------------------------------------------------------
+void TXSequencer::stop() {
+
+    if (running==false) {return;}
+    pthread_mutex_lock(&mtx);
+    running=false;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&mtx);
+    pthread_join(thread,NULL);
+    if (ptt>=0) {write(ptt,1);}
+    if (pa>=0) {write(pa,0);}
+    state=TX_RX;
+}
+//---------------------------------------------------------------------------------------------------
+// key  ask for the transmitter on or off, from any thread; t is the tick of the mic edge or 0
+//--------------------------------------------------------------------------------------------------
+void TXSequencer::key(bool on,uint32_t t) {
+
+    pthread_mutex_lock(&mtx);
+    if (on==true && t==0 && held==false) {
+       ignored++;
+       pthread_mutex_unlock(&mtx);
+      (TRACE>=0x02 ? fprintf(stderr,"%s:key() mic PTT released, key-up request ignored\n",PROGRAMID) : 0);
+       return;
+    }
+    want=on;
+    wtick=t;
+    pending=true;
+    pthread_cond_signal(&cond);
+    pthread_mutex_unlock(&mtx);
+}
+//---------------------------------------------------------------------------------------------------
+// mic  the mic PTT line changed, called by its callback ahead of key() whether it keys or not
+//--------------------------------------------------------------------------------------------------
+void TXSequencer::mic(bool pressed) {
+
+    pthread_mutex_lock(&mtx);
+    held=pressed;
+    pthread_mutex_unlock(&mtx);
+}
+//---------------------------------------------------------------------------------------------------
+bool TXSequencer::keyed() {
+    return state==TX_TX;
+}
+//---------------------------------------------------------------------------------------------------
+void* TXSequencer::loop(void* p) {
+    ((TXSequencer*)p)->run();
+    return NULL;
+}
+//---------------------------------------------------------------------------------------------------
+// run  apply the requests and take the timed steps, sleeping until whichever comes first
+//--------------------------------------------------------------------------------------------------
+void TXSequencer::run() {
+
+    pthread_mutex_lock(&mtx);
+    while (running==true) {
+
+       if (pending==true) {
+          pending=false;
+          apply(want,wtick);
+          continue;
+       }
+
+       if (state==TX_KEYUP || state==TX_KEYDOWN) {
+          if (now()>=tnext) {
+             if (state==TX_KEYUP) {
+                keyPTT(true,etick);
+             } else {
+                enablePA(false,0);
+                state=TX_RX;
+             }
+             continue;
+          }
+          struct timespec ts;
+          ts.tv_sec=(time_t)(tnext/1000000);
+          ts.tv_nsec=(long)(tnext%1000000)*1000;
+          pthread_cond_timedwait(&cond,&mtx,&ts);
+          continue;
+       }
+       pthread_cond_wait(&cond,&mtx);
+    }
+    pthread_mutex_unlock(&mtx);
+}
+//---------------------------------------------------------------------------------------------------
+// apply  a request against the state of the sequence
+//--------------------------------------------------------------------------------------------------
+void TXSequencer::apply(bool on,uint32_t t) {
+
+    if (on==true) {
+       switch(state) {
+         case TX_RX:
+              etick=t;
+              enablePA(true,t);
+              if (pa<0 || up==0) {
+                 keyPTT(true,t);
+              } else {
+                 state=TX_KEYUP;
+                 tnext=now()+(uint64_t)up*1000;
+              }
+              break;
+         case TX_KEYDOWN:                      // keyed again before the PA went off, it still is on
+              etick=t;
+              keyPTT(true,t);
+              break;
+       }
+       return;
+    }
+
+    switch(state) {
+      case TX_KEYUP:
+           enablePA(false,0);
+           state=TX_RX;
+           aborts++;
+           break;
+      case TX_TX:
+           keyPTT(false,0);
+           if (pa<0 || down==0) {
+              enablePA(false,0);
+              state=TX_RX;
+           } else {
+              state=TX_KEYDOWN;
+              tnext=now()+(uint64_t)down*1000;
+           }
+           break;
+    }
+}
+//---------------------------------------------------------------------------------------------------
+// keyPTT  write the PTT line; keyed from a mic edge the time beyond the key-up delay is recorded
+//--------------------------------------------------------------------------------------------------
+void TXSequencer::keyPTT(bool on,uint32_t t) {
+
+    if (ptt>=0) {write(ptt,(on==true ? 0 : 1));}
+    if (on==false) {return;}
+    state=TX_TX;
+    keys++;
+    if (t==0 || tick==NULL) {return;}
+uint32_t us=tick()-t;
+uint32_t delay=(pa<0 ? 0 : (uint32_t)up*1000);
+    latency.record(us>delay ? us-delay : 0);
+}
+//---------------------------------------------------------------------------------------------------
+void TXSequencer::enablePA(bool on,uint32_t t) {
+
+    if (pa<0) {return;}
+    write(pa,(on==true ? 1 : 0));
+    if (on==true && t!=0 && tick!=NULL) {palatency.record(tick()-t);}
+}
+//---------------------------------------------------------------------------------------------------
+void TXSequencer::stats(FILE* f) {
+
+    fprintf(f,"tx key-up=%d ms key-down=%d ms keys=%lu aborts=%lu ignored=%lu\n",up,down,keys,aborts,ignored);
+    latency.print(f,"MIC-PTT");
+    palatency.print(f,"MIC-PA");
+}
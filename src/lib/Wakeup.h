@@ -0,0 +1,70 @@
+//--------------------------------------------------------------------------------------------------
+// Wakeup   (HEADER CLASS)
+// eventfd a producer thread rings to wake up the reactor (EventLoop) of a consumer thread sleeping
+// on it, keeping the time of the oldest ring not yet taken so the consumer knows how long it waited
+//--------------------------------------------------------------------------------------------------
+// Solo para uso de radioaficionados, prohibido su utilizacion comercial
+// Copyright 2018 Dr. Pedro E. Colla (LU7DID)
+//--------------------------------------------------------------------------------------------------
+
+#ifndef Wakeup_h
+#define Wakeup_h
+
+#include <unistd.h>
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+#include <sys/eventfd.h>
+
+//---------------------------------------------------------------------------------------------------
+// Wakeup  ring() from any number of threads, fd becomes readable until take() is called
+//---------------------------------------------------------------------------------------------------
+class Wakeup {
+
+  public:
+
+         Wakeup()  {fd=eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC);}
+        ~Wakeup()  {if (fd>=0) {close(fd);}}
+
+//*--- Producer side, after the work is queued
+
+    void ring() {
+         uint64_t z=0;
+         t0.compare_exchange_strong(z,now(),std::memory_order_relaxed);
+         uint64_t v=1;
+         if (write(fd,&v,sizeof(v))<0) {v=0;}     // only when the counter is full, it is readable anyway
+         rings.fetch_add(1,std::memory_order_relaxed);
+    }
+
+//*--- Consumer side, before the work is taken; us since the oldest ring or -1 if none was pending
+
+    long take() {
+         uint64_t v;
+         if (read(fd,&v,sizeof(v))<0) {v=0;}
+         uint64_t t=t0.exchange(0,std::memory_order_relaxed);
+         if (t==0) {return -1;}
+         uint64_t n=now();
+         return (n>t ? (long)((n-t)/1000) : 0);
+    }
+
+//*--- ns of CLOCK_MONOTONIC, the clock of the stamps and of the UI timerfds
+
+    static uint64_t now() {
+         struct timespec ts;
+         clock_gettime(CLOCK_MONOTONIC,&ts);
+         return (uint64_t)ts.tv_sec*1000000000ULL+(uint64_t)ts.tv_nsec;
+    }
+
+     int fd=-1;
+    std::atomic<unsigned long> rings{0};   // ring() calls
+
+  private:
+
+    std::atomic<uint64_t> t0{0};           // ns of the oldest ring not taken, 0 if none
+
+};
+
+#endif
+//*--------------------------------------------------------------------------------------------------*
+//*                                   End of Code                                                    *
+//*--------------------------------------------------------------------------------------------------*
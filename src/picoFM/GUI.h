@@ -7,7 +7,7 @@ void setBacklight(bool v) {
     if (lcd==nullptr) return;
     lcd->backlight(v);
     lcd->setCursor(0,0);
-    if (backlight!=0) { TBACKLIGHT=backlight; }
+    if (backlight!=0) { setTimer(UI_BACKLIGHT,backlight); }
 }
 //--------------------------------------------------------------------------------------------------
 // returns the time in a string format
@@ -31,7 +31,6 @@ void setupLCD() {
 //*--- setup LCD configuration
 
 
-   lcd=new LCDLib(NULL);
    (TRACE>=0x01 ? fprintf(stderr,"%s:setupLCD() LCD system initialization\n",PROGRAMID) : _NOP);
 
    lcd->begin(16,2);
@@ -56,43 +55,23 @@ void setupLCD() {
 }
 
 //*--------------------------[Rotary Encoder Interrupt Handler]--------------------------------------
-//* Interrupt handler for Rotary Encoder CW and CCW control
+//* Alert handler for Rotary Encoder CW and CCW control, every edge of CLK and DT with its level and
+//* tick; both lines are served by the pigpio alert thread, one at a time and in order
 //*--------------------------------------------------------------------------------------------------
 void updateEncoders(int gpio, int level, uint32_t tick)
 {
-        if (level != 0) {  //ignore non falling part of the interruption
+        if (level != 0 && level != 1) {  //ignore watchdog timeouts
            return;
         }
 
-        setBacklight(true);
-
-        if (getWord(GSW,ECW)==true || getWord(GSW,ECCW) ==true) { //exit if pending to service a previous one
-           (TRACE>=0x02 ? fprintf(stderr,"%s:updateEnconders() Last CW/CCW signal pending processsing, ignored!\n",PROGRAMID) : _NOP);
+        int dir=quad->edge((gpio==GPIO_CLK ? QUAD_CLK : QUAD_DT),level,tick);
+        if (dir==0) {
            return;
         }
 
-        int clkState=gpioRead(GPIO_CLK);
-        int dtState= gpioRead(GPIO_DT);
-
-        endEncoder = std::chrono::system_clock::now();
-
-        int lapEncoder=std::chrono::duration_cast<std::chrono::milliseconds>(endEncoder - startEncoder).count();
-
-        if ( lapEncoder  < MINENCLAP )  {
-           (TRACE>=0x02 ? fprintf(stderr,"%s:updateEnconders() CW/CCW signal too close from last, ignored lap(%d)!\n",PROGRAMID,lapEncoder) : _NOP);
-           return;
-        }
-
-        if (dtState != clkState) {
-          counter++;
-          setWord(&GSW,ECCW,true);
-        } else {
-          counter--;
-          setWord(&GSW,ECW,true);
-        }
-
-        clkLastState=clkState;        
-        startEncoder = std::chrono::system_clock::now();
+        setBacklight(true);
+        counter-=dir;
+        inq->push(INP_ENC,dir,tick);
 
 }
 
@@ -107,48 +86,52 @@ void updateSW(int gpio, int level, uint32_t tick)
      if (level != 0) {
         endPush = std::chrono::system_clock::now();
         int lapPush=std::chrono::duration_cast<std::chrono::milliseconds>(endPush - startPush).count();
-        if (getWord(GSW,FSW)==true || getWord(GSW,FSWL)==true) {
-           (TRACE>=0x02 ? fprintf(stderr,"%s:updateSW() Last SW signal pending processsing, ignored!\n",PROGRAMID) : _NOP);
-           return;
-        }
         if (lapPush < MINSWPUSH) {
            (TRACE>=0x02 ? fprintf(stderr,"%s:updateSW() SW pulsetoo short! ignored!\n",PROGRAMID) : _NOP) ;
            return;
         } else {
            if (lapPush > MAXSWPUSH) {
               (TRACE>=0x02 ? fprintf(stderr,"%s:updateSW() SW long pulse detected lap(%d)\n",PROGRAMID,lapPush) : _NOP);
-              setWord(&GSW,FSWL,true);
+              inq->push(INP_SW,1,tick);
            } else {
               (TRACE>=0x02 ? fprintf(stderr,"%s:updateSW() SW brief pulse detected lap(%d)\n",PROGRAMID,lapPush) : _NOP);
-              setWord(&GSW,FSW,true);
+              inq->push(INP_SW,0,tick);
            }
            return;
         }
      }
      startPush = std::chrono::system_clock::now();
-     int pushSW=gpioRead(GPIO_SW);
+     int pushSW=hal->read(GPIO_SW);
 }
 //*--------------------------[Rotary Encoder Interrupt Handler]--------------------------------------
-//* Interrupt handler routine for Squelch
+//* Interrupt handler routine for Squelch, it only posts the edge (no lock is taken here), setSQ() and the
+//* scanner decision run on the main thread when the edge is drained
 //*--------------------------------------------------------------------------------------------------
 void updateSQL(int gpio, int level, uint32_t tick)
 {
 
+//*--- Modules other than the one in the front panel only track their squelch status
+
+     for (int i=1;i<nrig;i++) {
+         if (rig[i].sql==gpio && rig[i].d!=nullptr) {
+            if (sqlog!=nullptr) {sqlog->edge(i,level==0,rig[i].d->rxFreq(),rig[i].d->getRxCTCSS(),rig[i].d->getTxCTCSS());}
+            rig[i].d->postSQ(level==0);
+            return;
+         }
+     }
+     if (sqlog!=nullptr && d!=nullptr) {sqlog->edge(0,level==0,d->rxFreq(),d->getRxCTCSS(),d->getTxCTCSS());}
+
      setBacklight(true);
 
      if (level != 0) {
         endSQL = std::chrono::system_clock::now();
         int lapSQL=std::chrono::duration_cast<std::chrono::milliseconds>(endSQL - startSQL).count();
-        pushSQL=1;
-        if (d!=nullptr) {setWord(&d->dra[m].STATUS,SQ,false);}
-        setWord(&GSW,FSQ,true);
+        inq->push(INP_SQL,0,tick);
         return;
      }
 
      startSQL = std::chrono::system_clock::now();
-     pushSQL=0;
-     if (d!=nullptr) {setWord(&d->dra[m].STATUS,SQ,true);}
-     setWord(&GSW,FSQ,true);
+     inq->push(INP_SQL,1,tick);
 
 }
 //*--------------------------[Rotary Encoder Interrupt Handler]--------------------------------------
@@ -157,33 +140,50 @@ void updateSQL(int gpio, int level, uint32_t tick)
 void updateMICPTT(int gpio, int level, uint32_t tick)
 {
 
+//*---- Key (or release) the transmitter first, the application follows when it drains the queue
+
+     if (txseq!=nullptr) {
+        txseq->mic(level==0);
+        if (level!=0) {
+           txseq->key(false,tick);
+           if (d!=nullptr) {d->unKey();}
+        } else {
+           if (d!=nullptr && d->canKey()==true) {txseq->key(true,tick);}
+        }
+     }
+
      setBacklight(true);
      if (level != 0) {
         endPTT = std::chrono::system_clock::now();
     int lapPTT=std::chrono::duration_cast<std::chrono::milliseconds>(endPTT - startPTT).count();
-        pushPTT=1;
-       (TRACE>=0x03 ? fprintf(stderr,"%s:updateMICPTT() GPIO level up pushPTT(%d)\n",PROGRAMID,pushPTT) : _NOP);
-        setWord(&GSW,FPTT,true);
+       (TRACE>=0x03 ? fprintf(stderr,"%s:updateMICPTT() GPIO level up\n",PROGRAMID) : _NOP);
+        inq->push(INP_PTT,0,tick);
         if (watchdog!=0) {
-            TWATCHDOG=watchdog;
+            setTimer(UI_WATCHDOG,watchdog);
         }
         return;
      }
      startPTT = std::chrono::system_clock::now();
-     pushPTT=gpioRead(GPIO_MICPTT);
-     pushPTT=0;
-     setWord(&GSW,FPTT,true);
-    (TRACE>=0x03 ? fprintf(stderr,"%s:updateMICPTT() GPIO level down pushPTT(%d)\n",PROGRAMID,pushPTT) : _NOP);
+     inq->push(INP_PTT,1,tick);
+    (TRACE>=0x03 ? fprintf(stderr,"%s:updateMICPTT() GPIO level down\n",PROGRAMID) : _NOP);
      setWord(&vfo->FT817,WATCHDOG,false);
 }
 //*--------------------------------------------------------------------------------------------------
+//* halWrite, halTick  GPIO write and tick of the backend in use, for the modules taking functions
+//*--------------------------------------------------------------------------------------------------
+int halWrite(unsigned gpio,unsigned level) {
+    return hal->write(gpio,level);
+}
+uint32_t halTick() {
+    return hal->tick();
+}
+//*--------------------------------------------------------------------------------------------------
 //* setupGPIO setup the GPIO definitions
 //*--------------------------------------------------------------------------------------------------
 void setupGPIO() {
 
     (TRACE>=0x00 ? fprintf(stderr,"%s:setupGPIO() Starting....\n",PROGRAMID) : _NOP);
-    gpioCfgClock(5, 0, 0);
-    if(gpioInitialise()<0) {
+    if(hal->init()<0) {
         (TRACE>=0x00 ? fprintf(stderr,"%s:setupGPIO() Cannot initialize GPIO\n",PROGRAMID) : _NOP);
         exit(16);
     }
@@ -191,61 +191,82 @@ void setupGPIO() {
 //*---- Configure Encoder
 
     (TRACE>=0x02 ? fprintf(stderr,"%s:setupGPIO() Setup Encoder Push\n",PROGRAMID) : _NOP);
-    gpioSetMode(GPIO_SW, PI_INPUT);
-    gpioSetPullUpDown(GPIO_SW,PI_PUD_UP);
-    gpioSetAlertFunc(GPIO_SW,updateSW);
+    hal->setMode(GPIO_SW, HAL_INPUT);
+    hal->setPull(GPIO_SW,HAL_PUD_UP);
+    hal->setAlert(GPIO_SW,updateSW);
     usleep(100000);
 
     (TRACE>=0x02 ? fprintf(stderr,"%s:setupGPIO() Setup Encoder\n",PROGRAMID) : _NOP);
 
-    gpioSetMode(GPIO_CLK, PI_INPUT);
-    gpioSetPullUpDown(GPIO_CLK,PI_PUD_UP);
-    usleep(100000);
-    gpioSetISRFunc(GPIO_CLK, FALLING_EDGE,0,updateEncoders);
-
-    gpioSetMode(GPIO_DT, PI_INPUT);
-    gpioSetPullUpDown(GPIO_DT,PI_PUD_UP);
+    hal->setMode(GPIO_CLK, HAL_INPUT);
+    hal->setPull(GPIO_CLK,HAL_PUD_UP);
+    hal->setMode(GPIO_DT, HAL_INPUT);
+    hal->setPull(GPIO_DT,HAL_PUD_UP);
     usleep(100000);
+    quad->reset(hal->read(GPIO_CLK),hal->read(GPIO_DT));
+    hal->setGlitch(GPIO_CLK,QUADGLITCH);
+    hal->setGlitch(GPIO_DT,QUADGLITCH);
+    hal->setAlert(GPIO_CLK,updateEncoders);
+    hal->setAlert(GPIO_DT,updateEncoders);
 
     (TRACE>=0x02 ? fprintf(stderr,"%s:setupGPIO() MIC PTT\n",PROGRAMID) : _NOP);
 
-    gpioSetMode(GPIO_MICPTT, PI_INPUT);
-    gpioSetPullUpDown(GPIO_MICPTT,PI_PUD_UP);
+    hal->setMode(GPIO_MICPTT, HAL_INPUT);
+    hal->setPull(GPIO_MICPTT,HAL_PUD_UP);
     usleep(100000);
-    gpioSetISRFunc(GPIO_MICPTT, EITHER_EDGE,0,updateMICPTT);
+    hal->setISR(GPIO_MICPTT,HAL_EITHER,updateMICPTT);
 
-    (TRACE>=0x02 ? fprintf(stderr,"%s:setupGPIO() SQL\n",PROGRAMID) : _NOP);
+//*---- Configure the lines of every DRA818V module wired to the GPIO
 
-    gpioSetMode(GPIO_SQL, PI_INPUT);
-    gpioSetPullUpDown(GPIO_SQL,PI_PUD_UP);
-    usleep(100000);
-    gpioSetISRFunc(GPIO_SQL, EITHER_EDGE,0,updateSQL);
+    for (int i=0;i<nrig;i++) {
 
-    (TRACE>=0x02 ? fprintf(stderr,"%s:setupGPIO() PTT\n",PROGRAMID) : _NOP);
+      if (rig[i].sql>=0) {
+        (TRACE>=0x02 ? fprintf(stderr,"%s:setupGPIO() rig(%d) SQL\n",PROGRAMID,i) : _NOP);
 
-    gpioSetMode(GPIO_PTT, PI_OUTPUT);
-    gpioSetPullUpDown(GPIO_PTT,PI_PUD_UP);
-    usleep(100000);
-    gpioWrite(GPIO_PTT,1);
+         hal->setMode(rig[i].sql, HAL_INPUT);
+         hal->setPull(rig[i].sql,HAL_PUD_UP);
+         usleep(100000);
+         hal->setISR(rig[i].sql,HAL_EITHER,updateSQL);
+      }
 
-    (TRACE>=0x02 ? fprintf(stderr,"%s:setupGPIO() PD\n",PROGRAMID) : _NOP);
+      if (rig[i].ptt>=0) {
+        (TRACE>=0x02 ? fprintf(stderr,"%s:setupGPIO() rig(%d) PTT\n",PROGRAMID,i) : _NOP);
 
-    gpioSetMode(GPIO_PD, PI_OUTPUT);
-    gpioSetPullUpDown(GPIO_PD,PI_PUD_UP);
-    usleep(100000);
-    gpioWrite(GPIO_PD,1);
+         hal->setMode(rig[i].ptt, HAL_OUTPUT);
+         hal->setPull(rig[i].ptt,HAL_PUD_UP);
+         usleep(100000);
+         hal->write(rig[i].ptt,1);
+      }
 
-    (TRACE>=0x02 ? fprintf(stderr,"%s:setupGPIO() HL\n",PROGRAMID) : _NOP);
+      if (rig[i].pd>=0) {
+        (TRACE>=0x02 ? fprintf(stderr,"%s:setupGPIO() rig(%d) PD\n",PROGRAMID,i) : _NOP);
 
-    gpioSetMode(GPIO_HL, PI_OUTPUT);
-    gpioSetPullUpDown(GPIO_PD,PI_PUD_UP);
-    usleep(100000);
-    gpioWrite(GPIO_HL,0);
+         hal->setMode(rig[i].pd, HAL_OUTPUT);
+         hal->setPull(rig[i].pd,HAL_PUD_UP);
+         usleep(100000);
+         hal->write(rig[i].pd,1);
+      }
+
+      if (rig[i].hl>=0) {
+        (TRACE>=0x02 ? fprintf(stderr,"%s:setupGPIO() rig(%d) HL\n",PROGRAMID,i) : _NOP);
+
+         hal->setMode(rig[i].hl, HAL_OUTPUT);
+         hal->setPull(rig[i].pd,HAL_PUD_UP);
+         usleep(100000);
+         hal->write(rig[i].hl,0);
+      }
+    }
+
+//*---- PA enable, keyed by the TX sequencer ahead of the PTT
+
+    (TRACE>=0x02 ? fprintf(stderr,"%s:setupGPIO() PA enable\n",PROGRAMID) : _NOP);
+    hal->setMode(GPIO_PA, HAL_OUTPUT);
+    hal->write(GPIO_PA,0);
 
     (TRACE>=0x02 ? fprintf(stderr,"%s:setupGPIO() Setup GPIO signal Handler\n",PROGRAMID) : _NOP);
     for (int i=0;i<64;i++) {
 
-        gpioSetSignalFunc(i,sighandler);
+        hal->setSignal(i,sighandler);
 
     }
     (TRACE>=0x03 ? fprintf(stderr,"%s:setupGPIO() End of setup for GPIO Handler\n",PROGRAMID) : _NOP);
@@ -255,26 +276,91 @@ void setupGPIO() {
 void DRAchangePTT() {
 
     (TRACE>=0x02 ? fprintf(stderr,"%s:DRAchangePTT() Process PTT change request PTT(%s)\n",PROGRAMID,BOOL2CHAR(d->getPTT())) : _NOP);
-    (d->getPTT()==false ? gpioWrite(GPIO_PTT,1) : gpioWrite(GPIO_PTT,0));
+    if (rig[0].ptt<0) {return;}
+    if (txseq!=nullptr) {
+       txseq->key(d->getPTT(),0);
+       return;
+    }
+    (d->getPTT()==false ? hal->write(rig[0].ptt,1) : hal->write(rig[0].ptt,0));
 
 }
 void DRAchangeHL() {
 
     (TRACE>=0x02 ? fprintf(stderr,"%s:DRAchangeHL() Process HL change request HL(%s)\n",PROGRAMID,BOOL2CHAR(d->getHL())) : _NOP);
-    (d->getHL()==false ? gpioWrite(GPIO_HL,0) : gpioWrite(GPIO_HL,1));
+    if (rig[0].hl<0) {return;}
+    (d->getHL()==false ? hal->write(rig[0].hl,0) : hal->write(rig[0].hl,1));
 
 }
 void DRAchangePD() {
 
     (TRACE>=0x02 ? fprintf(stderr,"%s:DRAchangeHL() Process PD change request HL(%s)\n",PROGRAMID,BOOL2CHAR(d->getPD())) : _NOP);
-    (d->getPD()==false ? gpioWrite(GPIO_PD,0) : gpioWrite(GPIO_PD,1));
+    if (rig[0].pd<0) {return;}
+    (d->getPD()==false ? hal->write(rig[0].pd,0) : hal->write(rig[0].pd,1));
 
 }
 void showMeter();
+void showDRA818V();
+void DRAchangeRUN() {
+
+    (TRACE>=0x01 ? fprintf(stderr,"%s:DRAchangeRUN() DRA818V RUN(%s) firmware(%s)\n",PROGRAMID,BOOL2CHAR(getWord(d->MSW,RUN)),d->version) : _NOP);
+    showDRA818V();
+
+}
+void showFrequency();
+void showVFOMEM();
+void showScope(bool all);
+void showHistory(bool all);
+void showPanel();
+//*--------------------------------------------------------------------------------------------------
+//* DRAchangeWATCH  the priority watch started, stopped, holds the priority channel or left it
+//*--------------------------------------------------------------------------------------------------
+void DRAchangeWATCH() {
+
+    (TRACE>=0x02 ? fprintf(stderr,"%s:DRAchangeWATCH() watch state(%d) priority f(%ld)\n",PROGRAMID,d->watch.load(),d->getRFW(d->prio)) : _NOP);
+    if (getWord(MSW,CMD)==true) {return;}
+    showFrequency();
+    showVFOMEM();
+}
+//*--------------------------------------------------------------------------------------------------
+//* DRAchangeSCAN  the scanner stopped, resumed or measured its rate; once it is off the VFO takes
+//* the channel it was left at, the band scope draws the bins measured since the last event
+//*--------------------------------------------------------------------------------------------------
+void DRAchangeSCAN() {
+
+    (TRACE>=0x02 ? fprintf(stderr,"%s:DRAchangeSCAN() scan state(%d) f(%ld) rate(%.1f ch/s)\n",PROGRAMID,d->scan.load(),d->scanFreq(),d->scanrate) : _NOP);
+    if (d->scan==DRA_SCAN_OFF && vfo!=nullptr) {
+       f=d->getRFW();
+       vfo->set(vfo->vfo,(float)f);
+    }
+    if (scopeon==true) {
+       if (d->scan!=DRA_SCAN_OFF) {
+          if (getWord(MSW,CMD)==false) {showScope(false);}
+          return;
+       }
+       scopeon=false;
+       if (getWord(MSW,CMD)==false) {showPanel();}
+       return;
+    }
+    if (getWord(MSW,CMD)==true) {return;}
+    showFrequency();
+    showVFOMEM();
+}
+//*--------------------------------------------------------------------------------------------------
+//* DRAsampleRSSI  RSSI reading of a module other than the front panel one, only for the squelch log
+//*--------------------------------------------------------------------------------------------------
+void DRAsampleRSSI(int id,float rssi) {
+
+    if (sqlog!=nullptr) {sqlog->sample(id,(int)rssi);}
+}
 void DRAchangeRSSI(float rssi) {
 
     (TRACE>=0x03 ? fprintf(stderr,"%s:DRAchangeRSSI() Signal report RSSI(%f)\n",PROGRAMID,rssi) : _NOP);
     RSSI=rssi;
+    if (sqlog!=nullptr) {sqlog->sample(0,(int)rssi);}
+    if (rssistore!=nullptr) {
+       rssistore->add((int)rssi);
+       if (histon!=0 && rssistore->count(histon)!=histn && getWord(MSW,CMD)==false) {showHistory(false);}
+    }
     if (RSSI!=RSSIant) {
        showMeter();
        RSSIant=RSSI;
@@ -286,37 +372,62 @@ void DRAchangeRSSI(float rssi) {
 //*--------------------------------------------------------------------------------------------------
 void setupDRA818V() {
 
-//*---- setup  DRA818V
+//*---- setup every DRA818V module, all serviced by the same I/O thread, rig 0 is the front panel one
+
+    for (int i=0;i<nrig;i++) {
 
-    d=new DRA818V(DRAchangePTT,DRAchangePD,DRAchangeHL,DRAchangeRSSI);
-    d->start();
+      DRA818V* r=(i==0 ? new DRA818V(DRAchangePTT,DRAchangePD,DRAchangeHL,DRAchangeRSSI) : new DRA818V(NULL,NULL,NULL,NULL));
+      rig[i].d=r;
+      r->id=i;
+      if (i!=0) {r->changeRSSIid=DRAsampleRSSI;}
+      if (i==0) {
+         d=r;
+         d->changeRUN=DRAchangeRUN;
+         d->changeSCAN=DRAchangeSCAN;
+         d->changeWATCH=DRAchangeWATCH;
+      }
+      r->notify=rigwake;
+      r->start(rig[i].port);
+      if (io!=nullptr) {
+         r->attach(io);
+      }
 
-    d->setRFW(f/1000000.0);
-    d->setTFW(d->getRFW()+(ofs/1000000));
-    d->setVol(vol);
-    d->setGBW(0);
-    d->setPEF(0);
-    d->setHPF(0);
-    d->setLPF(0);
-    d->setSQL(sql);
-    d->setPD(bPD);
-    d->setHL(bHL);
-   
+      r->setRFW(f);
+      r->setTFW(f+ofs);
+      r->setVol(vol);
+      r->setGBW(0);
+      r->setPEF(0);
+      r->setHPF(0);
+      r->setLPF(0);
+      r->setSQL(sql);
+      r->setPD(bPD);
+      r->setHL(bHL);
 
-    d->setTxCTCSS(d->TonetoCTCSS(tx_ctcss));
-    d->setRxCTCSS(d->TonetoCTCSS(rx_ctcss));
 
-    d->sendSetGroup();
-    d->sendSetVolume();
-    d->sendSetFilter();
+      r->setTxCTCSS(r->TonetoCTCSS(tx_ctcss));
+      r->setRxCTCSS(r->TonetoCTCSS(rx_ctcss));
 
-    d->setPTT(false);
+      r->sendSetGroup();
+      r->sendSetVolume();
+      r->sendSetFilter();
 
-    setWord(&d->dra[m].STATUS,PD,bPD);
-    setWord(&d->dra[m].STATUS,PEF,bPFE);
-    setWord(&d->dra[m].STATUS,HPF,bHPF);
-    setWord(&d->dra[m].STATUS,LPF,bLPF);
-    setWord(&d->dra[m].STATUS,HL,bHL);
+      r->setPTT(false);
+
+      setWord(&r->RSW,PD,bPD);
+      setWord(&r->dra[m].STATUS,PEF,bPFE);
+      setWord(&r->dra[m].STATUS,HPF,bHPF);
+      setWord(&r->dra[m].STATUS,LPF,bLPF);
+      setWord(&r->RSW,HL,bHL);
+    }
+
+//*---- the priority channel keeps the settings of the VFO, the watch starts with the program
+
+    if (prio!=0) {
+       d->store(PRIOSLOT);
+       d->setRFW(PRIOSLOT,prio);
+       d->setTFW(PRIOSLOT,prio+ofs);
+       d->watchStart(PRIOSLOT,DRAPRIO);
+    }
 
     return;
 }
@@ -376,6 +487,7 @@ int row=0;
 int alt=0;
 
      if (getWord(MSW,CMD)==true) {return;}
+     if (scopeon==true || histon!=0) {return;}
      if (vfo==nullptr) {return;}
 
      if (vfo->vfo == VFOA) {
@@ -408,38 +520,38 @@ int alt=0;
 void showFrequency() {
 
      if (vfo==nullptr) {return;}
+     if (scopeon==true || histon!=0) {return;}
 
-     if (vfo->getPTT() == false) {
-        sprintf(LCD_Buffer,"%6.2f",vfo->get(VFOA)/1000000.0);
-        lcd->println(2,0,LCD_Buffer);
+long fA=DRA818V::toHz(vfo->get(VFOA));
+long fB=DRA818V::toHz(vfo->get(VFOB));
 
-        sprintf(LCD_Buffer,"%6.2f",vfo->get(VFOB)/1000000.0);
-        lcd->println(2,1,LCD_Buffer);
-        return;
+     if (d!=nullptr && d->scan!=DRA_SCAN_OFF) {
+        (vfo->vfo==VFOA ? fA=d->scanFreq() : fB=d->scanFreq());
+     }
+     if (d!=nullptr && d->scan==DRA_SCAN_OFF && d->watch==DRA_WATCH_HOLD) {
+        (vfo->vfo==VFOA ? fA=d->getRFW(d->prio) : fB=d->getRFW(d->prio));
      }
 
-     if (vfo->vfo==VFOA) {
-        sprintf(LCD_Buffer,"%6.2f",(vfo->get(VFOA)+vfo->getShift(VFOA))/1000000.0);
-        lcd->println(2,0,LCD_Buffer);
-
-        sprintf(LCD_Buffer,"%6.2f",vfo->get(VFOB)/1000000.0);
-        lcd->println(2,1,LCD_Buffer);
-
-     } else {
-
-        sprintf(LCD_Buffer,"%6.2f",vfo->get(VFOA)/1000000.0);
-        lcd->println(2,0,LCD_Buffer);
+     if (vfo->getPTT() == true) {
+        if (vfo->vfo==VFOA) {
+           fA+=DRA818V::toHz(vfo->getShift(VFOA));
+        } else {
+           fB+=DRA818V::toHz(vfo->getShift(VFOB));
+        }
+     }
 
-        sprintf(LCD_Buffer,"%6.2f",(vfo->get(VFOB)+vfo->getShift(VFOB))/1000000.0);
-        lcd->println(2,1,LCD_Buffer);
+     *DRA818V::putMHz(LCD_Buffer,fA,2)=0x00;
+     lcd->println(2,0,LCD_Buffer);
 
-     }
+     *DRA818V::putMHz(LCD_Buffer,fB,2)=0x00;
+     lcd->println(2,1,LCD_Buffer);
 }
 
 //*==================================================================================================
 void showDRA818V() {
 
    if (d==nullptr) {return;}
+   if (scopeon==true || histon!=0) {return;}
    if (getWord(d->MSW,RUN)==true) {
        lcd->setCursor(8,0);
        lcd->write(byte(5));
@@ -462,9 +574,34 @@ void showPTT() {
    lcd->write(0);
 }
 //*==================================================================================================
+//* setPollRSSI  fast RSSI polling while the squelch is open, moderate while the meter is on sight
+//* and slow otherwise (menu on screen), the DRA818V engine never polls while in TX. The backlight is
+//* not looked at, setBacklight() is disabled and its timer is never armed
+//* modules other than the front panel one are polled fast only while their squelch is open
+//*==================================================================================================
+void setPollRSSI() {
+
+     for (int i=1;i<nrig;i++) {
+         if (rig[i].d!=nullptr) {rig[i].d->setPoll(rig[i].d->getSQ()==true ? DRAPOLLFAST : DRAPOLLSLOW);}
+     }
+
+     if (d==nullptr) {return;}
+
+     if (d->getSQ()==true) {
+        d->setPoll(DRAPOLLFAST);
+        return;
+     }
+     if (getWord(MSW,CMD)==false) {
+        d->setPoll(DRAPOLLMETER);
+        return;
+     }
+     d->setPoll(DRAPOLLSLOW);
+}
+//*==================================================================================================
 void showMeter() {
 
      if (getWord(MSW,CMD)==true) {return;}
+     if (scopeon==true || histon!=0) {return;}
 
      if (vfo==nullptr) {
         (TRACE>=0x02 ? fprintf(stderr,"%s:showMeter() vfo pointer is NULL, request ignored\n",PROGRAMID) : _NOP);
@@ -517,7 +654,6 @@ int  n=0;
        case 14: {lcd->write(byte(255));lcd->write(byte(255));lcd->write(byte(4));break;}
        case 15: {lcd->write(byte(255));lcd->write(byte(255));lcd->write(byte(255));break;}
      }
-     usleep(10000);
      return;
 }
 //*==================================================================================================
@@ -577,19 +713,104 @@ void showPD() {
 //*==================================================================================================
 void showVFOMEM() {
 
-//*--- Mockup
+    if (scopeon==true || histon!=0) {return;}
+
+//*--- Mockup, while scanning the channels per second (or HLD when stopped on a signal), PRI while
+//*--- held on the priority channel and DW while watching it
 
-    strcpy(LCD_Buffer,"VFO");
+    if (d!=nullptr && d->scan!=DRA_SCAN_OFF) {
+       if (d->scan==DRA_SCAN_HOLD || d->scan==DRA_SCAN_HANG) {
+          strcpy(LCD_Buffer,"HLD");
+       } else {
+          sprintf(LCD_Buffer,"S%02d",(d->scanrate>99.0 ? 99 : (int)d->scanrate));
+       }
+    } else {
+       if (d!=nullptr && d->watch!=DRA_WATCH_OFF) {
+          strcpy(LCD_Buffer,(d->watch==DRA_WATCH_HOLD ? "PRI" : "DW "));
+       } else {
+          strcpy(LCD_Buffer,"VFO");
+       }
+    }
     lcd->println(10,1,LCD_Buffer);
 
 }
 //*==================================================================================================
+//* showScope  band scope, one column per bin with the bar rising over both rows in the same steps
+//* as the meter (the S1..S4 glyphs then a full block per row); only the columns whose height
+//* changed are written unless all is asked
+//*==================================================================================================
+void showScopeCell(int n) {
+
+    if (n<=0) {lcd->print(" "); return;}
+    if (n>=5) {lcd->write(byte(255)); return;}
+    lcd->write(byte(n));
+}
+void showScope(bool all) {
+
+    if (d==nullptr || lcd==nullptr) {return;}
+
+    for (int i=0;i<DRASCOPEBINS;i++) {
+        int r=d->scope[i];
+        int n=(r<55 ? 0 : (r-55)/8+1);
+        if (n>10) {n=10;}
+        if (all==false && n==scopeant[i]) {continue;}
+        scopeant[i]=n;
+        lcd->setCursor(i,1);
+        showScopeCell(n);
+        lcd->setCursor(i,0);
+        showScopeCell(n-5);
+    }
+}
+//*==================================================================================================
+//* showHistory  RSSI history of the tier picked in the menu, the newest closed bucket on the right
+//* and one column per bucket before it, drawn as the band scope with the highest reading of each;
+//* buckets without readings (no polling meanwhile) are left blank
+//*==================================================================================================
+void showHistory(bool all) {
+
+    if (rssistore==nullptr || lcd==nullptr || histon==0) {return;}
+
+RSSI_point p[HISTCOLS];
+int  n=rssistore->read(histon,p,HISTCOLS);
+uint64_t span=rssistore->span[histon];
+uint64_t t=RSSIstore::now();
+uint64_t newest=t-t%span-span;
+int  h[HISTCOLS];
+
+    histn=rssistore->count(histon);
+    memset(h,0,sizeof(h));
+    for (int i=0;i<n;i++) {
+        if (p[i].t>newest) {continue;}
+        uint64_t age=(newest-p[i].t)/span;
+        if (age>=HISTCOLS) {continue;}
+        int r=p[i].max;
+        h[HISTCOLS-1-age]=(r<55 ? 0 : (r-55)/8+1);
+    }
+    for (int i=0;i<HISTCOLS;i++) {
+        if (h[i]>10) {h[i]=10;}
+        if (all==false && h[i]==histant[i]) {continue;}
+        histant[i]=h[i];
+        lcd->setCursor(i,1);
+        showScopeCell(h[i]);
+        lcd->setCursor(i,0);
+        showScopeCell(h[i]-5);
+    }
+}
+//*==================================================================================================
 //* Show the entire VFO panel at once
 //*==================================================================================================
 void showPanel() {
     if (lcd==nullptr) {return;}
 
     lcd->clear();
+    if (scopeon==true) {
+       showScope(true);
+       return;
+    }
+    if (histon!=0) {
+       showHistory(true);
+       return;
+    }
 
     showVFO();
     showFrequency();
@@ -609,16 +830,17 @@ void showPanel() {
 //*--------------------------------------------------------------------------------------------------
 //* Handlers for DRA818 Frequency events
 //*--------------------------------------------------------------------------------------------------
-void changeFrequency(float f) {
+void changeFrequency(float fVFO) {
 
     showFrequency();
     showChange();
-    TVFO=3000;
+    setTimer(UI_VFO,3000);
     setWord(&GSW,FBLINK,true);
 
     if (d==nullptr) {return;}
-    d->setRFW(vfo->get()/1000000.0);
-    d->setTFW(d->getRFW()+(vfo->getShift()/1000000));
+long rx=DRA818V::toHz(vfo->get());
+    d->setRFW(rx);
+    d->setTFW(rx+DRA818V::toHz(vfo->getShift()));
     d->sendSetGroup();
 
 }
@@ -654,8 +876,9 @@ void changeVfoHandler(byte S) {
       (TRACE>=0x02 ? fprintf(stderr,"%s:changeVfoHandler() change VFO S(%s) On\n",PROGRAMID,BOOL2CHAR(getWord(vfo->FT817,VFO))) : _NOP);
 
       if (d==nullptr) {return;}
-      d->setRFW(vfo->get()/1000000.0);
-      d->setTFW(d->getRFW()+(vfo->getShift()/1000000));
+long rx=DRA818V::toHz(vfo->get());
+      d->setRFW(rx);
+      d->setTFW(rx+DRA818V::toHz(vfo->getShift()));
       d->sendSetGroup();
 
       showVFO();
@@ -713,20 +936,104 @@ void restoreMenu() {
 }
 
 //*--------------------------------------------------------------------------------------------------
-//* processGUI() handles the update of the main panel, the menu panel or the item panel
+//* tuneVFO  integer Hz of the VFO after a step; genVFO keeps a float, which only resolves 16 Hz at
+//* 147 MHz, so when it wanders off the DRARASTER grid it is set back before the error builds up
+//*--------------------------------------------------------------------------------------------------
+long tuneVFO(float v) {
+
+long hz=DRA818V::toHz(v);
+     if (v!=(float)hz) {
+        vfo->set(vfo->vfo,(float)hz);
+     }
+     return hz;
+}
+//*--------------------------------------------------------------------------------------------------
+//* stepVFO  one detent up or down, the step scaled by the knob acceleration for just that detent
+//*--------------------------------------------------------------------------------------------------
+float stepVFO(int dir) {
+
+     if (encmult>1) {vfo->setVFOStep(vfo->vfo,vfostep*encmult);}
+float v=(dir>0 ? vfo->up() : vfo->down());
+     if (encmult>1) {vfo->setVFOStep(vfo->vfo,vfostep);}
+     (TRACE>=0x03 ? fprintf(stderr,"%s:stepVFO() dir(%d) x%d speed(%.1f detents/s)\n",PROGRAMID,dir,encmult,(accel!=nullptr ? accel->speed : 0.0)) : _NOP);
+     return v;
+}
+//*--------------------------------------------------------------------------------------------------
+//* applyInput  turn a queued event into the GSW flag (and level) the panel handlers work with
+//*--------------------------------------------------------------------------------------------------
+void applyInput(InputEvent* e) {
+
+     switch(e->kind) {
+       case INP_ENC : {setWord(&GSW,(e->v>0 ? ECW : ECCW),true); encmult=(accel!=nullptr ? accel->step(e->tick,e->v) : 1); break;}
+       case INP_SW  : {setWord(&GSW,(e->v!=0 ? FSWL : FSW),true); break;}
+       case INP_PTT : {pushPTT=(e->v!=0 ? 0 : 1); setWord(&GSW,FPTT,true); break;}
+       case INP_SQL : {pushSQL=(e->v!=0 ? 0 : 1); if (d!=nullptr) {d->setSQ(e->v!=0);} setWord(&GSW,FSQ,true); break;}
+     }
+}
+void processPanel();
+//*--------------------------------------------------------------------------------------------------
+//* processGUI() drains every input event queued since the last pass and handles them one at a
+//* time in the order they happened, so no detent or push is lost however fast they come
 //*--------------------------------------------------------------------------------------------------
 void processGUI() {
 
+InputEvent e[INPBATCH];
+int n=inq->drain(e,INPBATCH);
+
+     if (n>1) {(TRACE>=0x03 ? fprintf(stderr,"%s:processGUI() %d input events queued\n",PROGRAMID,n) : _NOP);}
+     for (int i=0;i<n;i++) {
+         applyInput(&e[i]);
+         processPanel();
+     }
+     if (n==0) {processPanel();}
+}
+//*--------------------------------------------------------------------------------------------------
+//* processPanel() handles the update of the main panel, the menu panel or the item panel
+//*--------------------------------------------------------------------------------------------------
+void processPanel() {
+
 //*-------------- Process main display Panel (CMD=false GUI=*)
 
       if (getWord(MSW,CMD)==false) {
 
+        if (histon!=0) {                              // the knob or a push leave the RSSI history
+           if (getWord(GSW,ECW)==true || getWord(GSW,ECCW)==true || getWord(GSW,FSW)==true) {
+              setWord(&GSW,ECW,false);
+              setWord(&GSW,ECCW,false);
+              setWord(&GSW,FSW,false);
+              histon=0;
+              mnu_History->setChild(0);
+              showPanel();
+           }
+        }
+
+        if (d!=nullptr && d->scan!=DRA_SCAN_OFF) {   // while scanning the knob stops it and the push
+           if (getWord(GSW,ECW)==true || getWord(GSW,ECCW)==true) {   // locks the channel out
+              setWord(&GSW,ECW,false);
+              setWord(&GSW,ECCW,false);
+              d->stopScan();
+           }
+           if (getWord(GSW,FSW)==true) {
+              setWord(&GSW,FSW,false);
+              (scopeon==true ? d->stopScan() : d->skipScan(true));
+           }
+        }
+
+        if (d!=nullptr && d->watch==DRA_WATCH_HOLD) {   // held on the priority channel the knob or the
+           if (getWord(GSW,ECW)==true || getWord(GSW,ECCW)==true || getWord(GSW,FSW)==true) {   // push goes back
+              setWord(&GSW,ECW,false);
+              setWord(&GSW,ECCW,false);
+              setWord(&GSW,FSW,false);
+              d->skipWatch();
+           }
+        }
+
         if (getWord(GSW,ECW)==true) {  //increase f
            setWord(&GSW,ECW,false);
            setWord(&GSW,ECCW,false);
            if (vfo->getPTT()==false) { 
-              f=vfo->up();
-              TVFO=3000;
+              f=tuneVFO(stepVFO(+1));
+              setTimer(UI_VFO,3000);
               setWord(&GSW,FBLINK,true);
            }
         }
@@ -736,8 +1043,8 @@ void processGUI() {
            setWord(&GSW,ECCW,false);
            setWord(&GSW,ECW,false);
            if (vfo->getPTT()==false) { 
-              f=vfo->down();
-              TVFO=3000;
+              f=tuneVFO(stepVFO(-1));
+              setTimer(UI_VFO,3000);
               setWord(&GSW,FBLINK,true);
            }
         }
@@ -766,7 +1073,7 @@ void processGUI() {
 
         if (getWord(GSW,FSQ)==true) {
             setWord(&GSW,FSQ,false);
-           (TRACE>=0x02 ? fprintf(stderr,"%s:processGUI() SQL activation SQL(%s)\n",PROGRAMID,BOOL2CHAR(getWord(d->dra[m].STATUS,SQ))) : _NOP);
+           (TRACE>=0x02 ? fprintf(stderr,"%s:processGUI() SQL activation SQL(%s)\n",PROGRAMID,BOOL2CHAR(d->getSQ())) : _NOP);
             showMeter();
         }
 
@@ -959,7 +1266,7 @@ void procUpdateOfs(MMS* p) {
 		 }
      }
      if (d==nullptr) {return;}
-     d->setTFW(d->getRFW()+(vfo->getShift()/1000000));
+     d->setTFW(d->getRFW()+DRA818V::toHz(vfo->getShift()));
      d->sendSetGroup();
      (TRACE>=0x02 ? fprintf(stderr,"%s:procUpdateTxCTCSS() Offseet is now(%d)\n",PROGRAMID,p->mVal) : _NOP);
 }
@@ -1064,16 +1371,16 @@ void procUpdateStep(MMS* p) {
      if (vfo==nullptr) {return;}
      switch(p->mVal) {
 	case 0 : {
-		  vfo->setVFOStep(VFOA,VFO_STEP_10KHz);
-		  vfo->setVFOStep(VFOB,VFO_STEP_10KHz);
+		  vfostep=VFO_STEP_10KHz;
  		  break;
 		 }
 	case 1 : {
-		  vfo->setVFOStep(VFOA,VFO_STEP_5KHz);
-		  vfo->setVFOStep(VFOB,VFO_STEP_5KHz);
+		  vfostep=VFO_STEP_5KHz;
  		  break;
 		 }
      }
+     vfo->setVFOStep(VFOA,vfostep);
+     vfo->setVFOStep(VFOB,vfostep);
      if (d==nullptr) {return;}
      (TRACE>=0x02 ? fprintf(stderr,"%s:procUpdateStep() Step is now(%d)\n",PROGRAMID,p->mVal) : _NOP);
 
@@ -1091,6 +1398,84 @@ void procUpdateWatchdog(MMS* p) {
      (TRACE>=0x02 ? fprintf(stderr,"%s:procUpdateWatchdog() Watchdog is now(%d)\n",PROGRAMID,p->mVal) : _NOP);
 
 
+}
+void procUpdateScan(MMS* p) {
+
+     (TRACE>=0x03 ? fprintf(stderr,"%s:procUpdateScan() \n",PROGRAMID) : _NOP);
+     if (p->mVal < 0) {
+        p->mVal=0;
+     }
+     if (p->mVal > 3) {
+        p->mVal=3;
+     }
+     if (d==nullptr) {return;}
+     scopeon=false;
+     switch(p->mVal) {
+	case 0 : {
+		  d->stopScan();
+ 		  break;
+		 }
+	case 1 : {
+		  d->scanRange(SCANLO,SCANHI,vfostep);
+ 		  break;
+		 }
+	case 2 : {
+		  d->scanMemory();
+ 		  break;
+		 }
+	case 3 : {
+		  scopeon=(d->scopeStart(vfostep)==0);
+ 		  break;
+		 }
+     }
+     (TRACE>=0x02 ? fprintf(stderr,"%s:procUpdateScan() Scan is now(%d)\n",PROGRAMID,p->mVal) : _NOP);
+
+}
+void procUpdateWatch(MMS* p) {
+
+     (TRACE>=0x03 ? fprintf(stderr,"%s:procUpdateWatch() \n",PROGRAMID) : _NOP);
+     if (p->mVal < 0) {
+        p->mVal=0;
+     }
+     if (p->mVal > 1) {
+        p->mVal=1;
+     }
+     if (d==nullptr) {return;}
+     if (p->mVal==0) {
+        d->watchStop();
+     } else {
+        if (d->watchStart(PRIOSLOT,DRAPRIO)<0) {p->mVal=0;}
+     }
+     (TRACE>=0x02 ? fprintf(stderr,"%s:procUpdateWatch() Watch is now(%d)\n",PROGRAMID,p->mVal) : _NOP);
+
+}
+void procUpdateHistory(MMS* p) {
+
+     (TRACE>=0x03 ? fprintf(stderr,"%s:procUpdateHistory() \n",PROGRAMID) : _NOP);
+     if (p->mVal < 0) {
+        p->mVal=0;
+     }
+     if (p->mVal > RSSI_HOUR) {
+        p->mVal=RSSI_HOUR;
+     }
+     if (rssistore==nullptr) {p->mVal=0;}
+     histon=p->mVal;
+     (TRACE>=0x02 ? fprintf(stderr,"%s:procUpdateHistory() History is now(%s)\n",PROGRAMID,(histon==0 ? "off" : RSSIstore::name(histon))) : _NOP);
+
+}
+void procUpdateAccel(MMS* p) {
+
+     (TRACE>=0x03 ? fprintf(stderr,"%s:procUpdateAccel() \n",PROGRAMID) : _NOP);
+     if (p->mVal < 0) {
+        p->mVal=0;
+     }
+     if (p->mVal > 1) {
+        p->mVal=1;
+     }
+     if (accel==nullptr) {return;}
+     (p->mVal==0 ? accel->setCurve(0,0) : accel->setCurve(accel10,accel100));
+     (TRACE>=0x02 ? fprintf(stderr,"%s:procUpdateAccel() Accel is now(%d) 10x(%d) 100x(%d)\n",PROGRAMID,p->mVal,accel->v10,accel->v100) : _NOP);
+
 }
 //*------- Procedure to manage content of the display
 void procChangeVol(MMS* p) {
@@ -1185,6 +1570,10 @@ void setupMMS() {
      mnu_Backlight = new MMS(12,(char*)"Backlight",NULL,procUpdateBacklight);
      mnu_Step=  new MMS(13,(char*)"Step",NULL,procUpdateStep);
      mnu_Watchdog = new MMS(14,(char*)"Watchdog",NULL,procUpdateWatchdog);
+     mnu_Scan = new MMS(15,(char*)"Scan",NULL,procUpdateScan);
+     mnu_Watch = new MMS(16,(char*)"Watch",NULL,procUpdateWatch);
+     mnu_History = new MMS(17,(char*)"History",NULL,procUpdateHistory);
+     mnu_Accel = new MMS(18,(char*)"Accel",NULL,procUpdateAccel);
 
      root->add(mnu_BW);
      root->add(mnu_Vol);
@@ -1201,6 +1590,10 @@ void setupMMS() {
      root->add(mnu_Backlight);
      root->add(mnu_Step);
      root->add(mnu_Watchdog);
+     root->add(mnu_Scan);
+     root->add(mnu_Watch);
+     root->add(mnu_History);
+     root->add(mnu_Accel);
 
 //*--- 
 
@@ -1291,11 +1684,45 @@ void setupMMS() {
      mnu_Step->add(mnu_Step_10KHZ);
      mnu_Step->add(mnu_Step_5KHZ);
 
+     mnu_Scan_Off  = new MMS(0,(char*)"Off",NULL,NULL);
+     mnu_Scan_Band = new MMS(1,(char*)"Band",NULL,NULL);
+     mnu_Scan_Mem  = new MMS(2,(char*)"Memory",NULL,NULL);
+     mnu_Scan_Scope= new MMS(3,(char*)"Scope",NULL,NULL);
+
+     mnu_Scan->add(mnu_Scan_Off);
+     mnu_Scan->add(mnu_Scan_Band);
+     mnu_Scan->add(mnu_Scan_Mem);
+     mnu_Scan->add(mnu_Scan_Scope);
+
+     mnu_Watch_Off = new MMS(0,(char*)"Off",NULL,NULL);
+     mnu_Watch_On  = new MMS(1,(char*)"On",NULL,NULL);
+
+     mnu_Watch->add(mnu_Watch_Off);
+     mnu_Watch->add(mnu_Watch_On);
+
+     mnu_History_Off = new MMS(0,(char*)"Off",NULL,NULL);
+     mnu_History_Sec = new MMS(1,(char*)"1 sec",NULL,NULL);
+     mnu_History_Min = new MMS(2,(char*)"1 min",NULL,NULL);
+     mnu_History_Hour= new MMS(3,(char*)"1 hour",NULL,NULL);
+
+     mnu_History->add(mnu_History_Off);
+     mnu_History->add(mnu_History_Sec);
+     mnu_History->add(mnu_History_Min);
+     mnu_History->add(mnu_History_Hour);
+
+     mnu_Accel_Off = new MMS(0,(char*)"Off",NULL,NULL);
+     mnu_Accel_On  = new MMS(1,(char*)"On",NULL,NULL);
+
+     mnu_Accel->add(mnu_Accel_Off);
+     mnu_Accel->add(mnu_Accel_On);
+
 
      (getWord(d->dra[m].STATUS,PEF)==false ? mnu_PFE->setChild(0) : mnu_PFE->setChild(1));
      (getWord(d->dra[m].STATUS,HPF)==false ? mnu_HPF->setChild(0) : mnu_HPF->setChild(1));
      (getWord(d->dra[m].STATUS,LPF)==false ? mnu_LPF->setChild(0) : mnu_LPF->setChild(1));
-     (getWord(d->dra[m].STATUS,HL)==false ? mnu_HL->setChild(0) : mnu_HL->setChild(1));
-     (getWord(d->dra[m].STATUS,PD)==false ? mnu_PD->setChild(0) : mnu_PD->setChild(1));
+     (getWord(d->RSW,HL)==false ? mnu_HL->setChild(0) : mnu_HL->setChild(1));
+     (getWord(d->RSW,PD)==false ? mnu_PD->setChild(0) : mnu_PD->setChild(1));
+     (d->watch==DRA_WATCH_OFF ? mnu_Watch->setChild(0) : mnu_Watch->setChild(1));
+     (accel10==0 && accel100==0 ? mnu_Accel->setChild(0) : mnu_Accel->setChild(1));
 
 }
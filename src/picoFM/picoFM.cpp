@@ -29,7 +29,6 @@
 //*---- Generic includes
 
 #include <stdio.h>
-#include <wiringPi.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
@@ -43,27 +42,54 @@
 #include <pthread.h>
 #include <signal.h>
 #include <semaphore.h>
-#include <pigpio.h>
-#include <wiringPiI2C.h>
 #include <unistd.h>
 #include <cstring>
 #include <iostream>
 #include <chrono>
 #include <thread>
 #include <functional>
-#include <wiringSerial.h>
 #include <sstream>
 #include <iomanip>
 #include <assert.h>
 #include <termios.h>
 #include <unistd.h>
+#include <atomic>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
 //*---- Program specific includes
 #include "./picoFM.h"
 #include "../lib/DRA818V.h"
+#include "../lib/SQLog.h"
+#include "../lib/RSSIstore.h"
+#include "../lib/InputQueue.h"
+#include "../lib/Wakeup.h"
+#include "../lib/EncoderAccel.h"
+#include "../lib/Quadrature.h"
+#include "../lib/TXSequencer.h"
+#include "../lib/HAL.h"
+
+//*---- Hardware backend, the board (pigpio or with -DGPIOD libgpiod, and LCDLib) or the simulator
+//*---- (-DSIMULATOR)
+
+#ifndef SIMULATOR
+#include <wiringPi.h>
+#include <pigpio.h>
+#include <wiringPiI2C.h>
+#include <wiringSerial.h>
+#include "/home/pi/PixiePi/src/lib/LCDLib.h"
+#include "../lib/HALlcdlib.h"
+#ifdef GPIOD
+#include "../lib/HALgpiod.h"
+#else
+#include "../lib/HALpigpio.h"
+#endif
+#else
+#include "../lib/HALsim.h"
+#define  LCD_ON        1              // from LCDLib.h, the simulated LCD does not draw the glyphs
+byte TX[8],S1[8],S2[8],S3[8],S4[8],NS[8],NA[8],NB[8];
+#endif
 #include "/home/pi/OrangeThunder/src/lib/CAT817.h"
-#include "/home/pi/OrangeThunder/src/lib/CallBackTimer.h"
 #include "/home/pi/OrangeThunder/src/lib/genVFO.h"
-#include "/home/pi/PixiePi/src/lib/LCDLib.h"
 #include "/home/pi/PixiePi/src/lib/MMS.h"
 
 #include <iostream>
@@ -92,9 +118,51 @@ int       anyargs;
 int       lcd_light;
 char      cmd[256];
 
-DRA818V   *d=nullptr;
-LCDLib    *lcd=nullptr;
+DRA818V   *d=nullptr;              // module operated from the front panel (rig 0)
+EventLoop *io=nullptr;
+EventLoop *ui=nullptr;             // main thread reactor, the GUI sleeps on it until there is work
+Wakeup    *inwake=nullptr;         // rung by the GPIO callbacks with every front panel event
+Wakeup    *rigwake=nullptr;        // rung by the I/O thread with every DRA818V event
+int       uitfd[UITIMERS];         // timerfd of each UI timeout
+std::atomic<uint64_t> uidue[UITIMERS];   // ns (CLOCK_MONOTONIC) each one expires at, 0 if not armed
+int       sigfd=-1;                // signalfd of the signals served by the reactor
+sigset_t  uisig;
+Histogram uilat[UISOURCES];        // us from each source posting its work to the reactor serving it
+const char* UINAME[UISOURCES]={"ui vfo","ui backlight","ui watchdog","ui input","ui rig"};
+HALlcd    *lcd=nullptr;
+HALgpio   *hal=nullptr;            // GPIO lines of the backend built
 genVFO    *vfo=nullptr;
+SQLog     *sqlog=nullptr;           // squelch openings log, none if it could not be opened
+char      sqlfile[128]=SQLOG_FILE;
+RSSIstore *rssistore=nullptr;      // RSSI history of the front panel module
+InputQueue *inq=nullptr;           // front panel events from the GPIO callbacks to the GUI
+EncoderAccel *accel=nullptr;       // knob acceleration of the VFO tuning
+Quadrature *quad=nullptr;          // decoder of the tuning encoder lines
+int       accel10=ACCEL10;         // detents/s where the tuning step goes 10x and 100x, 0 never
+int       accel100=ACCEL100;
+int       encmult=1;               // step multiplier of the detent being handled
+TXSequencer *txseq=nullptr;        // PA and PTT lines, keyed from the mic PTT edge
+int       keyup=TXKEYUP;           // ms from the PA enabled to the PTT keyed
+int       keydown=TXKEYDOWN;       // ms from the PTT released to the PA disabled
+#ifdef SIMULATOR
+SimGPIO   *simgpio=nullptr;        // the same objects as hal and lcd, with the simulator calls
+SimLCD    *simlcd=nullptr;
+char      simscript[128]="";       // edges played at full speed, none runs in real time
+char      simframes[128]="";       // LCD frames and output changes captured, none to discard them
+FILE      *simout=nullptr;
+Histogram simgui;                  // us taken by the reactor serving each pass
+unsigned long simpass=0;
+#define   SIMOPTS  "S:F:"
+#else
+#define   SIMOPTS  ""
+#endif
+#ifdef GPIOD
+GpiodGPIO *gpiod=nullptr;          // the same object as hal
+char      gpiochip[64]=GPIODCHIP;
+#define   GPIODOPTS "g:"
+#else
+#define   GPIODOPTS ""
+#endif
 
 char*     LCD_Buffer;
 char      timestr[32];
@@ -102,8 +170,6 @@ char      timestr[32];
 // *                  GPIO support processing                       *
 // *----------------------------------------------------------------*
 //*--- debouncing logic setup
-auto startEncoder=std::chrono::system_clock::now();
-auto endEncoder=std::chrono::system_clock::now();
 
 auto startPush=std::chrono::system_clock::now();
 auto endPush=std::chrono::system_clock::now();
@@ -117,7 +183,6 @@ auto endSQL=std::chrono::system_clock::now();
 int value=0;
 int lastEncoded=0;
 int counter=0;
-int clkLastState=0; 
 int pushPTT=0;
 int pushSQL=0;
 
@@ -148,6 +213,10 @@ MMS* mnu_PD;
 MMS* mnu_Backlight;
 MMS* mnu_Step;
 MMS* mnu_Watchdog;
+MMS* mnu_Scan;
+MMS* mnu_Watch;
+MMS* mnu_History;
+MMS* mnu_Accel;
 
 MMS* mnu_BW_12KHZ;
 MMS* mnu_BW_25KHZ;
@@ -186,21 +255,35 @@ MMS* mnu_Backlight_On;
 MMS* mnu_Watchdog_Off;
 MMS* mnu_Watchdog_On;
 
+MMS* mnu_Scan_Off;
+MMS* mnu_Scan_Band;
+MMS* mnu_Scan_Mem;
+MMS* mnu_Scan_Scope;
+
+MMS* mnu_Watch_Off;
+MMS* mnu_Watch_On;
+
+MMS* mnu_History_Off;
+MMS* mnu_History_Sec;
+MMS* mnu_History_Min;
+MMS* mnu_History_Hour;
+
+MMS* mnu_Accel_Off;
+MMS* mnu_Accel_On;
+
 
 
 
 int  TBCK=0;
 int  TSAVE=0;
-int  TVFO=0;
-int  TRSSI=0;
-int  TBACKLIGHT=0;
-int  TWATCHDOG=0;
 // *----------------------------------------------------------------*
 // *               Initial setup values                             *
 // *----------------------------------------------------------------*
 byte  m=MFM;
-float f=147120000.0;
-float ofs=600000.0;
+long  f=147120000;                // Hz
+long  ofs=600000;                 // Hz
+long  vfostep=VFO_STEP_10KHz;     // Hz, also the channel spacing of a band scan
+long  prio=0;                     // Hz, priority channel watched (same offset as the VFO), 0 for none
 int   vol=5;
 int   sql=1;
 char  callsign[16];
@@ -218,10 +301,28 @@ bool  bHPF=false;
 int   RSSI=135;
 int   RSSIant=135;
 int   nant=-1;
+bool  scopeon=false;              // band scope on the LCD instead of the panel
+int   scopeant[DRASCOPEBINS];     // bar height shown per scope column, -1 to draw it again
+int   histon=0;                   // RSSI history tier on the LCD instead of the panel, 0 if none
+int   histant[HISTCOLS];          // bar height shown per history column
+uint64_t histn=0;                 // points of the tier when the history was last drawn
 byte  col=0;
 struct sigaction sigact;
-CallBackTimer* masterTimer;
-char portname[32]; 
+
+//*--- DRA818V modules, each with its own serial port and GPIO lines (-1 when not wired)
+
+struct RIG
+{
+        char     port[32];
+        int      ptt;
+        int      pd;
+        int      hl;
+        int      sql;
+        DRA818V* d;
+};
+struct RIG rig[MAXRIG];
+int   nrig=0;
+
 
 //*--------------------------[System Word Handler]---------------------------------------------------
 //* getWord Return status according with the setting of the argument bit onto the SW
@@ -253,8 +354,13 @@ static void sighandler(int signum)
       return;
    }
 
+   if (signum==SIGUSR1) {        // statistics dump, served by the reactor, late ones ignored
+      return;
+   }
+
    (TRACE >= 0x00 ? fprintf(stderr, "\n%s:sighandler() Signal caught(%d), exiting!\n",PROGRAMID,signum) : _NOP);
    setWord(&MSW,RUN,false);
+   if (ui!=nullptr) {ui->stop();}   // only writes its eventfd, the reactor runs on this thread
    if (getWord(MSW,RETRY)==true) {
       (TRACE >= 0x00 ? fprintf(stderr, "\n%s:sighandler() Re-entering SIG(%d), force!\n",PROGRAMID,signum) : _NOP);
       exit(16);
@@ -262,49 +368,258 @@ static void sighandler(int signum)
    setWord(&MSW,RETRY,true);
 
 }
+//*--------------------------------------------------------------------------------------------------
+//* addRig  define a DRA818V module as port[:ptt,pd,hl,sql], the first one defaults to the board GPIO
+//*--------------------------------------------------------------------------------------------------
+int addRig(char* s) {
+
+    if (nrig>=MAXRIG) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s:addRig() no more than %d DRA818V modules supported, %s ignored\n",PROGRAMID,MAXRIG,s) : _NOP);
+       return -1;
+    }
+
+struct RIG* r=&rig[nrig];
+char* p=strchr(s,':');
+    if (p!=NULL) {*p=0x00;}
+    snprintf(r->port,sizeof(r->port),"%s",s);
+    r->d=nullptr;
+    if (nrig==0) {
+       r->ptt=GPIO_PTT;
+       r->pd=GPIO_PD;
+       r->hl=GPIO_HL;
+       r->sql=GPIO_SQL;
+    } else {
+       r->ptt=r->pd=r->hl=r->sql=-1;
+    }
+    if (p!=NULL && sscanf(p+1,"%d,%d,%d,%d",&r->ptt,&r->pd,&r->hl,&r->sql)!=4) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s:addRig() GPIO map of %s must be ptt,pd,hl,sql\n",PROGRAMID,r->port) : _NOP);
+       return -1;
+    }
+    (TRACE>=0x01 ? fprintf(stderr,"%s:addRig() rig(%d) port(%s) GPIO ptt(%d) pd(%d) hl(%d) sql(%d)\n",PROGRAMID,nrig,r->port,r->ptt,r->pd,r->hl,r->sql) : _NOP);
+    return nrig++;
+}
+//*--------------------------------------------------------------------------------------------------
+//* writeStats  statistics of all modules, the file is replaced so readers never see it half written
+//*--------------------------------------------------------------------------------------------------
+void uiStats(FILE* f);
+int writeStats(const char* name) {
+
+char tmp[128];
+    snprintf(tmp,sizeof(tmp),"%s.tmp",name);
+FILE* f=fopen(tmp,"w");
+    if (f==NULL) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s:writeStats() error %d creating %s: %s\n",PROGRAMID,errno,tmp,strerror(errno)) : _NOP);
+       return -1;
+    }
+    for (int i=0;i<nrig;i++) {
+        if (rig[i].d!=nullptr) {rig[i].d->stats(f);}
+    }
+    if (inq!=nullptr) {inq->stats(f);}
+    if (accel!=nullptr) {accel->stats(f);}
+    if (quad!=nullptr) {quad->stats(f);}
+    if (txseq!=nullptr) {txseq->stats(f);}
+#ifdef GPIOD
+    if (gpiod!=nullptr) {gpiod->stats(f);}
+#endif
+    uiStats(f);
+#ifdef SIMULATOR
+    fprintf(f,"sim passes=%lu edges=%lu frames=%lu\n",simpass,simgpio->edges,(simlcd!=nullptr ? simlcd->frames : 0));
+    simgui.print(f,"sim pass");
+#endif
+    fclose(f);
+    return rename(tmp,name);
+}
+//*--------------------------------------------------------------------------------------------------
+//* writeRSSI  export every tier of the RSSI history as CSV, replaced the same way as the statistics
+//*--------------------------------------------------------------------------------------------------
+int writeRSSI(const char* name) {
+
+    if (rssistore==nullptr) {return 0;}
+char tmp[128];
+    snprintf(tmp,sizeof(tmp),"%s.tmp",name);
+FILE* f=fopen(tmp,"w");
+    if (f==NULL) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s:writeRSSI() error %d creating %s: %s\n",PROGRAMID,errno,tmp,strerror(errno)) : _NOP);
+       return -1;
+    }
+    fprintf(f,"tier,time_ms,min,mean,max,n\n");
+    for (int k=0;k<RSSITIERS;k++) {
+        rssistore->write(f,k);
+    }
+    fclose(f);
+    return rename(tmp,name);
+}
+//*--------------------------------------------------------------------------------------------------
+//* setTimer  arm the UI timeout k to expire ms from now, 0 disarms it; callable from any thread
+//*--------------------------------------------------------------------------------------------------
+void setTimer(int k,int ms) {
+
+uint64_t due=(ms==0 ? 0 : Wakeup::now()+(uint64_t)ms*1000000ULL);
+struct itimerspec t;
+    memset(&t,0,sizeof(t));
+    t.it_value.tv_sec=due/1000000000ULL;
+    t.it_value.tv_nsec=due%1000000000ULL;
+    uidue[k]=due;
+    timerfd_settime(uitfd[k],TFD_TIMER_ABSTIME,&t,NULL);
+}
+bool timerOn(int k) {
+    return uidue[k]!=0;
+}
 #include "./GUI.h"
 
-//--------------------------------------------------------------------------------------------------
-// FT8ISR - interrupt service routine, keep track of the FT8 sequence windows
-//--------------------------------------------------------------------------------------------------
-void ISRHandler() {
-
-
-   if (TVFO!=0) {
-       TVFO--;
-       if (TVFO==0) {
-           setWord(&SSW,FVFO,true);
-       }
-   }
-
-   if (TRSSI!=0) {
-       TRSSI--;
-       if (TRSSI==0) {
-          if (d!=nullptr) {
-              d->sendRSSI();
-          }
-          TRSSI=1000;
-       }
-   }
+//*--------------------------------------------------------------------------------------------------
+//* uiServe  tail of every handler of the reactor, the panel reacts to whatever the source changed
+//*--------------------------------------------------------------------------------------------------
+void uiServe() {
+    processGUI();
+    setPollRSSI();          //Adapt the RSSI polling rate to what is on screen
+}
+//*--------------------------------------------------------------------------------------------------
+//* onInput  front panel events queued by the GPIO callbacks
+//*--------------------------------------------------------------------------------------------------
+void onInput(void* ctx,uint32_t events) {
 
+long us=inwake->take();
+    if (us>=0) {uilat[UI_INPUT].record(us);}
+    uiServe();
+}
+//*--------------------------------------------------------------------------------------------------
+//* onRig  DRA818V replies and state changes handed by the I/O thread, of every module
+//*--------------------------------------------------------------------------------------------------
+void onRig(void* ctx,uint32_t events) {
+
+long us=rigwake->take();
+    if (us>=0) {uilat[UI_RIG].record(us);}
+    for (int i=0;i<nrig;i++) {
+        rig[i].d->processCommand();
+    }
+    uiServe();
+}
+//*--------------------------------------------------------------------------------------------------
+//* onTimer  a UI timeout expired, ctx is its number; re-armed since it fired means it is not due
+//*--------------------------------------------------------------------------------------------------
+void onTimer(void* ctx,uint32_t events) {
+
+int k=(int)(intptr_t)ctx;
+uint64_t v;
+    if (read(uitfd[k],&v,sizeof(v))<0) {return;}
+uint64_t now=Wakeup::now();
+uint64_t due=uidue[k];
+    if (due==0 || due>now || uidue[k].compare_exchange_strong(due,0)==false) {return;}
+    uilat[k].record((now-due)/1000);
+
+    switch(k) {
+      case UI_VFO       : {setWord(&SSW,FVFO,true); break;}
+      case UI_BACKLIGHT : {setBacklight(false); break;}
+      case UI_WATCHDOG  : {
+                          if (vfo!=nullptr) {setWord(&vfo->FT817,WATCHDOG,true); vfo->setPTT(false);}
+                          break;
+                          }
+    }
+    uiServe();
+}
+//*--------------------------------------------------------------------------------------------------
+//* onSignal  SIGUSR1 dumps the statistics, the others stop the reactor; a second one while the
+//* program shuts down is taken by sighandler(), the signals are unblocked once the reactor stops
+//*--------------------------------------------------------------------------------------------------
+void onSignal(void* ctx,uint32_t events) {
 
-   if (TBACKLIGHT!=0) {
-       TBACKLIGHT--;
-       if (TBACKLIGHT==0) {
-          setBacklight(false);
-       }
-   }
+struct signalfd_siginfo si;
+    if (read(sigfd,&si,sizeof(si))!=sizeof(si)) {return;}
 
-   if (TWATCHDOG!=0) {
-       TWATCHDOG--;
-       if (TWATCHDOG==0) {
-          if (vfo!=nullptr) {setWord(&vfo->FT817,WATCHDOG,true); vfo->setPTT(false);}
+    if (si.ssi_signo==SIGUSR1) {
+       for (int i=0;i<nrig;i++) {
+           rig[i].d->stats(stderr);
        }
-   }
-
-   return;
+       inq->stats(stderr);
+       accel->stats(stderr);
+       quad->stats(stderr);
+       txseq->stats(stderr);
+#ifdef GPIOD
+       gpiod->stats(stderr);
+#endif
+       uiStats(stderr);
+       writeStats(STATS_FILE);
+       writeRSSI(RSSI_FILE);
+       return;
+    }
+
+   (TRACE >= 0x00 ? fprintf(stderr, "\n%s:onSignal() Signal caught(%d), exiting!\n",PROGRAMID,si.ssi_signo) : _NOP);
+    setWord(&MSW,RUN,false);
+    setWord(&MSW,RETRY,true);
+    ui->stop();
+}
+//*--------------------------------------------------------------------------------------------------
+//* uiStats  wake ups of the reactor and the latency of each source
+//*--------------------------------------------------------------------------------------------------
+void uiStats(FILE* f) {
 
+    if (ui==nullptr) {return;}
+    fprintf(f,"ui wakeups=%lu input rings=%lu rig rings=%lu\n",ui->wakeups,inwake->rings.load(),rigwake->rings.load());
+    for (int k=0;k<UISOURCES;k++) {
+        if (uilat[k].count!=0) {uilat[k].print(f,UINAME[k]);}
+    }
+}
+//*--------------------------------------------------------------------------------------------------
+//* setupReactor  the main thread reactor and its sources; the signals it serves are blocked here,
+//* before any thread is created, so they are only taken from its signalfd
+//*--------------------------------------------------------------------------------------------------
+int setupReactor() {
+
+    sigemptyset(&uisig);
+    sigaddset(&uisig,SIGINT);
+    sigaddset(&uisig,SIGTERM);
+    sigaddset(&uisig,SIGHUP);
+    sigaddset(&uisig,SIGQUIT);
+    sigaddset(&uisig,SIGUSR1);
+    pthread_sigmask(SIG_BLOCK,&uisig,NULL);
+
+    ui=new EventLoop();
+    ui->TRACE=TRACE;
+    inwake=new Wakeup();
+    rigwake=new Wakeup();
+    sigfd=signalfd(-1,&uisig,SFD_NONBLOCK|SFD_CLOEXEC);
+    if (ui->efd<0 || inwake->fd<0 || rigwake->fd<0 || sigfd<0) {
+       (TRACE>=0x00 ? fprintf(stderr,"%s:setupReactor() error %d creating the reactor: %s\n",PROGRAMID,errno,strerror(errno)) : _NOP);
+       return -1;
+    }
+    ui->add(inwake->fd,EPOLLIN,onInput,NULL);
+    ui->add(rigwake->fd,EPOLLIN,onRig,NULL);
+    ui->add(sigfd,EPOLLIN,onSignal,NULL);
+    for (int k=0;k<UITIMERS;k++) {
+        uidue[k]=0;
+        uitfd[k]=timerfd_create(CLOCK_MONOTONIC,TFD_NONBLOCK|TFD_CLOEXEC);
+        if (uitfd[k]<0 || ui->add(uitfd[k],EPOLLIN,onTimer,(void*)(intptr_t)k)<0) {
+           (TRACE>=0x00 ? fprintf(stderr,"%s:setupReactor() error %d creating timer(%d): %s\n",PROGRAMID,errno,k,strerror(errno)) : _NOP);
+           return -1;
+        }
+    }
+    return 0;
+}
+#ifdef SIMULATOR
+//*-------------------------------------------------------------------------------------------------
+//* simStep  the reactor serves what the edges played last pass queued, then the time moves to the
+//* next pass playing the edges due; with a script it goes as fast as the GUI takes it and stops at
+//* its end, without one the step is slept on the reactor
+//*-------------------------------------------------------------------------------------------------
+void simStep() {
+
+struct timespec t0,t1;
+    clock_gettime(CLOCK_MONOTONIC,&t0);
+    ui->poll(0);
+    clock_gettime(CLOCK_MONOTONIC,&t1);
+    simgui.record((t1.tv_sec-t0.tv_sec)*1000000+(t1.tv_nsec-t0.tv_nsec)/1000);
+    simpass++;
+    simlcd->capture(simgpio->tick());
+
+    if (simscript[0]==0x00) {ui->poll(SIMSTEP/1000);}
+    simgpio->advance(SIMSTEP);
+    if (simscript[0]!=0x00 && simgpio->done()) {
+       (TRACE>=0x01 ? fprintf(stderr,"%s:simStep() end of script %s\n",PROGRAMID,simscript) : _NOP);
+       setWord(&MSW,RUN,false);
+    }
 }
+#endif
 //*-------------------------------------------------------------------------------------------------
 //* print_usage
 //* help message at program startup
@@ -315,6 +630,7 @@ void print_usage(void)
 fprintf(stderr,"\n%s version %s build (%s)\n"
 "Usage:\npicoFM  [-f frequency {144000000..147999999 Hz}]\n"
 "                [-o offset (+/-Hz) default=0)]\n"
+"                [-P priority channel watched {144000000..147999999 Hz}]\n"
 "                [-v volume (0..8 default=5)]\n"
 "                [-b backlight (0..60 default=0)]\n"
 "                [-w watchdog (0..90 default=0)]\n"
@@ -326,7 +642,18 @@ fprintf(stderr,"\n%s version %s build (%s)\n"
 "                [-s squelch(0..8 default=5)]\n"
 "                [-r Rx CTCSS (0..38 default=0)]\n"
 "                [-t Tx CTCSS (0..38 default=0)]\n"
-"                [-x Verbose {0..2} default=0}]\n",PROGRAMID,PROG_VERSION,PROG_BUILD);
+"                [-d DRA818V serial port[:ptt,pd,hl,sql GPIO] (default=/dev/ttyS0), repeat for more modules]\n"
+"                [-A knob acceleration 10x,100x detents/s (default=%d,%d, 0,0 off)]\n"
+"                [-K PA key-up,key-down delay ms (default=%d,%d)]\n"
+"                [-l squelch log file (default=%s, none to disable)]\n"
+#ifdef GPIOD
+"                [-g GPIO chip (default=" GPIODCHIP ")]\n"
+#endif
+#ifdef SIMULATOR
+"                [-S script of input edges, played at full speed]\n"
+"                [-F file to capture the LCD frames and output changes]\n"
+#endif
+"                [-x Verbose {0..2} default=0}]\n",PROGRAMID,PROG_VERSION,PROG_BUILD,ACCEL10,ACCEL100,TXKEYUP,TXKEYDOWN,SQLOG_FILE);
 
 }
 
@@ -348,7 +675,7 @@ int main(int argc, char* argv[])
 
 while(true)
         {
-                a = getopt(argc, argv, "o:s:r:t:x:v:b:w:f:hzp123?");
+                a = getopt(argc, argv, "o:s:r:t:x:v:b:w:f:d:P:l:A:K:" SIMOPTS GPIODOPTS "hzp123?");
 
                 if(a == -1) 
                 {
@@ -364,12 +691,46 @@ while(true)
                 {
 
                 case 'f': 
-	                f=atof(optarg);
-                        fprintf(stderr,"%s:main() args(frequency)=%5.0f\n",PROGRAMID,f);
+	                f=DRA818V::toHz(atof(optarg));
+                        fprintf(stderr,"%s:main() args(frequency)=%ld\n",PROGRAMID,f);
+                        break;
+                case 'P': 
+	                prio=DRA818V::toHz(atof(optarg));
+                        fprintf(stderr,"%s:main() args(priority)=%ld\n",PROGRAMID,prio);
+                        break;
+                case 'A':
+                        if (sscanf(optarg,"%d,%d",&accel10,&accel100)!=2) {
+                           fprintf(stderr,"%s:main() args(accel) must be 10x,100x detents/s\n",PROGRAMID);
+                           exit(1);
+                        }
+                        fprintf(stderr,"%s:main() args(accel)=%d,%d\n",PROGRAMID,accel10,accel100);
+                        break;
+                case 'K':
+                        if (sscanf(optarg,"%d,%d",&keyup,&keydown)!=2 || keyup<0 || keydown<0) {
+                           fprintf(stderr,"%s:main() args(key) must be key-up,key-down ms\n",PROGRAMID);
+                           exit(1);
+                        }
+                        fprintf(stderr,"%s:main() args(key)=%d,%d\n",PROGRAMID,keyup,keydown);
+                        break;
+#ifdef GPIOD
+                case 'g':
+                        strncpy(gpiochip,optarg,sizeof(gpiochip)-1);
+                        fprintf(stderr,"%s:main() args(chip)=%s\n",PROGRAMID,gpiochip);
                         break;
+#endif
+#ifdef SIMULATOR
+                case 'S':
+                        strncpy(simscript,optarg,sizeof(simscript)-1);
+                        fprintf(stderr,"%s:main() args(script)=%s\n",PROGRAMID,simscript);
+                        break;
+                case 'F':
+                        strncpy(simframes,optarg,sizeof(simframes)-1);
+                        fprintf(stderr,"%s:main() args(frames)=%s\n",PROGRAMID,simframes);
+                        break;
+#endif
                 case 'o': 
-	                ofs=atof(optarg);
-                        fprintf(stderr,"%s:main() args(offset)=%5.0f\n",PROGRAMID,ofs);
+	                ofs=DRA818V::toHz(atof(optarg));
+                        fprintf(stderr,"%s:main() args(offset)=%ld\n",PROGRAMID,ofs);
                         break;
                 case 'v':
                         vol=atoi(optarg);
@@ -415,6 +776,14 @@ while(true)
                         rx_ctcss=atof(optarg);
                         fprintf(stderr,"%s:main() args(Tx CTCSS)=%5.1f\n",PROGRAMID,rx_ctcss);
                         break;
+                case 'd':
+                        fprintf(stderr,"%s:main() args(port)=%s\n",PROGRAMID,optarg);
+                        if (addRig(optarg)<0) {exit(1);}
+                        break;
+                case 'l':
+                        strncpy(sqlfile,optarg,sizeof(sqlfile)-1);
+                        fprintf(stderr,"%s:main() args(squelch log)=%s\n",PROGRAMID,sqlfile);
+                        break;
                 case 'x':
                         TRACE=atoi(optarg);
                         fprintf(stderr,"%s:main() args(TRACE)=%d\n",PROGRAMID,TRACE);
@@ -431,11 +800,52 @@ while(true)
         }
 
 
+     if (nrig==0) {
+        char s[]="/dev/ttyS0";
+        addRig(s);
+     }
+
+//*--- Main thread reactor, ahead of any thread so the signals it takes are blocked on all of them
+
+    (TRACE>=0x01 ? fprintf(stderr,"%s:main() Reactor enabled\n",PROGRAMID) : _NOP);
+     if (setupReactor()<0) {exit(1);}
+
 //*--- Create memory resources
 
     (TRACE>=0x01 ? fprintf(stderr,"%s:main() Memory resources acquired\n",PROGRAMID) : _NOP);
      LCD_Buffer=(char*) malloc(32);
 
+//*--- Hardware backend of the GPIO lines and the LCD
+
+#ifndef SIMULATOR
+#ifdef GPIOD
+     gpiod=new GpiodGPIO(gpiochip);
+     gpiod->TRACE=TRACE;
+     hal=gpiod;
+#else
+     hal=new PiGPIO();
+#endif
+     lcd=new PiLCD();
+#else
+     simgpio=new SimGPIO();
+     simgpio->TRACE=TRACE;
+     simgpio->setEncoder(GPIO_CLK,GPIO_DT);
+     simlcd=new SimLCD();
+     hal=simgpio;
+     lcd=simlcd;
+     if (simframes[0]!=0x00) {
+        simout=fopen(simframes,"w");
+        if (simout==nullptr) {
+           fprintf(stderr,"%s:main() unable to create %s\n",PROGRAMID,simframes);
+           exit(1);
+        }
+        simlcd->out=simout;
+        simgpio->capture=simout;
+     }
+     if (simscript[0]!=0x00 && simgpio->load(simscript)<0) {exit(1);}
+#endif
+    (TRACE>=0x01 ? fprintf(stderr,"%s:main() GPIO backend(%s)\n",PROGRAMID,hal->name) : _NOP);
+
 //*--- Define and initialize LCD interface
 
     (TRACE>=0x01 ? fprintf(stderr,"%s:main() LCD sub-system initialized\n",PROGRAMID) : _NOP);
@@ -445,12 +855,7 @@ while(true)
      sprintf(LCD_Buffer,"%s","Booting..");
      lcd->println(0,1,LCD_Buffer);
 
-//*--- Establish master clock
-
-    (TRACE>=0x01 ? fprintf(stderr,"%s:main() Master timer enabled\n",PROGRAMID) : _NOP);
-     masterTimer=new CallBackTimer();
-     masterTimer->start(1,ISRHandler);
-     TVFO=500;
+     setTimer(UI_VFO,500);
 
     (TRACE>=0x01 ? fprintf(stderr,"%s:main() VFO sub-system initialized\n",PROGRAMID) : _NOP);
      vfo=new genVFO(changeFrequency,NULL,NULL,changeVfoHandler);
@@ -469,14 +874,51 @@ while(true)
      vfo->setPTT(false);
      vfo->setLock(false);
      vfo->setShift(ofs);
-     vfo->setVFOStep(VFOA,VFO_STEP_10KHz);
-     vfo->setVFOStep(VFOB,VFO_STEP_10KHz);
+     vfo->setVFOStep(VFOA,vfostep);
+     vfo->setVFOStep(VFOB,vfostep);
+
+//*--- Squelch openings log, opened before the interrupts that feed it are enabled
+
+    if (strcmp(sqlfile,"none")!=0) {
+       sqlog=new SQLog();
+       sqlog->TRACE=TRACE;
+       if (sqlog->open(sqlfile)<0) {
+          delete(sqlog);
+          sqlog=nullptr;
+       }
+    }
+
+//*--- Front panel events, queued before the callbacks that feed them are set
+
+    inq=new InputQueue();
+    inq->notify=inwake;
+    quad=new Quadrature();
+    accel=new EncoderAccel();
+    accel->setCurve(accel10,accel100);
+
+//*--- RSSI history, fixed size whatever the uptime
+
+    rssistore=new RSSIstore();
 
 //*--- Setup GPIO
 
     (TRACE>=0x01 ? fprintf(stderr,"%s:main() Setup GPIO sub-system\n",PROGRAMID) : _NOP);
      setupGPIO();
 
+//*--- TX sequencer, owns the PTT and PA lines from here on
+
+    txseq=new TXSequencer(halWrite,halTick);
+    txseq->TRACE=TRACE;
+    txseq->setDelay(keyup,keydown);
+    txseq->start(rig[0].ptt,GPIO_PA);
+
+
+//*---- setup serial I/O thread
+
+    (TRACE>=0x01 ? fprintf(stderr,"%s:main() Serial I/O thread enabled\n",PROGRAMID) : _NOP);
+    io=new EventLoop();
+    io->TRACE=TRACE;
+    io->start();
 
 //*---- setup  DRA818V
     (TRACE>=0x01 ? fprintf(stderr,"%s:main() Setup DRA818V chipset sub-system\n",PROGRAMID) : _NOP);
@@ -487,8 +929,6 @@ while(true)
     (TRACE>=0x01 ? fprintf(stderr,"%s:main() Display main panel\n",PROGRAMID) : _NOP);
     showPanel();
 
-    TRSSI=1000;
-
 char buf [100];
 
 //--------------------------------------------------------------------------------------------------
@@ -496,21 +936,15 @@ char buf [100];
 //--------------------------------------------------------------------------------------------------
      (TRACE>=0x00 ? fprintf(stderr,"%s:main() Starting operation\n",PROGRAMID) : _NOP);
      setWord(&MSW,RUN,true);
+     uiServe();              //First pass with the panel as it is at start
+#ifndef SIMULATOR
+     ui->run();              //Sleep until a source has work, served on this thread
+#else
      while(getWord(MSW,RUN)==true) {
-
-//*--- Read and process events coming from the CAT subsystem
-
-         d->processCommand();    //Process DRA818 responses
-         processGUI();           //Process GUI 
-         usleep(100000);         //Reduce the CPU load by doing it more slowly
-
+         simStep();          //Process GUI on the simulated panel
      }
-
-//*--- Turn off timer sub-system
-
- (TRACE>=0x00 ? fprintf(stderr,"%s:main() Stopping master timer sub-system\n",PROGRAMID) : _NOP);
-  masterTimer->stop();
-  delete(masterTimer);
+#endif
+     pthread_sigmask(SIG_UNBLOCK,&uisig,NULL);
 
 //*--- Turn off LCD
 
@@ -519,17 +953,72 @@ char buf [100];
   lcd->setCursor(0,0);
   lcd->clear();
   delete(lcd);
+  lcd=nullptr;
+#ifdef SIMULATOR
+  simlcd=nullptr;
+#endif
 
-//*--- Turn off gpio
+//*--- Unkey and turn off gpio
 
  (TRACE>=0x00 ? fprintf(stderr,"%s:main() Terminate GPIO sub-system\n",PROGRAMID) : _NOP);
-  gpioTerminate();
+  txseq->stop();
+  hal->terminate();
 
 //*--- Close serial port
 
  (TRACE>=0x00 ? fprintf(stderr,"%s:main() Stopping DRA818V sub-system\n",PROGRAMID) : _NOP);
-  d->stop();
-  delete(d);
+  io->stop();
+  writeStats(STATS_FILE);
+  writeRSSI(RSSI_FILE);
+  for (int i=0;i<nrig;i++) {
+      rig[i].d->stop();
+      delete(rig[i].d);
+  }
+  d=nullptr;
+  delete(io);
+
+//*--- Release the reactor, nothing rings it any longer
+
+  for (int k=0;k<UITIMERS;k++) {
+      close(uitfd[k]);
+  }
+  close(sigfd);
+  delete(ui);
+  ui=nullptr;
+  delete(inwake);
+  inwake=nullptr;
+  delete(rigwake);
+  rigwake=nullptr;
+
+//*--- Release the RSSI history and the input queue, both exported above
+
+  delete(rssistore);
+  rssistore=nullptr;
+ (TRACE>=0x01 ? fprintf(stderr,"%s:main() Input events drained(%lu) dropped(%lu)\n",PROGRAMID,inq->drained,inq->dropped()) : _NOP);
+  delete(inq);
+  inq=nullptr;
+  delete(accel);
+  accel=nullptr;
+  delete(quad);
+  quad=nullptr;
+  delete(txseq);
+  txseq=nullptr;
+  delete(hal);
+  hal=nullptr;
+#ifdef GPIOD
+  gpiod=nullptr;
+#endif
+#ifdef SIMULATOR
+  if (simout!=nullptr) {fclose(simout);}
+#endif
+
+//*--- Close the squelch log, after the GPIO so no edge is pushed while it closes
+
+  if (sqlog!=nullptr) {
+     (TRACE>=0x00 ? fprintf(stderr,"%s:main() Closing squelch log, %lu openings logged\n",PROGRAMID,sqlog->records) : _NOP);
+     delete(sqlog);
+     sqlog=nullptr;
+  }
 
  (TRACE>=0x00 ? fprintf(stderr,"%s:main() Stopping VFO sub-system\n",PROGRAMID) : _NOP);
   delete(vfo);
@@ -30,6 +30,21 @@
 #define CATBAUD 	4800
 #define CAT_PORT        "/tmp/ttyv0"
 #define PTT_FIFO       	"/tmp/ptt_fifo"
+#define STATS_FILE      "/tmp/picoFM.stats"
+#define SQLOG_FILE      "/home/pi/picoFM/picoFM.sql"
+#define RSSI_FILE       "/tmp/picoFM.rssi"
+#define HISTCOLS        16
+#define SIMSTEP     100000    // us of simulated time per pass of the GUI in the simulator
+
+//*--- Sources of work of the main thread reactor, the UI timeouts first (one timerfd each)
+
+#define UI_VFO          0     // blink of a frequency just changed ends
+#define UI_BACKLIGHT    1     // backlight goes off
+#define UI_WATCHDOG     2     // PTT held too long
+#define UITIMERS        3
+#define UI_INPUT        3     // front panel events queued by the GPIO callbacks
+#define UI_RIG          4     // DRA818V events queued by the I/O thread
+#define UISOURCES       5
 #define _NOP        	(byte)0
 
 #define INP_GPIO(g)   *(gpio.addr + ((g)/10)) &= ~(7<<(((g)%10)*3))
@@ -75,6 +90,12 @@
 #define GPIO_PD     19
 #define GPIO_SQL    20
 
+#define MAXRIG       8    // DRA818V modules driven by one process
+
+#define SCANLO   144000000    // Hz, band scanned with the VFO step
+#define SCANHI   147995000
+#define PRIOSLOT         1    // bank slot of the priority channel watched
+
 #define GPIO_PA     21
 #define GPIO_CLK    17    // pin 11
 #define GPIO_DT     18    // pin 12 
@@ -153,7 +174,6 @@ typedef void (*CALLBACK)();
 
 #define MINSWPUSH  10
 #define MAXSWPUSH  2000
-#define MINENCLAP   2
 
 #define BACKLIGHT  15000
 
@@ -0,0 +1,145 @@
+/*
+ * picoFMlog
+ * query of the squelch openings logged by picoFM
+ *---------------------------------------------------------------------
+ * Lists the openings of a squelch log overlapping a time window and
+ * within a frequency range. The log is mapped read only and binary
+ * searched by closing time, so only the pages holding the window are
+ * read no matter how many months the file spans.
+ *
+ *    ../bin/picoFMlog -s "2020-05-01 18:00" -e "2020-05-01 22:00" -l 146.0 -h 147.0
+ *---------------------------------------------------------------------
+ * Created by Pedro E. Colla (lu7did@gmail.com)
+ * ---------------------------------------------------------------------
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include "../picoFM/picoFM.h"
+#include "../lib/SQLog.h"
+
+//-------------------- GLOBAL VARIABLES ----------------------------
+const char   *PROGRAMID="picoFMlog";
+const char   *PROG_VERSION="1.0";
+const char   *PROG_BUILD="00";
+const char   *COPYRIGHT="(c) LU7DID 2019,2020";
+
+//*--------------------------------------------------------------------------------------------------
+//* parseTime  local date and time as "YYYY-MM-DD[ HH:MM[:SS]]" into us since the epoch, 0 if invalid
+//*--------------------------------------------------------------------------------------------------
+uint64_t parseTime(const char* s) {
+
+const char* FMT[]={"%Y-%m-%d %H:%M:%S","%Y-%m-%d %H:%M","%Y-%m-%d"};
+    for (int i=0;i<3;i++) {
+        struct tm tm;
+        memset(&tm,0,sizeof(tm));
+        const char* p=strptime(s,FMT[i],&tm);
+        if (p==NULL || *p!=0x00) continue;
+        tm.tm_isdst=-1;
+        time_t t=mktime(&tm);
+        if (t<0) return 0;
+        return (uint64_t)t*1000000;
+    }
+    return 0;
+}
+//*--------------------------------------------------------------------------------------------------
+//* print_usage
+//*--------------------------------------------------------------------------------------------------
+void print_usage() {
+
+fprintf(stderr,"\n%s version %s build (%s)\n"
+"Usage:\npicoFMlog [-f squelch log (default=%s)]\n"
+"          [-s from \"YYYY-MM-DD[ HH:MM[:SS]]\" (default=first opening)]\n"
+"          [-e to \"YYYY-MM-DD[ HH:MM[:SS]]\" (default=last opening)]\n"
+"          [-l lowest frequency MHz]\n"
+"          [-h highest frequency MHz]\n"
+"          [-c count only]\n",PROGRAMID,PROG_VERSION,PROG_BUILD,SQLOG_FILE);
+
+}
+//*--------------------------------------------------------------------------------------------------
+//* main
+//*--------------------------------------------------------------------------------------------------
+int main(int argc,char* argv[]) {
+
+const char* file=SQLOG_FILE;
+uint64_t from=0;
+uint64_t to=UINT64_MAX;
+long     lo=0;
+long     hi=LONG_MAX;
+bool     count=false;
+int      a;
+
+    while ((a=getopt(argc,argv,"f:s:e:l:h:c?"))!=-1) {
+       switch(a) {
+         case 'f': file=optarg; break;
+         case 's': from=parseTime(optarg);
+                   if (from==0) {fprintf(stderr,"%s: invalid time %s\n",PROGRAMID,optarg); exit(1);}
+                   break;
+         case 'e': to=parseTime(optarg);
+                   if (to==0) {fprintf(stderr,"%s: invalid time %s\n",PROGRAMID,optarg); exit(1);}
+                   break;
+         case 'l': lo=(long)(atof(optarg)*1000000.0+0.5); break;
+         case 'h': hi=(long)(atof(optarg)*1000000.0+0.5); break;
+         case 'c': count=true; break;
+         default:
+              print_usage();
+              exit(1);
+       }
+    }
+
+size_t len=0;
+SQLog_hdr* h=SQLog::map(file,&len);
+    if (h==nullptr) {
+       fprintf(stderr,"%s: %s is not a squelch log or cannot be read\n",PROGRAMID,file);
+       exit(1);
+    }
+
+//*--- Records are sorted by closing time; the first one that may overlap the window is found by
+//*--- binary search and the scan ends once closings are past the window by more than the longest
+//*--- opening ever logged, beyond that no opening can start inside it
+
+uint64_t n=__atomic_load_n(&h->count,__ATOMIC_ACQUIRE);
+uint64_t last=(to==UINT64_MAX ? UINT64_MAX : to+(uint64_t)h->maxms*1000);
+uint64_t read=0;
+unsigned long found=0;
+double   secs=0.0;
+
+    for (uint64_t i=SQLog::find(h,n,from);i<n;i++) {
+        SQLog_rec* r=SQLog::rec(h,i);
+        uint64_t close=r->t+(uint64_t)r->ms*1000;
+        if (close>last) break;
+        read++;
+        if (r->t>to || (long)r->f<lo || (long)r->f>hi) continue;
+        found++;
+        secs+=r->ms/1000.0;
+        if (count==true) continue;
+
+        time_t t=(time_t)(r->t/1000000);
+        struct tm tm;
+        localtime_r(&t,&tm);
+        char ts[32];
+        strftime(ts,sizeof(ts),"%Y-%m-%d %H:%M:%S",&tm);
+        printf("%s.%03u %4lu.%04lu MHz %8.1f s  peak %3d mean %3d (%u)  CTCSS rx %2d tx %2d  rig %d%s\n",
+               ts,(unsigned)((r->t/1000)%1000),(unsigned long)(r->f/1000000),(unsigned long)((r->f%1000000)/100),
+               r->ms/1000.0,r->peak,r->mean,r->n,r->rx,r->tx,r->rig,((r->flags & SQLTRUNC)!=0 ? " truncated" : ""));
+    }
+    printf("%lu openings %.1f s open, %llu of %llu records read\n",found,secs,(unsigned long long)read,(unsigned long long)n);
+
+    munmap(h,len);
+    exit(0);
+}